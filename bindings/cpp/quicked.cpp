@@ -37,6 +37,7 @@ namespace quicked {
         if (quicked_check_error(status)) {
             throw QuickedException(status);
         }
+        this->cpu_simd = this->aligner.simd;
     }
 
     QuickedAligner::~QuickedAligner()
@@ -62,6 +63,24 @@ namespace quicked {
         }
     }
 
+    void QuickedAligner::setMemoryBudget(uint64_t memory_budget) {
+        quicked_status_t status;
+
+        status = quicked_free(&this->aligner);
+        if (quicked_check_error(status)) {
+            throw QuickedException(status);
+        }
+        this->params.memory_budget = memory_budget;
+        status = quicked_new(&this->aligner, &this->params);
+        if (quicked_check_error(status)) {
+            throw QuickedException(status);
+        }
+    };
+    void QuickedAligner::setForceScalar(bool force_scalar) {
+        // The aligner picks its kernels once, in quicked_new
+        this->aligner.params->force_scalar = force_scalar;
+        this->aligner.simd = (force_scalar) ? QUICKED_SIMD_SCALAR : this->cpu_simd;
+    };
     void QuickedAligner::setHEWThreshold(unsigned int hew_threshold) {
         for (int i = 0; i < QUICKED_WINDOW_STAGES; i++) this->aligner.params->hew_threshold[i] = hew_threshold;
     };
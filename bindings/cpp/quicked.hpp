@@ -26,6 +26,8 @@
 #define QUICKED_HPP
 
 #include <string>
+#include <vector>
+#include <pthread.h> // Before the C header, which would otherwise include it inside the namespace
 
 namespace quicked {
 
@@ -53,19 +55,37 @@ namespace quicked {
 
         void setAlgorithm(quicked_algo_t algo)          { this->aligner.params->algo = algo; };
         void setOnlyScore(bool only_score)              { this->aligner.params->only_score = only_score; };
+        void setEndsFree(bool ends_free)                { this->aligner.params->ends_free = ends_free; };
+        void setCigarFormat(quicked_cigar_format_t cigar_format) { this->aligner.params->cigar_format = cigar_format; };
+        void setMaxScore(int max_score)                 { this->aligner.params->max_score = max_score; };
+        void setXDrop(int xdrop)                        { this->aligner.params->xdrop = xdrop; };
+        void setAnchorLength(unsigned int anchor_length) { this->aligner.params->anchor_length = anchor_length; };
         void setBandwidth(unsigned int bandwidth)       { this->aligner.params->bandwidth = bandwidth; };
         void setWindowSize(unsigned int window_size)    { this->aligner.params->window_size = window_size; };
         void setOverlapSize(unsigned int overlap_size)  { this->aligner.params->overlap_size = overlap_size; };
-        void setForceScalar(bool force_scalar)          { this->aligner.params->force_scalar = force_scalar; };
+        void setForceScalar(bool force_scalar);
+        void setNumThreads(unsigned int num_threads)    { this->aligner.params->num_threads = num_threads; };
+        // Re-creates the aligner (its allocator is sized from the budget), which resets getStatsTotal().
+        // The budget bounds the alignment matrices only, not the sequences, the CIGAR or the anchor index
+        void setMemoryBudget(uint64_t memory_budget);
         void setHEWThreshold(unsigned int hew_threshold);
         void setHEWPercentage(unsigned int hew_percentage);
 
         int getScore()          { return this->aligner.score; }
+        int getTextBegin()      { return this->aligner.text_begin; }
+        int getTextEnd()        { return this->aligner.text_end; }
+        int getPatternEnd()     { return this->aligner.pattern_end; }
         std::string getCigar()  { return std::string((this->aligner.cigar) ? this->aligner.cigar : "NULL"); }
+        std::vector<uint32_t> getCigarPacked() {
+            return std::vector<uint32_t>(this->aligner.cigar_packed, this->aligner.cigar_packed + this->aligner.cigar_packed_length);
+        }
+        const quicked_stats_t& getStats()                   { return this->aligner.stats; }
+        const quicked_stats_aggregate_t& getStatsTotal()    { return this->aligner.stats_total; }
 
     private:
         quicked_aligner_t aligner;
         quicked_params_t params;
+        quicked_simd_t cpu_simd; // Level picked by quicked_new, restored when force_scalar is cleared
     };
 }
 
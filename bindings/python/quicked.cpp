@@ -23,6 +23,7 @@
  */
 
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 #include "quicked.hpp"
 
 namespace py = pybind11;
@@ -35,14 +36,63 @@ namespace quicked {
             .def("align", &QuickedAligner::align)
             .def("setAlgorithm", &QuickedAligner::setAlgorithm)
             .def("setOnlyScore", &QuickedAligner::setOnlyScore)
+            .def("setEndsFree", &QuickedAligner::setEndsFree)
+            .def("setCigarFormat", &QuickedAligner::setCigarFormat)
+            .def("setMaxScore", &QuickedAligner::setMaxScore)
+            .def("setXDrop", &QuickedAligner::setXDrop)
+            .def("setAnchorLength", &QuickedAligner::setAnchorLength)
             .def("setBandwidth", &QuickedAligner::setBandwidth)
             .def("setWindowSize", &QuickedAligner::setWindowSize)
             .def("setOverlapSize", &QuickedAligner::setOverlapSize)
             .def("setForceScalar", &QuickedAligner::setForceScalar)
+            .def("setNumThreads", &QuickedAligner::setNumThreads)
+            .def("setMemoryBudget", &QuickedAligner::setMemoryBudget)
             .def("setHEWThreshold", &QuickedAligner::setHEWThreshold)
             .def("setHEWPercentage", &QuickedAligner::setHEWPercentage)
             .def("getScore", &QuickedAligner::getScore)
-            .def("getCigar", &QuickedAligner::getCigar);
+            .def("getTextBegin", &QuickedAligner::getTextBegin)
+            .def("getTextEnd", &QuickedAligner::getTextEnd)
+            .def("getPatternEnd", &QuickedAligner::getPatternEnd)
+            .def("getCigar", &QuickedAligner::getCigar)
+            .def("getCigarPacked", &QuickedAligner::getCigarPacked)
+            .def("getStats", &QuickedAligner::getStats)
+            .def("getStatsTotal", &QuickedAligner::getStatsTotal);
+
+        py::class_<quicked_stats_t>(m, "QuickedStats")
+            .def_readonly("bound_stage", &quicked_stats_t::bound_stage)
+            .def_property_readonly("high_error_windows", [](const quicked_stats_t &stats) {
+                return py::make_tuple(stats.high_error_windows[0], stats.high_error_windows[1]);
+            })
+            .def_readonly("band_doublings", &quicked_stats_t::band_doublings)
+            .def_readonly("final_cutoff", &quicked_stats_t::final_cutoff)
+            .def_readonly("hirschberg_depth", &quicked_stats_t::hirschberg_depth)
+            .def_readonly("anchors", &quicked_stats_t::anchors)
+            .def_readonly("cells", &quicked_stats_t::cells);
+
+        py::class_<quicked_stats_aggregate_t>(m, "QuickedStatsAggregate")
+            .def_readonly("alignments", &quicked_stats_aggregate_t::alignments)
+            .def_property_readonly("bound_stage", [](const quicked_stats_aggregate_t &stats) {
+                py::list counts;
+                for (int i = 0; i < QUICKED_STAGE_COUNT; i++) counts.append(stats.bound_stage[i]);
+                return counts;
+            })
+            .def_property_readonly("high_error_windows", [](const quicked_stats_aggregate_t &stats) {
+                return py::make_tuple(stats.high_error_windows[0], stats.high_error_windows[1]);
+            })
+            .def_readonly("band_doublings", &quicked_stats_aggregate_t::band_doublings)
+            .def_readonly("max_band_doublings", &quicked_stats_aggregate_t::max_band_doublings)
+            .def_readonly("max_final_cutoff", &quicked_stats_aggregate_t::max_final_cutoff)
+            .def_readonly("max_hirschberg_depth", &quicked_stats_aggregate_t::max_hirschberg_depth)
+            .def_readonly("anchored", &quicked_stats_aggregate_t::anchored)
+            .def_readonly("cells", &quicked_stats_aggregate_t::cells)
+            .def_readonly("max_cells", &quicked_stats_aggregate_t::max_cells);
+
+        py::enum_<quicked_stage_t>(m, "QuickedStage")
+            .value("QUICKED_STAGE_NONE", QUICKED_STAGE_NONE)
+            .value("QUICKED_STAGE_WINDOWED_S", QUICKED_STAGE_WINDOWED_S)
+            .value("QUICKED_STAGE_WINDOWED_L", QUICKED_STAGE_WINDOWED_L)
+            .value("QUICKED_STAGE_BANDED", QUICKED_STAGE_BANDED)
+            .export_values();
 
         py::enum_<quicked_algo_t>(m, "QuickedAlgo")
             .value("QUICKED", QUICKED)
@@ -51,12 +101,18 @@ namespace quicked {
             .value("HIRSCHBERG", HIRSCHBERG)
             .export_values();
 
+        py::enum_<quicked_cigar_format_t>(m, "QuickedCigarFormat")
+            .value("QUICKED_CIGAR_STRING", QUICKED_CIGAR_STRING)
+            .value("QUICKED_CIGAR_PACKED", QUICKED_CIGAR_PACKED)
+            .export_values();
+
         py::enum_<quicked_status_t>(m, "QuickedStatus")
             .value("QUICKED_OK", QUICKED_OK)
             .value("QUICKED_ERROR", QUICKED_ERROR)
             .value("QUICKED_FAIL_NON_CONVERGENCE", QUICKED_FAIL_NON_CONVERGENCE)
             .value("QUICKED_UNKNOWN_ALGO", QUICKED_UNKNOWN_ALGO)
             .value("QUICKED_EMPTY_SEQUENCE", QUICKED_EMPTY_SEQUENCE)
+            .value("QUICKED_ABOVE_MAX_SCORE", QUICKED_ABOVE_MAX_SCORE)
             .value("QUICKED_UNIMPLEMENTED", QUICKED_UNIMPLEMENTED)
             .value("QUICKED_WIP", QUICKED_WIP)
             .export_values();
@@ -0,0 +1,75 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <quicked.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SEQUENCE_LENGTH 20000
+
+int main(void) {
+    quicked_aligner_t aligner;                          // Aligner object
+    quicked_status_t status;                            // Return code from QuickEdit functions
+    quicked_params_t params = quicked_default_params(); // Get a set of sensible default parameters
+
+    params.algo = QUICKED;                              // Select the algorithm: QuickEd
+    params.anchor_length = 24;                          // Split at unique exact matches of 24 bases or more
+    params.num_threads = 4;                             // Align the segments between anchors on 4 threads
+
+    status = quicked_new(&aligner, &params);            // Initialize the aligner with the given parameters
+
+    // A long random sequence, and a copy of it with an edit every 100 bases
+    char* pattern = malloc(SEQUENCE_LENGTH + 1);
+    char* text = malloc(SEQUENCE_LENGTH + 1);
+    srand(42);
+    for (int i = 0; i < SEQUENCE_LENGTH; i++) {
+        pattern[i] = "ACGT"[rand() % 4];
+        text[i] = (i % 100 == 50) ? ((pattern[i] == 'A') ? 'C' : 'A') : pattern[i];
+    }
+    pattern[SEQUENCE_LENGTH] = text[SEQUENCE_LENGTH] = '\0';
+
+    // Align the sequences!
+    printf("Aligning two %d-base sequences using anchored QuickEd\n", SEQUENCE_LENGTH);
+
+    status = quicked_align(&aligner, pattern, SEQUENCE_LENGTH, text, SEQUENCE_LENGTH);
+    if (quicked_check_error(status)) {
+        fprintf(stderr, "%s", quicked_status_msg(status));
+        return 1;
+    }
+
+    printf("Score: %d\n", aligner.score);   // Print the score (one mismatch every 100 bases)
+    printf("DP cells computed: %lu\n", (unsigned long)aligner.stats.cells);
+
+    free(pattern);
+    free(text);
+
+    status = quicked_free(&aligner);        // Free whatever memory the aligner allocated
+    if (quicked_check_error(status)) {
+        fprintf(stderr, "%s", quicked_status_msg(status));
+        return 1;
+    }
+
+    return 0;
+}
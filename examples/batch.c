@@ -0,0 +1,66 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <quicked.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_PAIRS 4
+
+int main(void) {
+    quicked_params_t params = quicked_default_params(); // Get a set of sensible default parameters.
+
+    const char* patterns[NUM_PAIRS] = {"ACGT", "GATTACA", "AAAAAAAA", "ACGTACGTACGT"};
+    const char* texts[NUM_PAIRS]    = {"ACTT", "GATCACA", "AAAATAAA", "ACGTTACGTAGT"};
+    int pattern_lens[NUM_PAIRS], text_lens[NUM_PAIRS];
+    for (int i = 0; i < NUM_PAIRS; i++) {
+        pattern_lens[i] = strlen(patterns[i]);
+        text_lens[i] = strlen(texts[i]);
+    }
+
+    int scores[NUM_PAIRS];                              // One score per pair
+    char* cigars[NUM_PAIRS];                            // One CIGAR per pair, allocated by QuickEd
+    quicked_stats_aggregate_t stats;                    // Statistics merged from all the workers
+    quicked_stats_aggregate_reset(&stats);
+
+    // Align all pairs using 2 worker threads (0 would use all available CPUs)
+    quicked_status_t status = quicked_align_batch(&params, 2,
+                                                  patterns, pattern_lens,
+                                                  texts, text_lens,
+                                                  NUM_PAIRS, scores, cigars, &stats);
+    if (quicked_check_error(status)) {
+        fprintf(stderr, "%s", quicked_status_msg(status));
+        return 1;
+    }
+
+    for (int i = 0; i < NUM_PAIRS; i++) {
+        printf("'%s' vs '%s' -> Score: %d, CIGAR: %s\n", patterns[i], texts[i], scores[i], cigars[i]);
+        free(cigars[i]);                                // The caller owns the CIGAR strings
+    }
+    printf("%llu alignments, %llu DP cells computed\n",
+           (unsigned long long) stats.alignments, (unsigned long long) stats.cells);
+
+    return 0;
+}
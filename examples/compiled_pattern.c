@@ -0,0 +1,70 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <quicked.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NUM_TEXTS 3
+
+int main(void) {
+    quicked_aligner_t aligner;                          // Aligner object
+    quicked_pattern_t *compiled;                        // Compiled pattern handle
+    quicked_status_t status;                            // Return code from QuickEdit functions
+    quicked_params_t params = quicked_default_params(); // Get a set of sensible default parameters.
+
+    status = quicked_new(&aligner, &params);            // Initialize the aligner with the given parameters
+    if (quicked_check_error(status)) {
+        fprintf(stderr, "%s", quicked_status_msg(status));
+        return 1;
+    }
+
+    const char* pattern = "ACGTACGTAGCTAGCA";             // Pattern sequence, shared by all alignments
+    const char* texts[NUM_TEXTS] = {"ACGTTCGTAGCTAGCA", "ACGTACGAGCTAGCAT", "TTACGTACGTAGCTAGCA"};
+
+    // Compile the pattern once. The handle is read-only and could be shared among threads
+    status = quicked_pattern_compile(&aligner, &compiled, pattern, strlen(pattern));
+    if (quicked_check_error(status)) {
+        fprintf(stderr, "%s", quicked_status_msg(status));
+        return 1;
+    }
+
+    for (int i = 0; i < NUM_TEXTS; i++) {
+        status = quicked_align_compiled(&aligner, compiled, texts[i], strlen(texts[i]));
+        if (quicked_check_error(status)) {
+            fprintf(stderr, "%s", quicked_status_msg(status));
+            return 1;
+        }
+        printf("'%s' vs '%s' -> Score: %d, CIGAR: %s\n", pattern, texts[i], aligner.score, aligner.cigar);
+    }
+
+    quicked_pattern_free(compiled);         // Free the compiled pattern
+    status = quicked_free(&aligner);        // Free whatever memory the aligner allocated
+    if (quicked_check_error(status)) {
+        fprintf(stderr, "%s", quicked_status_msg(status));
+        return 1;
+    }
+
+    return 0;
+}
@@ -28,11 +28,14 @@
 #include "quicked_utils/include/commons.h"
 #include "quicked_utils/include/mm_allocator.h"
 #include "quicked_utils/include/cigar.h"
+#include "quicked_workspace.h"
+#include "quicked.h"
 
 typedef struct {
     /* BMP Pattern */
     const char *pattern;           // Raw pattern
-    uint64_t *PEQ;                // Pattern equalities (Bit vector for Myers-DP)
+    uint64_t *PEQ;                // Pattern equalities (Bit vector for Myers-DP), one aligned row per character
+    uint64_t PEQ_row_stride;      // Words between the rows of consecutive characters
     uint64_t pattern_length;      // Length
     uint64_t pattern_num_words64; // ceil(Length / |w|)
     uint64_t pattern_mod;         // Length % |w|
@@ -58,35 +61,85 @@ typedef struct {
     int *hi;
     uint64_t higher_block;
     uint64_t lower_block;
+    // Ends-free (semi-global): leading and trailing text gaps are free
+    bool ends_free;
+    int64_t text_begin;         // Aligned text span [text_begin, text_end), the whole text unless ends_free
+    int64_t text_end;
+    // Decision mode
+    int64_t early_exit_score;   // Stop as soon as the score is known to exceed it (-1 disables)
+    bool early_exit;            // Stopped early; cigar->score holds early_exit_score + 1
+    // Wavefront-parallel score-only pass
+    int num_threads;            // Threads sharing the band (1: serial); wide bands of long texts only
+    // Statistics
+    uint64_t cells;             // DP cells computed (whole 64-cell blocks)
     // CIGAR
     cigar_t *cigar;
+    bool packed_cigar;          // Backtrace into cigar->cigar_buffer (SAM run-length) instead of operations
 } banded_matrix_t;
 
+uint64_t banded_pattern_size(
+    const uint64_t pattern_length);
+
+void banded_pattern_init(
+    banded_pattern_t *const banded_pattern,
+    const char* pattern,
+    const uint64_t pattern_length,
+    const quicked_simd_t simd,
+    void *memory);
+
 void banded_pattern_compile(
     banded_pattern_t *const banded_pattern,
     const char* pattern,
     const uint64_t pattern_length,
+    const quicked_simd_t simd,
+    mm_allocator_t *const mm_allocator);
+
+void banded_pattern_compile_workspace(
+    banded_pattern_t *const banded_pattern,
+    const char* pattern,
+    const uint64_t pattern_length,
+    const quicked_simd_t simd,
+    workspace_pass_t *const pass,
     mm_allocator_t *const mm_allocator);
 
 void banded_pattern_free(
     banded_pattern_t *const banded_pattern,
     mm_allocator_t *const mm_allocator);
 
+// Bytes of the bit-encoded matrix (Pv and Mv) needed for a backtrace
+uint64_t banded_matrix_footprint(
+    const int64_t pattern_length,
+    const int64_t text_length,
+    const int64_t cutoff_score,
+    const bool ends_free);
+
 void banded_matrix_allocate(
     banded_matrix_t *const banded_matrix,
     const int64_t pattern_length,
     const int64_t text_length,
     const int64_t cutoff_score,
     bool only_score,
+    bool ends_free,
+    mm_allocator_t *const mm_allocator);
+
+void banded_matrix_allocate_workspace(
+    banded_matrix_t *const banded_matrix,
+    const int64_t pattern_length,
+    const int64_t text_length,
+    const int64_t cutoff_score,
+    bool only_score,
+    bool ends_free,
+    workspace_pass_t *const pass,
     mm_allocator_t *const mm_allocator);
 
 void banded_matrix_free(
     banded_matrix_t *const banded_matrix,
     mm_allocator_t *const mm_allocator);
 
+// Patterns and texts are encoded (quicked_encode.h)
 void banded_compute(
     banded_matrix_t *const banded_matrix,
-    banded_pattern_t *const banded_pattern,
+    const banded_pattern_t *const banded_pattern,
     const char* text,
     const int64_t text_length,
     const int64_t text_finish_pos,
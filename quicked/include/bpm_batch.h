@@ -0,0 +1,52 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BPM_BATCH_H_
+#define BPM_BATCH_H_
+
+#include "quicked_utils/include/commons.h"
+#include "quicked.h"
+
+// Inter-sequence kernels: each SIMD lane aligns its own pair over the whole DP matrix
+#define BPM_BATCH_MAX_LANES 8
+#define BPM_BATCH_MAX_BLOCKS 8   // Sequences up to 512 bases
+
+uint64_t bpm_batch_lanes(
+    const quicked_simd_t simd); // 0 if there is no batch kernel for simd
+
+bool bpm_batch_fits(
+    const int pattern_length,
+    const int text_length);
+
+// Edit distance of num_pairs (<= bpm_batch_lanes(simd)) pairs that fit
+void bpm_batch_compute_score(
+    const char **patterns,
+    const int *pattern_lengths,
+    const char **texts,
+    const int *text_lengths,
+    const uint64_t num_pairs,
+    int64_t *scores,
+    const quicked_simd_t simd);
+
+#endif /* BPM_BATCH_H_ */
@@ -25,6 +25,9 @@
 #ifndef BPM_COMMON_H_
 #define BPM_COMMON_H_
 
+#include "quicked_utils/include/cigar.h"
+#include "quicked.h"
+
 /*
  * Constants
  */
@@ -41,6 +44,31 @@
 #define BPM_PATTERN_PEQ_IDX(word_pos, encoded_character) (((word_pos) * BPM_ALPHABET_LENGTH) + (encoded_character))
 #define BPM_PATTERN_BDP_IDX(position, num_words, word_pos) ((position) * (num_words) + (word_pos))
 
+/*
+ * Per-character PEQ layout: one row of consecutive blocks per character, each row
+ * starting on a 64-byte boundary, so consecutive blocks are a single vector load
+ */
+#define BPM_PEQ_ALIGNMENT 64
+#define BPM_PATTERN_PEQ_ROW_STRIDE(num_words) (DIV_CEIL((num_words), BPM_PEQ_ALIGNMENT / BPM_W64_SIZE) * (BPM_PEQ_ALIGNMENT / BPM_W64_SIZE))
+#define BPM_PATTERN_PEQ_ROW_IDX(word_pos, encoded_character, row_stride) ((encoded_character) * (row_stride) + (word_pos))
+
+/*
+ * Pattern equalities of an encoded pattern (DIV_CEIL(pattern_length,64) blocks),
+ * shared by all the pattern types. The padding of the last block matches any character.
+ * simd caps the vector extension used (the aligner's level, see force_scalar)
+ */
+void bpm_pattern_compile_peq(
+    uint64_t *const PEQ,
+    const char* pattern,
+    const uint64_t pattern_length,
+    const quicked_simd_t simd);
+void bpm_pattern_compile_peq_rows(
+    uint64_t *const PEQ,
+    const uint64_t row_stride,
+    const char* pattern,
+    const uint64_t pattern_length,
+    const quicked_simd_t simd);
+
 /*
  * Advance block functions (Improved)
  *   const @vector Eq,mask;
@@ -149,4 +177,47 @@
       	    Pv2    = _mm256_or_si256(Mh2, ~Pv2);                                           \
             Mv2    = _mm256_and_si256(Ph2, Xv2);                                           \
 
+/*
+ * AVX-512 advance block: the horizontal carries (PHin,MHin,PHout,MHout) live in
+ * mask registers (one bit per lane) and the boolean chains use ternary logic.
+ * ones holds 1 in every lane.
+ */
+#define BPM_ADVANCE_BLOCK_SI512(Eq, mask, ones, Pv, Mv, PHin, MHin, PHout, MHout)          \
+    __m512i Xv    = _mm512_or_si512(Eq, Mv);                 /*Eq | Mv*/                  \
+    __m512i _Eq   = _mm512_mask_or_epi64(Eq, MHin, Eq, ones); /*Eq | MHin*/               \
+    __m512i Xh    = _mm512_and_si512(_Eq, Pv);               /*(((_Eq & Pv) + Pv) ^ Pv) | _Eq*/ \
+            Xh    = _mm512_add_epi64(Xh, Pv);                                             \
+            Xh    = _mm512_ternarylogic_epi64(Xh, Pv, _Eq, 0xBE);                         \
+    __m512i Ph    = _mm512_ternarylogic_epi64(Mv, Xh, Pv, 0xF1); /*Mv | ~(Xh | Pv)*/      \
+    __m512i Mh    = _mm512_and_si512(Pv, Xh);                /*Pv & Xh*/                  \
+            PHout = _mm512_test_epi64_mask(Ph, mask);        /*(Ph & mask) != 0*/         \
+            MHout = _mm512_test_epi64_mask(Mh, mask);        /*(Mh & mask) != 0*/         \
+            Ph    = _mm512_slli_epi64(Ph, 1);                /*Ph <<= 1*/                 \
+            Mh    = _mm512_slli_epi64(Mh, 1);                /*Mh <<= 1*/                 \
+            Ph    = _mm512_mask_or_epi64(Ph, PHin, Ph, ones); /*Ph |= PHin*/              \
+            Mh    = _mm512_mask_or_epi64(Mh, MHin, Mh, ones); /*Mh |= MHin*/              \
+            Pv    = _mm512_ternarylogic_epi64(Mh, Xv, Ph, 0xF1); /*Mh | ~(Xv | Ph)*/      \
+            Mv    = _mm512_and_si512(Ph, Xv);                                             \
+
+/*
+ * Backtrace output: each operation goes either to the operations buffer (written
+ * backwards from op_sentinel) or straight into the run-length SAM CIGAR
+ */
+static inline __attribute__((always_inline)) void bpm_backtrace_push(
+    cigar_t *const cigar,
+    int *const op_sentinel,
+    const bool packed,
+    const char operation,
+    const uint32_t sam_operation)
+{
+    if (packed)
+    {
+        cigar_prepend_SAM_operation(cigar, sam_operation);
+    }
+    else
+    {
+        cigar->operations[(*op_sentinel)--] = operation;
+    }
+}
+
 #endif /* BPM_COMMON_H_ */
\ No newline at end of file
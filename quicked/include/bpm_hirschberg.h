@@ -27,6 +27,25 @@
 
 #include "quicked_utils/include/mm_allocator.h"
 #include "quicked_utils/include/cigar.h"
+#include "quicked_workspace.h"
+#include "bpm_banded.h"
+
+// Subproblems with a smaller footprint are solved serially inside a single task
+#define BPM_HIRSCHBERG_TASK_FOOTPRINT BUFFER_SIZE_64M
+// Smallest leaf footprint (full banded matrix) honoured; below it the recursion gets too deep to pay off
+#define BPM_HIRSCHBERG_MIN_LEAF_FOOTPRINT BUFFER_SIZE_256K
+
+typedef struct {
+    uint64_t max_depth; // Deepest recursion level (0 when solved without dividing)
+    uint64_t cells;     // DP cells computed by all the banded passes
+} hirschberg_stats_t;
+
+// Streamed traceback: the operations of each leaf go to the callback, in alignment order
+typedef struct {
+    quicked_cigar_callback_t callback; // Optional (NULL), only the score is kept
+    void *user_data;
+    int64_t score;                     // Accumulated over the leaves
+} hirschberg_stream_t;
 
 quicked_status_t bpm_compute_matrix_hirschberg(
     const char* text,
@@ -36,8 +55,30 @@ quicked_status_t bpm_compute_matrix_hirschberg(
     const char* pattern_r,
     const int64_t pattern_length,
     const int64_t cutoff_score,
+    const uint64_t leaf_footprint,                    // Subproblems whose full matrix is larger are divided
+    cigar_t* cigar_out,
+    const bool force_scalar,
+    const banded_pattern_t* const compiled_pattern,   // Optional (NULL), precompiled full pattern
+    const banded_pattern_t* const compiled_pattern_r, // Optional (NULL), precompiled reversed pattern
+    quicked_workspace_t* const workspace,
+    hirschberg_stream_t* const stream,                // Optional (NULL), stream instead of filling cigar_out
+    hirschberg_stats_t* const stats);                 // Accumulated into, not reset
+
+quicked_status_t bpm_compute_matrix_hirschberg_parallel(
+    const char* text,
+    const char* text_r,
+    const int64_t text_length,
+    const char* pattern,
+    const char* pattern_r,
+    const int64_t pattern_length,
+    const int64_t cutoff_score,
+    const uint64_t leaf_footprint,                    // Subproblems whose full matrix is larger are divided
     cigar_t* cigar_out,
     const bool force_scalar,
-    mm_allocator_t* const mm_allocator);
+    const banded_pattern_t* const compiled_pattern,
+    const banded_pattern_t* const compiled_pattern_r,
+    quicked_workspace_pool_t* const pool,
+    const int num_threads,
+    hirschberg_stats_t* const stats);
 
 #endif /* BPM_HIRSCHBERG_H_ */
@@ -28,6 +28,8 @@
 #include "quicked_utils/include/commons.h"
 #include "quicked_utils/include/mm_allocator.h"
 #include "quicked_utils/include/cigar.h"
+#include "quicked_workspace.h"
+#include "quicked.h"
 
 typedef struct
 {
@@ -59,18 +61,47 @@ typedef struct
     int64_t pos_v;
     int64_t pos_h;
     int64_t high_error_window;
+    uint64_t cells;               // DP cells computed by all the windows
+    // Ends-free (semi-global): leading and trailing text gaps are free
+    bool ends_free;
+    bool locating_end;            // Windows still sliding to the cheapest cell of the last pattern row
+    int64_t text_begin;           // Aligned text span [text_begin, text_end), the whole text unless ends_free
+    int64_t text_end;
     // CIGAR
     cigar_t *cigar;
-    uint64_t *PEQ_window;
+    bool packed_cigar;            // Backtrace into cigar->cigar_buffer (SAM run-length) instead of operations
+    // Window
+    uint64_t *PEQ_window;         // Pattern equalities of the window blocks
+    int64_t PEQ_window_pos_v;     // First pattern position of PEQ_window (-1 if not built)
+    int64_t PEQ_window_blocks;    // Blocks in PEQ_window
+    uint64_t *PH_carry;           // Horizontal carries between groups of blocks (SIMD kernels)
+    uint64_t *MH_carry;
+    uint8_t *text_window;         // Encoded window text, reversed (SIMD kernels)
 } windowed_matrix_t;
 
 /*
  * Setup
  */
+uint64_t windowed_pattern_size(
+    const uint64_t pattern_length);
+void windowed_pattern_init(
+    windowed_pattern_t *const windowed_pattern,
+    const char* pattern,
+    const uint64_t pattern_length,
+    const quicked_simd_t simd,
+    void *memory);
 void windowed_pattern_compile(
     windowed_pattern_t *const windowed_pattern,
     const char* pattern,
     const uint64_t pattern_length,
+    const quicked_simd_t simd,
+    mm_allocator_t *const mm_allocator);
+void windowed_pattern_compile_workspace(
+    windowed_pattern_t *const windowed_pattern,
+    const char* pattern,
+    const uint64_t pattern_length,
+    const quicked_simd_t simd,
+    workspace_pass_t *const pass,
     mm_allocator_t *const mm_allocator);
 void windowed_pattern_free(
     windowed_pattern_t *const windowed_pattern,
@@ -82,16 +113,24 @@ void windowed_matrix_allocate(
     const uint64_t text_length,
     mm_allocator_t *const mm_allocator,
     const int window_size);
+void windowed_matrix_allocate_workspace(
+    windowed_matrix_t *const windowed_matrix,
+    const uint64_t pattern_length,
+    const uint64_t text_length,
+    const int window_size,
+    const bool score_only,
+    workspace_pass_t *const pass,
+    mm_allocator_t *const mm_allocator);
 void windowed_matrix_free(
     windowed_matrix_t *const windowed_matrix,
     mm_allocator_t *const mm_allocator);
 
 /*
- * Edit distance computation using BPM
+ * Edit distance computation using BPM (encoded pattern and text, see quicked_encode.h)
  */
 void windowed_compute(
     windowed_matrix_t *const windowed_matrix,
-    windowed_pattern_t *const windowed_pattern,
+    const windowed_pattern_t *const windowed_pattern,
     const char* text,
     const int hew_threshold,
     const int window_size,
@@ -0,0 +1,57 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BPM_XDROP_H_
+#define BPM_XDROP_H_
+
+#include "quicked_utils/include/commons.h"
+#include "quicked_utils/include/mm_allocator.h"
+#include "quicked_utils/include/cigar.h"
+#include "quicked_workspace.h"
+#include "bpm_banded.h"
+
+/*
+ * X-drop extension: the alignment starts at the beginning of both sequences and
+ * ends wherever the extension score is best. Each cell (v,h) scores
+ * v + h - 5 * D(v,h), i.e. +2 per match, -3 per mismatch and -4 per gap, so
+ * unrelated sequences (about one edit every two bases) score downwards. The
+ * extension stops once every cell of a text column is more than xdrop below
+ * the best one seen.
+ */
+#define BPM_XDROP_DISTANCE_WEIGHT 5
+#define BPM_XDROP_SCORE(v, h, distance) ((v) + (h) - BPM_XDROP_DISTANCE_WEIGHT * (distance))
+
+// Sets cigar->end_v, cigar->end_h (characters extended) and cigar->score (their edit distance).
+// The edit distance is an upper bound (the band only follows the cells within xdrop). Encoded sequences.
+void bpm_compute_xdrop(
+    const banded_pattern_t *const banded_pattern,
+    const char* text,
+    const int64_t text_length,
+    const int64_t xdrop,
+    cigar_t *const cigar,
+    workspace_pass_t *const pass,
+    mm_allocator_t *const mm_allocator,
+    uint64_t *const cells);
+
+#endif /* BPM_XDROP_H_ */
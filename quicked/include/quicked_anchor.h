@@ -0,0 +1,76 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef QUICKED_ANCHOR_H_
+#define QUICKED_ANCHOR_H_
+
+#include "quicked_utils/include/commons.h"
+#include "quicked_utils/include/cigar.h"
+#include "quicked.h"
+
+/*
+ * Anchors: exact matches of at least anchor_length bases, seeded by k-mers (32
+ * bases at most) that occur once in each sequence, and chained so that both
+ * their pattern and text positions increase. The alignment is then split at
+ * the anchors into independent segments, which are aligned concurrently. The
+ * result is optimal whenever an optimal alignment goes through the anchors,
+ * and an upper bound otherwise.
+ */
+#define QUICKED_ANCHOR_MAX_KMER     32
+#define QUICKED_ANCHOR_MIN_SPACING  1024 // Pattern bases between two anchors (fewer calls, still cache-resident)
+
+typedef struct {
+    int pattern_pos;
+    int text_pos;
+    int length;
+} quicked_anchor_t;
+
+// Returns the number of anchors found, in increasing positions (*anchors is taken from mm_allocator,
+// NULL if none). The k-mer index takes about 32 bytes per text base. Encoded sequences.
+int quicked_anchor_find(
+    const char* pattern,
+    const int pattern_length,
+    const char* text,
+    const int text_length,
+    const int anchor_length,
+    mm_allocator_t *const mm_allocator,
+    quicked_anchor_t **anchors);
+
+// Aligns the segments between the anchors on params->num_threads threads, each one with its own aligner
+// configured like params. The operations (pattern_length + text_length bytes, unless only_score) and the
+// total score are written to cigar; the segment statistics are added to stats. The calling thread's
+// bookkeeping comes from mm_allocator. Encoded sequences.
+quicked_status_t quicked_anchor_align(
+    const quicked_params_t *params,
+    mm_allocator_t *const mm_allocator,
+    const char* pattern,
+    const int pattern_length,
+    const char* text,
+    const int text_length,
+    const quicked_anchor_t *anchors,
+    const int num_anchors,
+    cigar_t *const cigar,
+    quicked_stats_t *const stats);
+
+#endif /* QUICKED_ANCHOR_H_ */
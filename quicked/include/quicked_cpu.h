@@ -0,0 +1,46 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef QUICKED_CPU_H_
+#define QUICKED_CPU_H_
+
+#include "quicked.h"
+
+/*
+ * SIMD kernels are compiled for x86 with per-function target attributes, so the
+ * library runs on any x86-64 CPU and picks the widest supported kernel at run time.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(QUICKED_FORCESCALAR)
+#define QUICKED_SIMD_X86
+#define QUICKED_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// Best SIMD extension supported by the running CPU (detected once, then cached)
+quicked_simd_t quicked_cpu_simd(void);
+
+// Size in bytes of the level 2 or 3 data cache of the running CPU, 0 if unknown (detected once, then cached)
+uint64_t quicked_cpu_cache_size(
+    const int level);
+
+#endif /* QUICKED_CPU_H_ */
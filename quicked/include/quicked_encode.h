@@ -0,0 +1,62 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef QUICKED_ENCODE_H_
+#define QUICKED_ENCODE_H_
+
+#include "quicked_utils/include/commons.h"
+#include "quicked.h"
+
+/*
+ * Sequences are encoded once per alignment (A=0 C=1 G=2 T=3, 4 otherwise),
+ * so the kernels index the PEQ tables with the sequence bytes directly
+ */
+void quicked_encode_ascii(
+    const char *sequence,
+    const uint64_t length,
+    uint8_t *const encoded,
+    const quicked_simd_t simd);
+
+// Base i in bits 2*(i%32) of packed[i/32]; bit i%64 of n_mask[i/64] (optional) marks it as N
+void quicked_encode_packed(
+    const uint64_t *packed,
+    const uint64_t *n_mask,
+    const uint64_t length,
+    uint8_t *const encoded);
+
+// Length of the common prefix of a and b, comparing up to length bytes
+uint64_t quicked_common_prefix(
+    const uint8_t *const a,
+    const uint8_t *const b,
+    const uint64_t length,
+    const quicked_simd_t simd);
+
+// Length of the common suffix of the sequences ending at a_end and b_end, comparing up to length bytes
+uint64_t quicked_common_suffix(
+    const uint8_t *const a_end,
+    const uint8_t *const b_end,
+    const uint64_t length,
+    const quicked_simd_t simd);
+
+#endif /* QUICKED_ENCODE_H_ */
@@ -0,0 +1,62 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef QUICKED_HAMMING_H_
+#define QUICKED_HAMMING_H_
+
+#include "quicked_utils/include/commons.h"
+#include "quicked.h"
+
+/*
+ * Equal-length pairs: the Hamming alignment (matches and mismatches only) costs
+ * its mismatches, and is optimal unless an alignment with indels is cheaper.
+ * Indels come in pairs between sequences of the same length, and a pair that
+ * shifts s diagonals costs at least 2*s, so the check only follows the few
+ * diagonals such an alignment could take (Landau-Vishkin).
+ */
+#define QUICKED_HAMMING_MAX_DISTANCE 64 // More mismatches: the pair is left to the QuickEd stages
+
+// Mismatches between two sequences of the same length. Encoded sequences
+uint64_t quicked_hamming_distance(
+    const uint8_t *const pattern,
+    const uint8_t *const text,
+    const uint64_t length,
+    const quicked_simd_t simd);
+
+// True if an alignment with indels costs less than hamming_distance (at most
+// QUICKED_HAMMING_MAX_DISTANCE). Encoded sequences
+bool quicked_hamming_indels_cheaper(
+    const uint8_t *const pattern,
+    const uint8_t *const text,
+    const int64_t length,
+    const int64_t hamming_distance);
+
+// Writes the operations of the Hamming alignment ('M' or 'X' for each position)
+void quicked_hamming_operations(
+    const uint8_t *const pattern,
+    const uint8_t *const text,
+    const uint64_t length,
+    char *const operations);
+
+#endif /* QUICKED_HAMMING_H_ */
@@ -0,0 +1,49 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef QUICKED_PATTERN_H_
+#define QUICKED_PATTERN_H_
+
+#include "quicked_utils/include/commons.h"
+#include "bpm_banded.h"
+#include "bpm_windowed.h"
+
+/*
+ * Compiled pattern. Read-only once built, so it can be shared by several
+ * aligners (and threads) aligning the same pattern against different texts.
+ */
+struct quicked_pattern_t {
+    char *pattern;                  // Owned copy of the pattern (encoded)
+    char *pattern_r;                // Reversed pattern (encoded)
+    uint64_t pattern_length;
+    // Forward patterns
+    banded_pattern_t banded;
+    windowed_pattern_t windowed;
+    // Reverse patterns (reverse windowed pass and Hirschberg)
+    banded_pattern_t banded_r;
+    windowed_pattern_t windowed_r;
+    void *memory;                   // Single block holding all the above
+};
+
+#endif /* QUICKED_PATTERN_H_ */
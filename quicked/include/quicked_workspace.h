@@ -0,0 +1,129 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef QUICKED_WORKSPACE_H_
+#define QUICKED_WORKSPACE_H_
+
+#include "quicked_utils/include/commons.h"
+#include "quicked_utils/include/mm_allocator.h"
+#include "quicked_utils/include/cigar.h"
+#include <pthread.h>
+
+/*
+ * Grow-only buffer. Memory is only released when the workspace is deleted.
+ */
+typedef struct {
+    void *memory;
+    uint64_t size;
+} workspace_buffer_t;
+
+/*
+ * Buffers used by one pass (forward or reverse) of a windowed/banded stage
+ */
+typedef struct {
+    workspace_buffer_t pattern;     // Compiled pattern (PEQ and auxiliary vectors)
+    workspace_buffer_t Pv;
+    workspace_buffer_t Mv;
+    workspace_buffer_t scores;
+    workspace_buffer_t PEQ_window;
+    workspace_buffer_t operations;  // CIGAR operations
+    cigar_t cigar;
+} workspace_pass_t;
+
+/*
+ * Per-aligner workspace, reused across the QuickEd stages and across alignments
+ */
+typedef struct quicked_workspace_t {
+    mm_allocator_t *mm_allocator;
+    // Passes
+    workspace_pass_t forward;
+    workspace_pass_t reverse;
+    // Encoded sequences
+    workspace_buffer_t text_enc;
+    workspace_buffer_t pattern_enc;
+    // Reversed sequences
+    workspace_buffer_t text_r;
+    workspace_buffer_t pattern_r;
+    // Hirschberg middle column
+    workspace_buffer_t cell_score;
+    workspace_buffer_t cell_score_r;
+    // Results
+    workspace_buffer_t operations;  // Alignment operations
+    workspace_buffer_t cigar;       // Printed CIGAR
+    workspace_buffer_t cigar_packed; // SAM run-length CIGAR
+    // Streaming
+    int pending_prefix;             // Trimmed matches streamed ahead of the first core operations
+} quicked_workspace_t;
+
+// Idle segments kept by the allocator pool a workspace pool creates for itself
+#define QUICKED_WORKSPACE_POOL_IDLE_SEGMENTS 8
+
+/*
+ * Pool of workspaces for concurrent tasks. Each pooled workspace owns its
+ * mm_allocator, so a task never shares an allocator with another one; the
+ * allocators take their segments from a shared (thread-safe) allocator pool.
+ */
+typedef struct quicked_workspace_pool_t {
+    quicked_workspace_t **idle;     // Workspaces not in use
+    int num_idle;
+    int max_idle;
+    mm_allocator_pool_t *allocator_pool;  // Segments of the workspace allocators
+    bool owns_allocator_pool;
+    pthread_mutex_t mutex;
+} quicked_workspace_pool_t;
+
+/*
+ * Setup
+ */
+quicked_workspace_t* quicked_workspace_new(
+    mm_allocator_t *const mm_allocator);
+void quicked_workspace_delete(
+    quicked_workspace_t *const workspace);
+
+quicked_workspace_pool_t* quicked_workspace_pool_new(
+    const uint64_t segment_size,
+    mm_allocator_pool_t *const allocator_pool); // Optional (NULL), otherwise one of segment_size is created
+void quicked_workspace_pool_delete(
+    quicked_workspace_pool_t *const pool);
+
+/*
+ * Accessors
+ */
+uint64_t quicked_workspace_segment_size(
+    const uint64_t memory_budget,
+    const uint64_t default_size);
+
+void* workspace_buffer_reserve(
+    workspace_buffer_t *const buffer,
+    const uint64_t size,
+    const bool huge_pages,
+    mm_allocator_t *const mm_allocator);
+
+quicked_workspace_t* quicked_workspace_pool_acquire(
+    quicked_workspace_pool_t *const pool);
+void quicked_workspace_pool_release(
+    quicked_workspace_pool_t *const pool,
+    quicked_workspace_t *const workspace);
+
+#endif /* QUICKED_WORKSPACE_H_ */
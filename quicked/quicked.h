@@ -28,6 +28,7 @@
 #include <quicked_utils/include/mm_allocator.h>
 #include <quicked_utils/include/profiler_timer.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #define QUICKED_WINDOW_STAGES 2 // Number of window sizes to go through before doing banded
 #define QUICKED_FAST_WINDOW_SIZE 2
@@ -40,6 +41,24 @@ typedef enum {
     HIRSCHBERG,
 } quicked_algo_t;
 
+// SIMD extensions, from narrowest to widest
+typedef enum {
+    QUICKED_SIMD_SCALAR,
+    QUICKED_SIMD_SSE41,
+    QUICKED_SIMD_AVX2,
+    QUICKED_SIMD_AVX512,
+} quicked_simd_t;
+
+// Output of the alignment operations (unless only_score)
+typedef enum {
+    QUICKED_CIGAR_STRING,   // aligner->cigar: run-length string of M/X/I/D operations ("10M1X2I")
+    QUICKED_CIGAR_PACKED,   // aligner->cigar_packed: SAM run-lengths (length << 4 | op), no string
+} quicked_cigar_format_t;
+
+// Receives the alignment operations ('M', 'X', 'I', 'D') in order, in consecutive segments.
+// The operations are only valid during the call.
+typedef void (*quicked_cigar_callback_t)(const char* operations, int num_operations, void* user_data);
+
 typedef struct quicked_params_t {
     quicked_algo_t algo;
     unsigned int bandwidth;
@@ -48,16 +67,86 @@ typedef struct quicked_params_t {
     unsigned int hew_threshold[QUICKED_WINDOW_STAGES];
     unsigned int hew_percentage[QUICKED_WINDOW_STAGES];
     bool only_score;
+    bool ends_free;     // Semi-global: leading/trailing gaps in the text are free (see text_begin/text_end)
+    quicked_cigar_format_t cigar_format;
+    quicked_cigar_callback_t cigar_callback;    // Optional (NULL), streams the operations instead of cigar_format
+    void *cigar_callback_data;                  // Passed to cigar_callback
+    int max_score;      // Decision mode: only tell whether the distance is <= max_score (-1 disables)
+    int xdrop;          // X-drop extension from the start of both sequences (-1 disables, see pattern_end/text_end)
+    unsigned int anchor_length; // Split at unique exact matches at least this long, aligning the parts concurrently (0 disables).
+                                // Not exact: if no optimal alignment goes through the anchors, the score is an upper bound,
+                                // typically a few edits above the distance. See stats.anchors
     bool force_scalar;
+    unsigned int num_threads;   // Threads used within a single alignment (1 = serial)
+    uint64_t memory_budget;     // Bytes for the alignment matrices of an aligner (0: sized to the CPU caches)
     bool external_timer;
     mm_allocator_t *external_allocator;
+    mm_allocator_pool_t *allocator_pool;    // Optional (NULL), segments shared by the aligners of several threads
 } quicked_params_t;
 
+// Stage of the QuickEd cascade whose score bounded the final traceback
+typedef enum {
+    QUICKED_STAGE_NONE,         // No bound computed (non-cascade algorithms, early rejections)
+    QUICKED_STAGE_WINDOWED_S,   // WindowEd(S), small windows
+    QUICKED_STAGE_WINDOWED_L,   // WindowEd(L), forward and reverse
+    QUICKED_STAGE_BANDED,       // BandEd score-only passes
+    QUICKED_STAGE_COUNT
+} quicked_stage_t;
+
+// Filled by every alignment call
+typedef struct quicked_stats_t {
+    quicked_stage_t bound_stage;
+    uint64_t high_error_windows[QUICKED_WINDOW_STAGES]; // High-error windows seen by each window stage
+    uint64_t band_doublings;    // BandEd passes repeated with a doubled cutoff
+    int64_t final_cutoff;       // Cutoff of the last banded or Hirschberg pass (-1 if none)
+    uint64_t hirschberg_depth;  // Deepest Hirschberg recursion level
+    uint64_t anchors;           // Anchors the alignment was split at. If any, the score may be above the distance
+    uint64_t cells;             // DP cells computed by all the stages
+} quicked_stats_t;
+
+// Accumulates quicked_stats_t over many alignments (and threads, through merge)
+typedef struct quicked_stats_aggregate_t {
+    uint64_t alignments;
+    uint64_t bound_stage[QUICKED_STAGE_COUNT];          // Alignments bounded by each stage
+    uint64_t high_error_windows[QUICKED_WINDOW_STAGES];
+    uint64_t band_doublings;
+    uint64_t max_band_doublings;
+    int64_t max_final_cutoff;
+    uint64_t max_hirschberg_depth;
+    uint64_t anchored;          // Alignments split at anchors (scores that may be above the distance)
+    uint64_t cells;
+    uint64_t max_cells;         // Most expensive single alignment
+} quicked_stats_aggregate_t;
+
+void quicked_stats_aggregate_reset(
+    quicked_stats_aggregate_t *aggregate
+);
+void quicked_stats_aggregate_add(
+    quicked_stats_aggregate_t *aggregate,
+    const quicked_stats_t *stats
+);
+void quicked_stats_aggregate_merge(
+    quicked_stats_aggregate_t *aggregate,
+    const quicked_stats_aggregate_t *other
+);
+
 typedef struct quicked_aligner_t {
     quicked_params_t* params;
     mm_allocator_t *mm_allocator;
-    char* cigar;
+    struct quicked_workspace_t *workspace; // Buffers reused across stages and alignments
+    struct quicked_workspace_pool_t *workspace_pool; // Per-task workspaces (num_threads > 1)
+    char* cigar;                           // Valid until the next quicked_align call
+    uint32_t* cigar_packed;                // BAM op codes: '=' 7, X 8, I 1, D 2. Valid until the next call
+    int cigar_packed_length;               // Runs in cigar_packed
     int score;
+    int text_begin;                        // Aligned text span [text_begin, text_end): the whole text unless
+    int text_end;                          // ends_free (BANDED with only_score leaves text_begin at 0) or xdrop
+    int pattern_end;                       // Aligned pattern prefix: the whole pattern unless xdrop
+    int trimmed_prefix;                    // Common prefix and suffix matched as they are, only the rest is
+    int trimmed_suffix;                    // aligned (global alignments). Included in the CIGAR
+    quicked_simd_t simd;                   // Kernels picked for this CPU (SCALAR if force_scalar)
+    quicked_stats_t stats;                 // Last quicked_align call
+    quicked_stats_aggregate_t stats_total; // All calls since quicked_new
     // Profiling
     profiler_timer_t *timer;
     profiler_timer_t *timer_windowed_s;
@@ -73,6 +162,9 @@ typedef enum quicked_status_t {
     QUICKED_UNKNOWN_ALGO         = -3,  // Provided algorithm is not supported
     QUICKED_EMPTY_SEQUENCE       = -4,  // Empty sequence
 
+    // Results
+    QUICKED_ABOVE_MAX_SCORE      = 2,   // The distance is larger than max_score. Considered not an error
+
     // Development codes
     QUICKED_UNIMPLEMENTED        = -10, // Function declared but not implemented
     QUICKED_WIP                  = 1,   // Function implementation in progress. Considered not an error
@@ -94,5 +186,54 @@ quicked_status_t quicked_align(
     const char* pattern, const int pattern_len,
     const char* text, const int text_len
 );
+// Sequences already encoded, one byte per base: A=0, C=1, G=2, T=3 and 4 (N) for any
+// other base. Values above 4 are not allowed. Skips the encoding done by quicked_align.
+quicked_status_t quicked_align_encoded(
+    quicked_aligner_t *aligner,
+    const uint8_t* pattern, const int pattern_len,
+    const uint8_t* text, const int text_len
+);
+// 2-bit packed sequences: base i is stored in bits 2*(i%32) of word i/32 (A=0, C=1,
+// G=2, T=3). If the N mask is not NULL, bit i%64 of its word i/64 marks base i as N.
+quicked_status_t quicked_align_packed(
+    quicked_aligner_t *aligner,
+    const uint64_t* pattern, const uint64_t* pattern_n_mask, const int pattern_len,
+    const uint64_t* text, const uint64_t* text_n_mask, const int text_len
+);
+
+// Compiled pattern: built once, then aligned against many texts. It is read-only
+// after quicked_pattern_compile, so several aligners/threads may share it. It is
+// compiled with the SIMD level of aligner (see force_scalar).
+typedef struct quicked_pattern_t quicked_pattern_t;
+
+quicked_status_t quicked_pattern_compile(
+    const quicked_aligner_t *aligner,
+    quicked_pattern_t **compiled_pattern,
+    const char* pattern, const int pattern_len
+);
+quicked_status_t quicked_pattern_free(
+    quicked_pattern_t *compiled_pattern
+);
+quicked_status_t quicked_align_compiled(
+    quicked_aligner_t *aligner,
+    const quicked_pattern_t *compiled_pattern,
+    const char* text, const int text_len
+);
+
+// Aligns num_alignments pairs on num_threads workers (<= 0 uses all online CPUs),
+// each one with its own aligner. Scores are written to scores[i]; if cigars is not
+// NULL, cigars[i] receives a malloc'd CIGAR string (NULL when only_score or with
+// QUICKED_CIGAR_PACKED) that the caller must free. If stats is not NULL, the statistics of all the alignments are
+// merged into it. Returns the first error found, or QUICKED_OK.
+quicked_status_t quicked_align_batch(
+    quicked_params_t *params,
+    int num_threads,
+    const char **patterns, const int *pattern_lens,
+    const char **texts, const int *text_lens,
+    const int num_alignments,
+    int *scores,
+    char **cigars,
+    quicked_stats_aggregate_t *stats
+);
 
 #endif // QUICKED_H
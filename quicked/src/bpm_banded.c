@@ -24,66 +24,58 @@
 
 #include "quicked_utils/include/commons.h"
 #include "quicked_utils/include/mm_allocator.h"
-#include "quicked_utils/include/dna_text.h"
 #include "bpm_banded.h"
 #include "bpm_commons.h"
+#include "quicked_cpu.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <sys/mman.h>
 
-#ifndef __AVX2__
-#warning "AVX2 or higher is required for SIMD banded"
-#else
+#ifdef QUICKED_SIMD_X86
 #include <immintrin.h>
 #endif
 
 
 
-void banded_pattern_compile(
+uint64_t banded_pattern_size(
+    const uint64_t pattern_length)
+{
+    const uint64_t pattern_num_words64 = DIV_CEIL(pattern_length, BPM_W64_LENGTH);
+    const uint64_t aux_vector_size = pattern_num_words64 * BPM_W64_SIZE;
+    const uint64_t PEQ_size = BPM_ALPHABET_LENGTH * BPM_PATTERN_PEQ_ROW_STRIDE(pattern_num_words64) * BPM_W64_SIZE;
+    // Slack to align the PEQ rows
+    return 3 * aux_vector_size + PEQ_size + BPM_PEQ_ALIGNMENT;
+}
+
+void banded_pattern_init(
     banded_pattern_t *const banded_pattern,
     const char* pattern,
     const uint64_t pattern_length,
-    mm_allocator_t *const mm_allocator)
+    const quicked_simd_t simd,
+    void *memory)
 {
     // Calculate dimensions
     const uint64_t pattern_num_words64 = DIV_CEIL(pattern_length, BPM_W64_LENGTH);
-    const uint64_t PEQ_length = pattern_num_words64 * BPM_W64_LENGTH;
     const uint64_t pattern_mod = pattern_length % BPM_W64_LENGTH;
     // Init fields
     banded_pattern->pattern = pattern;
     banded_pattern->pattern_length = pattern_length;
     banded_pattern->pattern_num_words64 = pattern_num_words64;
     banded_pattern->pattern_mod = pattern_mod;
-    // Allocate memory
+    // Layout memory (the PEQ rows last, aligned)
     const uint64_t aux_vector_size = pattern_num_words64 * BPM_W64_SIZE;
-    const uint64_t PEQ_size = BPM_ALPHABET_LENGTH * aux_vector_size;
-    const uint64_t total_memory = PEQ_size + 3 * aux_vector_size + (pattern_num_words64)*UINT64_SIZE;
-    void *memory = mm_allocator_malloc(mm_allocator, total_memory);
-    banded_pattern->PEQ = memory;
-    memory += PEQ_size;
     banded_pattern->P = memory;
     memory += aux_vector_size;
     banded_pattern->M = memory;
     memory += aux_vector_size;
     banded_pattern->level_mask = memory;
+    memory += aux_vector_size;
+    banded_pattern->PEQ = (uint64_t*)(((uintptr_t)memory + BPM_PEQ_ALIGNMENT - 1) & ~(uintptr_t)(BPM_PEQ_ALIGNMENT - 1));
+    banded_pattern->PEQ_row_stride = BPM_PATTERN_PEQ_ROW_STRIDE(pattern_num_words64);
     // Init PEQ
-    memset(banded_pattern->PEQ, 0, PEQ_size);
+    bpm_pattern_compile_peq_rows(banded_pattern->PEQ, banded_pattern->PEQ_row_stride, pattern, pattern_length, simd);
     uint64_t i;
-    for (i = 0; i < pattern_length; ++i)
-    {
-        const uint8_t enc_char = dna_encode(pattern[i]);
-        const uint64_t block = i / BPM_W64_LENGTH;
-        const uint64_t mask = 1ull << (i % BPM_W64_LENGTH);
-        banded_pattern->PEQ[BPM_PATTERN_PEQ_IDX(block, enc_char)] |= mask;
-    }
-    for (; i < PEQ_length; ++i)
-    { // Padding
-        const uint64_t block = i / BPM_W64_LENGTH;
-        const uint64_t mask = 1ull << (i % BPM_W64_LENGTH);
-        uint64_t j;
-        for (j = 0; j < BPM_ALPHABET_LENGTH; ++j)
-        {
-            banded_pattern->PEQ[BPM_PATTERN_PEQ_IDX(block, j)] |= mask;
-        }
-    }
     // Init auxiliary data
     const uint64_t top = pattern_num_words64 - 1;
     memset(banded_pattern->level_mask, 0, aux_vector_size);
@@ -102,27 +94,55 @@ void banded_pattern_compile(
     }
 }
 
+void banded_pattern_compile(
+    banded_pattern_t *const banded_pattern,
+    const char* pattern,
+    const uint64_t pattern_length,
+    const quicked_simd_t simd,
+    mm_allocator_t *const mm_allocator)
+{
+    void *memory = mm_allocator_malloc(mm_allocator, banded_pattern_size(pattern_length));
+    banded_pattern_init(banded_pattern, pattern, pattern_length, simd, memory);
+}
+
+void banded_pattern_compile_workspace(
+    banded_pattern_t *const banded_pattern,
+    const char* pattern,
+    const uint64_t pattern_length,
+    const quicked_simd_t simd,
+    workspace_pass_t *const pass,
+    mm_allocator_t *const mm_allocator)
+{
+    void *memory = workspace_buffer_reserve(&pass->pattern, banded_pattern_size(pattern_length), false, mm_allocator);
+    banded_pattern_init(banded_pattern, pattern, pattern_length, simd, memory);
+}
+
 void banded_pattern_free(
     banded_pattern_t *const banded_pattern,
     mm_allocator_t *const mm_allocator)
 {
-    mm_allocator_free(mm_allocator, banded_pattern->PEQ);
+    mm_allocator_free(mm_allocator, banded_pattern->P);
 }
 
-void banded_matrix_allocate(
+void banded_matrix_setup(
     banded_matrix_t *const banded_matrix,
     const int64_t pattern_length,
     const int64_t text_length,
     const int64_t cutoff_score,
-    bool only_score,
-    mm_allocator_t *const mm_allocator)
+    const bool ends_free)
 {
-
     const int64_t k_end = ABS(((int64_t)text_length) - (int64_t)(pattern_length)) + 1;
     banded_matrix->cutoff_score = MAX(MAX(k_end, cutoff_score), 65);
     banded_matrix->sequence_length_diff = pattern_length - text_length;
-    banded_matrix->relative_cutoff_score = (banded_matrix->cutoff_score - ABS(banded_matrix->sequence_length_diff)) == 0LL ? 0LL : 
-                                            DIV_CEIL((banded_matrix->cutoff_score - ABS(banded_matrix->sequence_length_diff)), 2);
+    if (ends_free)
+    { // The alignment may start on any diagonal between the first and the last one: widen both sides by the cutoff
+        banded_matrix->relative_cutoff_score = MAX(cutoff_score, BPM_W64_LENGTH);
+    }
+    else
+    {
+        banded_matrix->relative_cutoff_score = (banded_matrix->cutoff_score - ABS(banded_matrix->sequence_length_diff)) == 0LL ? 0LL : 
+                                                DIV_CEIL((banded_matrix->cutoff_score - ABS(banded_matrix->sequence_length_diff)), 2);
+    }
     const int64_t relative_cutoff_score_blocks = banded_matrix->relative_cutoff_score == 0LL ? 0LL : DIV_CEIL(banded_matrix->relative_cutoff_score, BPM_W64_LENGTH);
     if (banded_matrix->sequence_length_diff >= 0)
     {
@@ -136,31 +156,73 @@ void banded_matrix_allocate(
         banded_matrix->effective_bandwidth_blocks = relative_cutoff_score_blocks + 1 + banded_matrix->prolog_column_blocks;
     }
     banded_matrix->effective_bandwidth = banded_matrix->cutoff_score;
+    banded_matrix->ends_free = ends_free;
+    banded_matrix->text_begin = 0;
+    banded_matrix->text_end = text_length;
+    banded_matrix->early_exit_score = -1;
+    banded_matrix->early_exit = false;
+    banded_matrix->packed_cigar = false;
+    banded_matrix->num_threads = 1;
+    banded_matrix->cells = 0;
+}
 
+uint64_t banded_matrix_aux_size(
+    const banded_matrix_t *const banded_matrix,
+    const int64_t text_length,
+    const bool only_score)
+{
     const uint64_t num_words64 = banded_matrix->effective_bandwidth_blocks;
-    // Allocate auxiliary matrix
     const uint64_t num_cols = (only_score ? 1 : (text_length + 1)); // Only 1 column if only score, or text_length + 1 columns
-    const uint64_t aux_matrix_size = num_words64 * UINT64_SIZE * num_cols;
+    return num_words64 * UINT64_SIZE * num_cols;
+}
+
+uint64_t banded_matrix_footprint(
+    const int64_t pattern_length,
+    const int64_t text_length,
+    const int64_t cutoff_score,
+    const bool ends_free)
+{
+    banded_matrix_t banded_matrix;
+    banded_matrix_setup(&banded_matrix, pattern_length, text_length, cutoff_score, ends_free);
+    return 2 * banded_matrix_aux_size(&banded_matrix, text_length, false);
+}
+
+uint64_t banded_matrix_scores_size(
+    const banded_matrix_t *const banded_matrix,
+    const int64_t pattern_length)
+{
+    const uint64_t num_words64 = banded_matrix->effective_bandwidth_blocks;
+    return MAX((DIV_CEIL(pattern_length, BPM_W64_LENGTH) + num_words64 / 2), banded_matrix->effective_bandwidth_blocks) * UINT64_SIZE;
+}
+
+void banded_matrix_allocate(
+    banded_matrix_t *const banded_matrix,
+    const int64_t pattern_length,
+    const int64_t text_length,
+    const int64_t cutoff_score,
+    bool only_score,
+    bool ends_free,
+    mm_allocator_t *const mm_allocator)
+{
+    banded_matrix_setup(banded_matrix, pattern_length, text_length, cutoff_score, ends_free);
+
+    // Allocate auxiliary matrix
+    const uint64_t aux_matrix_size = banded_matrix_aux_size(banded_matrix, text_length, only_score);
     uint64_t * Pv;
     uint64_t * Mv;
     if (aux_matrix_size > BUFFER_SIZE_256K){
         Pv = (uint64_t *)mm_allocator_allocate(mm_allocator, aux_matrix_size,false,BUFFER_SIZE_2M);
         Mv = (uint64_t *)mm_allocator_allocate(mm_allocator, aux_matrix_size,false,BUFFER_SIZE_2M);
         #ifdef __linux__
-            if (madvise(Pv, aux_matrix_size, MADV_HUGEPAGE) == -1) {
-                perror("madvise");
-                exit(EXIT_FAILURE);
-            }
-            if (madvise(Mv, aux_matrix_size, MADV_HUGEPAGE) == -1) {
-                perror("madvise");
-                exit(EXIT_FAILURE);
-            }
+            // Huge pages are only a hint: without them (e.g. disabled in the kernel), regular pages are used
+            madvise(Pv, aux_matrix_size, MADV_HUGEPAGE);
+            madvise(Mv, aux_matrix_size, MADV_HUGEPAGE);
         #endif
     } else {
         Pv = (uint64_t *)mm_allocator_malloc(mm_allocator, aux_matrix_size);
         Mv = (uint64_t *)mm_allocator_malloc(mm_allocator, aux_matrix_size);
     }
-    int64_t *const scores = (int64_t *)mm_allocator_malloc(mm_allocator, MAX((DIV_CEIL(pattern_length, BPM_W64_LENGTH) + num_words64 / 2), banded_matrix->effective_bandwidth_blocks) * UINT64_SIZE);
+    int64_t *const scores = (int64_t *)mm_allocator_malloc(mm_allocator, banded_matrix_scores_size(banded_matrix, pattern_length));
     banded_matrix->Mv = Mv;
     banded_matrix->Pv = Pv;
     banded_matrix->scores = scores;
@@ -169,6 +231,32 @@ void banded_matrix_allocate(
     banded_matrix->cigar->end_offset = pattern_length + text_length;
 }
 
+void banded_matrix_allocate_workspace(
+    banded_matrix_t *const banded_matrix,
+    const int64_t pattern_length,
+    const int64_t text_length,
+    const int64_t cutoff_score,
+    bool only_score,
+    bool ends_free,
+    workspace_pass_t *const pass,
+    mm_allocator_t *const mm_allocator)
+{
+    banded_matrix_setup(banded_matrix, pattern_length, text_length, cutoff_score, ends_free);
+
+    const uint64_t aux_matrix_size = banded_matrix_aux_size(banded_matrix, text_length, only_score);
+    banded_matrix->Pv = (uint64_t *)workspace_buffer_reserve(&pass->Pv, aux_matrix_size, true, mm_allocator);
+    banded_matrix->Mv = (uint64_t *)workspace_buffer_reserve(&pass->Mv, aux_matrix_size, true, mm_allocator);
+    banded_matrix->scores = (int64_t *)workspace_buffer_reserve(&pass->scores, banded_matrix_scores_size(banded_matrix, pattern_length), false, mm_allocator);
+    // CIGAR (operations are only needed for the backtrace)
+    cigar_t *const cigar = &pass->cigar;
+    cigar->max_operations = pattern_length + text_length;
+    cigar->operations = only_score ? NULL : (char *)workspace_buffer_reserve(&pass->operations, cigar->max_operations, false, mm_allocator);
+    cigar->cigar_buffer = NULL;
+    cigar_clear(cigar);
+    cigar->end_offset = pattern_length + text_length;
+    banded_matrix->cigar = cigar;
+}
+
 void banded_matrix_free(
     banded_matrix_t *const banded_matrix,
     mm_allocator_t *const mm_allocator)
@@ -199,14 +287,61 @@ void bpm_reset_search(
     }
 }
 
+/*
+ * Decision mode (early_exit_score >= 0). Inside a block, cells are at most 63 rows
+ * above the block's bottom cell, so both their score and their distance to the
+ * final diagonal can be at most 63 lower than the bottom cell's. Ends-free
+ * alignments have no final diagonal, only the score bounds them.
+ */
+static inline bool banded_band_exceeds(
+    const int64_t *const scores,
+    const int64_t first_block_v,
+    const int64_t last_block_v,
+    const int64_t pos_v,
+    const int64_t pattern_length,
+    const int64_t text_length,
+    const int64_t text_consumed,
+    const int64_t threshold,
+    const bool ends_free)
+{
+    for (int64_t i = first_block_v; i <= last_block_v; ++i)
+    {
+        const int64_t bottom_row = (i + pos_v + 1) * BPM_W64_LENGTH;
+        const int64_t diagonal_distance = ends_free ? 0 : ABS((pattern_length - bottom_row) - (text_length - text_consumed));
+        if (scores[i + pos_v] + diagonal_distance - 2 * (BPM_W64_LENGTH - 1) <= threshold)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static inline void banded_set_early_exit(
+    banded_matrix_t *const banded_matrix,
+    const int64_t first_block_v,
+    const int64_t last_block_v)
+{
+    banded_matrix->early_exit = true;
+    banded_matrix->cigar->score = banded_matrix->early_exit_score + 1; // Lower bound
+    banded_matrix->higher_block = last_block_v;
+    banded_matrix->lower_block = first_block_v;
+}
+
+/*
+ * Keeps every column for the backtrace, or a single one (only_score). Also
+ * computes the ends-free mode: the top row is free (no horizontal carry into
+ * row 0) and the alignment ends on the cheapest cell of the last row.
+ */
 void bpm_compute_matrix_banded_cutoff(
     banded_matrix_t *const banded_matrix,
-    banded_pattern_t *const banded_pattern,
+    const banded_pattern_t *const banded_pattern,
     const char* text,
-    const int64_t text_length)
+    const int64_t text_length,
+    const bool only_score)
 {
     // Pattern variables
     const uint64_t *PEQ = banded_pattern->PEQ;
+    const uint64_t PEQ_row_stride = banded_pattern->PEQ_row_stride;
     const int64_t effective_bandwidth_blocks = banded_matrix->effective_bandwidth_blocks;
 
     const int64_t num_block_rows = DIV_CEIL(banded_pattern->pattern_length, BPM_W64_LENGTH);
@@ -216,11 +351,19 @@ void bpm_compute_matrix_banded_cutoff(
     uint64_t *const Mv = banded_matrix->Mv;
     int64_t *const scores = banded_matrix->scores;
     const uint64_t num_words64 = effective_bandwidth_blocks;
+    const uint64_t column_words = only_score ? 0 : num_words64; // Score only: a single column, updated in place
 
     const int64_t sequence_length_diff = banded_matrix->sequence_length_diff;
     const int64_t prologue_columns = banded_matrix->prolog_column_blocks;
     const int64_t finish_v_pos_inside_band = prologue_columns * BPM_W64_LENGTH + sequence_length_diff;
 
+    // Ends-free: best cell of the last row (the scores of its block count the padding rows too)
+    const bool ends_free = banded_matrix->ends_free;
+    const int64_t last_row_block = num_block_rows - 1;
+    const int64_t last_row_padding = num_block_rows * BPM_W64_LENGTH - banded_pattern->pattern_length;
+    int64_t best_score = banded_pattern->pattern_length;
+    int64_t best_text_end = 0;
+
     // Prepare last block of the next column
     int64_t pos_v = -prologue_columns;
     int64_t pos_h = 0;
@@ -235,21 +378,28 @@ void bpm_compute_matrix_banded_cutoff(
     for (text_position = 0; text_position < text_length; ++text_position)
     {
         // Fetch next character
-        const uint8_t enc_char = dna_encode(text[text_position]);
+        const uint8_t enc_char = (uint8_t)text[text_position];
+        const uint64_t *const PEQ_row = PEQ + BPM_PATTERN_PEQ_ROW_IDX(0, enc_char, PEQ_row_stride);
+        if (text_position + 1 < text_length)
+        { // The next column starts one block lower on the row of the next character
+            const uint8_t next_enc_char = (uint8_t)text[text_position + 1];
+            __builtin_prefetch(PEQ + BPM_PATTERN_PEQ_ROW_IDX(first_block_v + pos_v + 1, next_enc_char, PEQ_row_stride));
+        }
+        banded_matrix->cells += (last_block_v - first_block_v + 1) * BPM_W64_LENGTH;
         // Advance all blocks
         int64_t i;
-        uint64_t PHin = 1, MHin = 0, PHout, MHout;
+        uint64_t PHin = (ends_free && first_block_v + pos_v == 0) ? 0 : 1, MHin = 0, PHout, MHout;
         // Main Loop
         for (i = first_block_v; i <= last_block_v; ++i)
         {
  
             /* Calculate Step Data */
-            const uint64_t bdp_idx = BPM_PATTERN_BDP_IDX(text_position, num_words64, i);
-            const uint64_t next_bdp_idx = bdp_idx + num_words64;
+            const uint64_t bdp_idx = BPM_PATTERN_BDP_IDX(text_position, column_words, i);
+            const uint64_t next_bdp_idx = bdp_idx + column_words;
             uint64_t Pv_in = Pv[bdp_idx];
             uint64_t Mv_in = Mv[bdp_idx];
             const uint64_t mask = level_mask[i + pos_v];
-            const uint64_t Eq = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v), enc_char)];
+            const uint64_t Eq = PEQ_row[i + pos_v];
 
             /* Compute Block */
             BPM_ADVANCE_BLOCK(Eq, mask, Pv_in, Mv_in, PHin, MHin, PHout, MHout);
@@ -262,13 +412,43 @@ void bpm_compute_matrix_banded_cutoff(
             MHin = MHout;
             scores[i + pos_v] = scores[i + pos_v] + PHout - MHout;
         }
+        if (column_words > 0)
+        { // The backtrace may step out of the band, where it must find zeros (as in fresh memory), not a previous matrix
+            const uint64_t next_column_idx = BPM_PATTERN_BDP_IDX(text_position + 1, column_words, 0);
+            if (first_block_v > 0)
+            {
+                memset(&Pv[next_column_idx], 0, first_block_v * UINT64_SIZE);
+                memset(&Mv[next_column_idx], 0, first_block_v * UINT64_SIZE);
+            }
+            if (last_block_v + 1 < effective_bandwidth_blocks)
+            {
+                memset(&Pv[next_column_idx + last_block_v + 1], 0, (effective_bandwidth_blocks - last_block_v - 1) * UINT64_SIZE);
+                memset(&Mv[next_column_idx + last_block_v + 1], 0, (effective_bandwidth_blocks - last_block_v - 1) * UINT64_SIZE);
+            }
+        }
+
+        if (ends_free && first_block_v + pos_v <= last_row_block && last_block_v + pos_v >= last_row_block &&
+            scores[last_row_block] - last_row_padding < best_score)
+        {
+            best_score = scores[last_row_block] - last_row_padding;
+            best_text_end = text_position + 1;
+        }
 
         // Update the score for the new column
         if ((text_position + 1) % 64 == 0)
         {
+            // Decision mode: stop once no block in the band can finish within early_exit_score
+            if (banded_matrix->early_exit_score >= 0 && !(ends_free && best_score <= banded_matrix->early_exit_score) &&
+                banded_band_exceeds(scores, first_block_v, last_block_v, pos_v, banded_pattern->pattern_length,
+                                    text_length, text_position + 1, banded_matrix->early_exit_score, banded_matrix->ends_free))
+            {
+                banded_set_early_exit(banded_matrix, first_block_v, last_block_v);
+                return;
+            }
+
             // printf("-----------------------------------------------------\n");
-            //  chech if the band of the lower side should be cutted
-            int cut_band_lower = (first_block_v + 2 < last_block_v) && (finish_v_pos_inside_band > BPM_W64_LENGTH * (first_block_v + 1)) && (scores[first_block_v + pos_v + 1] + (finish_v_pos_inside_band - BPM_W64_LENGTH * (first_block_v + 1))) > banded_matrix->cutoff_score;
+            //  chech if the band of the lower side should be cutted (ends-free alignments have no fixed final cell to bound it)
+            int cut_band_lower = !ends_free && (first_block_v + 2 < last_block_v) && (finish_v_pos_inside_band > BPM_W64_LENGTH * (first_block_v + 1)) && (scores[first_block_v + pos_v + 1] + (finish_v_pos_inside_band - BPM_W64_LENGTH * (first_block_v + 1))) > banded_matrix->cutoff_score;
 
             if (cut_band_lower && (pos_h >= prologue_columns))
             {
@@ -279,7 +459,7 @@ void bpm_compute_matrix_banded_cutoff(
                 first_block_v--;
             }
 
-            uint64_t next_bdp_idx = BPM_PATTERN_BDP_IDX(text_position + 1, num_words64, 0);
+            uint64_t next_bdp_idx = BPM_PATTERN_BDP_IDX(text_position + 1, column_words, 0);
             // Shift results one block in the last column of a 64-column block
             for (int64_t j = first_block_v; j < last_block_v; j++)
             {
@@ -293,7 +473,7 @@ void bpm_compute_matrix_banded_cutoff(
             scores[pos + 1] = scores[pos] + BPM_W64_LENGTH;
 
             // chech if the band of the higher side should be cutted
-            int cut_band_higer = (first_block_v + 2 < last_block_v) && (BPM_W64_LENGTH * (last_block_v - 1) > finish_v_pos_inside_band) && (scores[last_block_v + pos_v - 1] + (BPM_W64_LENGTH * (last_block_v - 1) - finish_v_pos_inside_band)) > banded_matrix->cutoff_score;
+            int cut_band_higer = !ends_free && (first_block_v + 2 < last_block_v) && (BPM_W64_LENGTH * (last_block_v - 1) > finish_v_pos_inside_band) && (scores[last_block_v + pos_v - 1] + (BPM_W64_LENGTH * (last_block_v - 1) - finish_v_pos_inside_band)) > banded_matrix->cutoff_score;
 
             if (cut_band_higer || (pos_v + last_block_v >= num_block_rows - 1))
             {
@@ -305,7 +485,12 @@ void bpm_compute_matrix_banded_cutoff(
     }
 
     uint64_t final_score;
-    if (banded_pattern->pattern_length % BPM_W64_LENGTH)
+    if (ends_free)
+    {
+        final_score = best_score;
+        banded_matrix->text_end = best_text_end;
+    }
+    else if (banded_pattern->pattern_length % BPM_W64_LENGTH)
     {
         final_score = scores[(banded_pattern->pattern_length) / BPM_W64_LENGTH] - (BPM_W64_LENGTH - (banded_pattern->pattern_length % BPM_W64_LENGTH));
     }
@@ -322,6 +507,7 @@ static inline __attribute__((always_inline)) void compute_advance_block (
     uint64_t* Pv, 
     uint64_t* Mv,
     const uint64_t *const PEQ,
+    const uint64_t PEQ_row_stride,
     const uint64_t *const level_mask,
     int64_t* scores,
     uint64_t i,
@@ -335,7 +521,7 @@ static inline __attribute__((always_inline)) void compute_advance_block (
     uint64_t Pv_in = Pv[i];
     uint64_t Mv_in = Mv[i];
     uint64_t mask  = level_mask[i + pos_v];
-    uint64_t Eq    = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v), enc_char)];
+    uint64_t Eq    = PEQ[BPM_PATTERN_PEQ_ROW_IDX((i + pos_v), enc_char, PEQ_row_stride)];
     uint64_t _PHin = *PHin; 
     uint64_t _MHin = *MHin;
     
@@ -348,20 +534,147 @@ static inline __attribute__((always_inline)) void compute_advance_block (
     scores[i + pos_v] = scores[i + pos_v] + PHout - MHout;
 }
 
-#ifdef __AVX2__
+// Advances 2 text columns over the band (narrow bands)
+static inline __attribute__((always_inline)) void banded_advance_columns_x2(
+    uint64_t* Pv,
+    uint64_t* Mv,
+    const uint64_t *const PEQ,
+    const uint64_t PEQ_row_stride,
+    const uint64_t *const level_mask,
+    int64_t* scores,
+    const char* text,
+    const int64_t text_position,
+    const int64_t first_block_v,
+    const int64_t last_block_v,
+    const int64_t pos_v)
+{
+    const uint8_t enc_char  = (uint8_t)text[text_position];
+    const uint8_t enc_char2 = (uint8_t)text[text_position+1];
+    int64_t i = first_block_v;  
+    uint64_t PHin_0 = 1, MHin_0 = 0, PHin_1 = 1, MHin_1 = 0;
+    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i, pos_v, enc_char, &PHin_0, &MHin_0);
+    for (i = first_block_v+1; i <= last_block_v; ++i)
+    {
+        compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i-1, pos_v, enc_char2, &PHin_1, &MHin_1);
+        compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v,  enc_char, &PHin_0, &MHin_0);
+    }
+    i = last_block_v;
+    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i, pos_v, enc_char2, &PHin_1, &MHin_1);
+}
+
+#ifdef QUICKED_SIMD_X86
+// Equalities of 4 lanes where lane k reads block base + k of the row of enc_char(4-k):
+// each row is read with one vector load from the same offset and the lanes are blended
+QUICKED_TARGET("avx2")
+static inline __attribute__((always_inline)) __m256i banded_load_eq_x4(
+    const uint64_t *const PEQ,
+    const uint64_t PEQ_row_stride,
+    const int64_t base,
+    const uint8_t enc_char1,
+    const uint8_t enc_char2,
+    const uint8_t enc_char3,
+    const uint8_t enc_char4)
+{
+    __m256i Eq = _mm256_loadu_si256((const __m256i*)&PEQ[BPM_PATTERN_PEQ_ROW_IDX(base, enc_char4, PEQ_row_stride)]);
+    Eq = _mm256_blend_epi32(Eq, _mm256_loadu_si256((const __m256i*)&PEQ[BPM_PATTERN_PEQ_ROW_IDX(base, enc_char3, PEQ_row_stride)]), 0x0C);
+    Eq = _mm256_blend_epi32(Eq, _mm256_loadu_si256((const __m256i*)&PEQ[BPM_PATTERN_PEQ_ROW_IDX(base, enc_char2, PEQ_row_stride)]), 0x30);
+    Eq = _mm256_blend_epi32(Eq, _mm256_loadu_si256((const __m256i*)&PEQ[BPM_PATTERN_PEQ_ROW_IDX(base, enc_char1, PEQ_row_stride)]), 0xC0);
+    return Eq;
+}
+
+// Advances 4 text columns over the band: an AVX2 pipeline covers 4 blocks of consecutive columns at once
+QUICKED_TARGET("avx2")
+static inline __attribute__((always_inline)) void banded_advance_columns_x4_avx(
+    uint64_t* Pv,
+    uint64_t* Mv,
+    const uint64_t *const PEQ,
+    const uint64_t PEQ_row_stride,
+    const uint64_t *const level_mask,
+    int64_t* scores,
+    const char* text,
+    const int64_t text_position,
+    const int64_t first_block_v,
+    const int64_t last_block_v,
+    const int64_t pos_v)
+{
+    // Fetch next character
+    const uint8_t enc_char1 = (uint8_t)text[text_position];
+    const uint8_t enc_char2 = (uint8_t)text[text_position+1];
+    const uint8_t enc_char3 = (uint8_t)text[text_position+2];
+    const uint8_t enc_char4 = (uint8_t)text[text_position+3];
+
+    int64_t i = first_block_v;
+    
+    uint64_t PHin_0 = 1ul, MHin_0 = 0ul, PHin_1 = 1ul, MHin_1 = 0ul, PHin_2 = 1ul, MHin_2 = 0ul, PHin_3 = 1ul, MHin_3 = 0ul;
+
+    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char1, &PHin_0, &MHin_0);
+    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i+1, pos_v, enc_char1, &PHin_0, &MHin_0);
+    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i+2, pos_v, enc_char1, &PHin_0, &MHin_0);
+    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char2, &PHin_1, &MHin_1);
+    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i+1, pos_v, enc_char2, &PHin_1, &MHin_1);
+    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char3, &PHin_2, &MHin_2);
+
+    __m256i Pv_in = _mm256_set_epi64x(Pv[first_block_v+2], Pv[first_block_v+1], Pv[first_block_v], 0); 
+    __m256i Mv_in = _mm256_set_epi64x(Mv[first_block_v+2], Mv[first_block_v+1], Mv[first_block_v], 0); 
+    __m256i PHin  = _mm256_set_epi64x(PHin_0, PHin_1, PHin_2, PHin_3);  
+    __m256i MHin  = _mm256_set_epi64x(MHin_0, MHin_1, MHin_2, MHin_3);
+    __m256i MHout = MHin; 
+    __m256i PHout = PHout;
+
+    for (i = first_block_v+3; i <= last_block_v; ++i)
+    {
+        Pv_in = _mm256_permute4x64_epi64(Pv_in, 0x39);
+        Mv_in = _mm256_permute4x64_epi64(Mv_in, 0x39);
+
+        Pv_in = _mm256_insert_epi64(Pv_in,   Pv[i], 3);
+        Mv_in = _mm256_insert_epi64(Mv_in,   Mv[i], 3);
+
+        __m256i Eq    = banded_load_eq_x4(PEQ, PEQ_row_stride, i+pos_v-3, enc_char1, enc_char2, enc_char3, enc_char4);
+        __m256i score = _mm256_lddqu_si256((__m256i*)&scores[i+pos_v-3]);
+        __m256i mask  = _mm256_lddqu_si256((__m256i const*)&level_mask[i+pos_v-3]);
+        
+        BPM_ADVANCE_BLOCK_SI256(Eq, mask, Pv_in, Mv_in, PHin, MHin, PHout, MHout);
+
+        Pv[i-3] = _mm256_extract_epi64(Pv_in, 0);
+        Mv[i-3] = _mm256_extract_epi64(Mv_in, 0);
+
+        MHin = MHout; 
+        PHin = PHout;
+        score = _mm256_add_epi64(score, PHout);
+        score = _mm256_sub_epi64(score, MHout);
+        _mm256_storeu_si256((__m256i*)&scores[i+pos_v-3], score);
+    }
+    i = last_block_v;
+    _mm256_storeu_si256((__m256i*)&Pv[i-3], Pv_in);
+    _mm256_storeu_si256((__m256i*)&Mv[i-3], Mv_in);
+
+    PHin_1 = _mm256_extract_epi64(PHout, 2);
+    MHin_1 = _mm256_extract_epi64(MHout, 2);
+    PHin_2 = _mm256_extract_epi64(PHout, 1);
+    MHin_2 = _mm256_extract_epi64(MHout, 1);
+    PHin_3 = _mm256_extract_epi64(PHout, 0);
+    MHin_3 = _mm256_extract_epi64(MHout, 0);
+
+    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char2, &PHin_1, &MHin_1);
+    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i-1, pos_v, enc_char3, &PHin_2, &MHin_2);
+    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char3, &PHin_2, &MHin_2);
+    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i-2, pos_v, enc_char4, &PHin_3, &MHin_3);
+    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i-1, pos_v, enc_char4, &PHin_3, &MHin_3);
+    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char4, &PHin_3, &MHin_3);
+}
+
+QUICKED_TARGET("avx2")
 void bpm_compute_matrix_banded_cutoff_score_avx(
     banded_matrix_t *const banded_matrix,
-    banded_pattern_t *const banded_pattern,
+    const banded_pattern_t *const banded_pattern,
     const char* text,
     const int64_t text_length,
     const int64_t text_finish_pos)
 {
     // Pattern variables
     const uint64_t *PEQ = banded_pattern->PEQ;
-    // TODO: remove if necessary
-    const int64_t k_end = ABS(((int64_t)text_length) - (int64_t)(banded_pattern->pattern_length)) + 1;
-    const int64_t real_bandwidth = MAX(MAX(k_end, banded_matrix->cutoff_score), 65);
-    const int64_t effective_bandwidth_blocks = DIV_CEIL(real_bandwidth, BPM_W64_LENGTH) + 1;
+    const uint64_t PEQ_row_stride = banded_pattern->PEQ_row_stride;
+    const int64_t effective_bandwidth_blocks = banded_matrix->effective_bandwidth_blocks;
     const int64_t num_block_rows = DIV_CEIL(banded_pattern->pattern_length, BPM_W64_LENGTH);
 
     const uint64_t *const level_mask = banded_pattern->level_mask;
@@ -395,14 +708,14 @@ void bpm_compute_matrix_banded_cutoff_score_avx(
             for (text_position = k * 64; text_position < (k+1) * 64; text_position+=8)
             {
                 // Fetch next character
-                const uint8_t enc_char1 = dna_encode(text[text_position]);
-                const uint8_t enc_char2 = dna_encode(text[text_position+1]);
-                const uint8_t enc_char3 = dna_encode(text[text_position+2]);
-                const uint8_t enc_char4 = dna_encode(text[text_position+3]);
-                const uint8_t enc_char5 = dna_encode(text[text_position+4]);
-                const uint8_t enc_char6 = dna_encode(text[text_position+5]);
-                const uint8_t enc_char7 = dna_encode(text[text_position+6]);
-                const uint8_t enc_char8 = dna_encode(text[text_position+7]);
+                const uint8_t enc_char1 = (uint8_t)text[text_position];
+                const uint8_t enc_char2 = (uint8_t)text[text_position+1];
+                const uint8_t enc_char3 = (uint8_t)text[text_position+2];
+                const uint8_t enc_char4 = (uint8_t)text[text_position+3];
+                const uint8_t enc_char5 = (uint8_t)text[text_position+4];
+                const uint8_t enc_char6 = (uint8_t)text[text_position+5];
+                const uint8_t enc_char7 = (uint8_t)text[text_position+6];
+                const uint8_t enc_char8 = (uint8_t)text[text_position+7];
                 
 
                 int64_t i = first_block_v;
@@ -416,12 +729,12 @@ void bpm_compute_matrix_banded_cutoff_score_avx(
                 uint64_t PHin_6 = 1, MHin_6 = 0; 
                 uint64_t PHin_7 = 1, MHin_7 = 0;
 
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char1, &PHin_0, &MHin_0);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i+1, pos_v, enc_char1, &PHin_0, &MHin_0);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i+2, pos_v, enc_char1, &PHin_0, &MHin_0);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char2, &PHin_1, &MHin_1);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i+1, pos_v, enc_char2, &PHin_1, &MHin_1);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char3, &PHin_2, &MHin_2);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char1, &PHin_0, &MHin_0);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i+1, pos_v, enc_char1, &PHin_0, &MHin_0);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i+2, pos_v, enc_char1, &PHin_0, &MHin_0);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char2, &PHin_1, &MHin_1);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i+1, pos_v, enc_char2, &PHin_1, &MHin_1);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char3, &PHin_2, &MHin_2);
                 
                 __m256i Pv_in = _mm256_set_epi64x(Pv[first_block_v+2], Pv[first_block_v+1], Pv[first_block_v], 0); 
                 __m256i Mv_in = _mm256_set_epi64x(Mv[first_block_v+2], Mv[first_block_v+1], Mv[first_block_v], 0); 
@@ -439,12 +752,7 @@ void bpm_compute_matrix_banded_cutoff_score_avx(
                     Pv_in = _mm256_insert_epi64(Pv_in,   Pv[i], 3);
                     Mv_in = _mm256_insert_epi64(Mv_in,   Mv[i], 3);
 
-                    uint64_t Eq_3 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v),     enc_char1)];
-                    uint64_t Eq_2 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v - 1), enc_char2)];
-                    uint64_t Eq_1 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v - 2), enc_char3)];
-                    uint64_t Eq_0 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v - 3), enc_char4)];
-                    
-                    __m256i Eq    = _mm256_set_epi64x (Eq_3, Eq_2, Eq_1, Eq_0); 
+                    __m256i Eq    = banded_load_eq_x4(PEQ, PEQ_row_stride, i+pos_v-3, enc_char1, enc_char2, enc_char3, enc_char4);
                     __m256i score = _mm256_lddqu_si256((__m256i*)&scores[i+pos_v-3]);
                     __m256i mask  = _mm256_lddqu_si256((__m256i const*)&level_mask[i+pos_v-3]);
                     
@@ -472,12 +780,12 @@ void bpm_compute_matrix_banded_cutoff_score_avx(
                 MHin_3 = _mm256_extract_epi64(MHout, 0);
 
                 i = first_block_v;
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char5, &PHin_4, &MHin_4);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i+1, pos_v, enc_char5, &PHin_4, &MHin_4);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i+2, pos_v, enc_char5, &PHin_4, &MHin_4);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char6, &PHin_5, &MHin_5);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i+1, pos_v, enc_char6, &PHin_5, &MHin_5);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char7, &PHin_6, &MHin_6);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char5, &PHin_4, &MHin_4);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i+1, pos_v, enc_char5, &PHin_4, &MHin_4);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i+2, pos_v, enc_char5, &PHin_4, &MHin_4);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char6, &PHin_5, &MHin_5);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i+1, pos_v, enc_char6, &PHin_5, &MHin_5);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char7, &PHin_6, &MHin_6);
 
                 PHin = _mm256_set_epi64x(PHin_4, PHin_5, PHin_6, PHin_7);
                 MHin = _mm256_set_epi64x(MHin_4, MHin_5, MHin_6, MHin_7);
@@ -499,11 +807,7 @@ void bpm_compute_matrix_banded_cutoff_score_avx(
                     Pv_in2 = _mm256_insert_epi64(Pv_in2,   Pv[i], 3);
                     Mv_in2 = _mm256_insert_epi64(Mv_in2,   Mv[i], 3);
 
-                    uint64_t Eq_3 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v),     enc_char1)];
-                    uint64_t Eq_2 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v - 1), enc_char2)];
-                    uint64_t Eq_1 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v - 2), enc_char3)];
-                    uint64_t Eq_0 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v - 3), enc_char4)];
-                    __m256i Eq    = _mm256_set_epi64x (Eq_3, Eq_2, Eq_1, Eq_0); 
+                    __m256i Eq    = banded_load_eq_x4(PEQ, PEQ_row_stride, i+pos_v-3, enc_char1, enc_char2, enc_char3, enc_char4);
                     __m256i score = _mm256_lddqu_si256((__m256i*)&scores[i+pos_v-3]);
                     __m256i mask  = _mm256_lddqu_si256((__m256i const*)&level_mask[i+pos_v-3]);
                     
@@ -524,11 +828,7 @@ void bpm_compute_matrix_banded_cutoff_score_avx(
                     Pv_in = _mm256_insert_epi64(Pv_in,   Pv[i-4], 3);
                     Mv_in = _mm256_insert_epi64(Mv_in,   Mv[i-4], 3);
 
-                    Eq_3 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v - 4), enc_char5)];
-                    Eq_2 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v - 5), enc_char6)];
-                    Eq_1 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v - 6), enc_char7)];
-                    Eq_0 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v - 7), enc_char8)];
-                    Eq    = _mm256_set_epi64x (Eq_3, Eq_2, Eq_1, Eq_0); 
+                    Eq    = banded_load_eq_x4(PEQ, PEQ_row_stride, i+pos_v-7, enc_char5, enc_char6, enc_char7, enc_char8);
                     score = _mm256_lddqu_si256((__m256i*)&scores[i+pos_v-7]);
                     mask  = _mm256_lddqu_si256((__m256i const*)&level_mask[i+pos_v-7]);
                     
@@ -558,12 +858,12 @@ void bpm_compute_matrix_banded_cutoff_score_avx(
 
                 i = last_block_v;
                 
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char2, &PHin_1, &MHin_1);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i-1, pos_v, enc_char3, &PHin_2, &MHin_2);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char3, &PHin_2, &MHin_2);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i-2, pos_v, enc_char4, &PHin_3, &MHin_3);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i-1, pos_v, enc_char4, &PHin_3, &MHin_3);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char4, &PHin_3, &MHin_3);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char2, &PHin_1, &MHin_1);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i-1, pos_v, enc_char3, &PHin_2, &MHin_2);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char3, &PHin_2, &MHin_2);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i-2, pos_v, enc_char4, &PHin_3, &MHin_3);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i-1, pos_v, enc_char4, &PHin_3, &MHin_3);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char4, &PHin_3, &MHin_3);
                 
                 Pv_in = _mm256_set_epi64x(Pv[i-4], Pv[i-5], Pv[i-6], Pv[i-7]); 
                 Mv_in = _mm256_set_epi64x(Mv[i-4], Mv[i-5], Mv[i-6], Mv[i-7]); 
@@ -579,11 +879,7 @@ void bpm_compute_matrix_banded_cutoff_score_avx(
                     Pv_in = _mm256_insert_epi64(Pv_in,   Pv[i], 3);
                     Mv_in = _mm256_insert_epi64(Mv_in,   Mv[i], 3);
 
-                    uint64_t Eq_3 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v),     enc_char5)];
-                    uint64_t Eq_2 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v - 1), enc_char6)];
-                    uint64_t Eq_1 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v - 2), enc_char7)];
-                    uint64_t Eq_0 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v - 3), enc_char8)];
-                    __m256i Eq    = _mm256_set_epi64x (Eq_3, Eq_2, Eq_1, Eq_0); 
+                    __m256i Eq    = banded_load_eq_x4(PEQ, PEQ_row_stride, i+pos_v-3, enc_char5, enc_char6, enc_char7, enc_char8);
                     __m256i score = _mm256_lddqu_si256((__m256i*)&scores[i+pos_v-3]);
                     __m256i mask  = _mm256_lddqu_si256((__m256i const*)&level_mask[i+pos_v-3]);
                     
@@ -610,108 +906,282 @@ void bpm_compute_matrix_banded_cutoff_score_avx(
 
                 i = last_block_v;
 
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char6, &PHin_5, &MHin_5);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i-1, pos_v, enc_char7, &PHin_6, &MHin_6);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char7, &PHin_6, &MHin_6);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i-2, pos_v, enc_char8, &PHin_7, &MHin_7);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i-1, pos_v, enc_char8, &PHin_7, &MHin_7);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char8, &PHin_7, &MHin_7);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char6, &PHin_5, &MHin_5);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i-1, pos_v, enc_char7, &PHin_6, &MHin_6);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char7, &PHin_6, &MHin_6);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i-2, pos_v, enc_char8, &PHin_7, &MHin_7);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i-1, pos_v, enc_char8, &PHin_7, &MHin_7);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char8, &PHin_7, &MHin_7);
                 }
         }
         else if (last_block_v - first_block_v >= 4)
         {
             for (text_position = k * 64; text_position < (k+1) * 64; text_position+=4)
             {
-                // Fetch next character
-                const uint8_t enc_char1 = dna_encode(text[text_position]);
-                const uint8_t enc_char2 = dna_encode(text[text_position+1]);
-                const uint8_t enc_char3 = dna_encode(text[text_position+2]);
-                const uint8_t enc_char4 = dna_encode(text[text_position+3]);
+                banded_advance_columns_x4_avx(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, text, text_position, first_block_v, last_block_v, pos_v);
+            }          
+        }
+        else 
+        {
+            for (text_position = k * 64; text_position < (k+1) * 64; text_position+=2)
+            {
+                banded_advance_columns_x2(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, text, text_position, first_block_v, last_block_v, pos_v);
+            }
+        }
+        banded_matrix->cells += (last_block_v - first_block_v + 1) * BPM_W64_LENGTH * BPM_W64_LENGTH;
 
-                int64_t i = first_block_v;
-                
-                uint64_t PHin_0 = 1ul, MHin_0 = 0ul, PHin_1 = 1ul, MHin_1 = 0ul, PHin_2 = 1ul, MHin_2 = 0ul, PHin_3 = 1ul, MHin_3 = 0ul;
+        // Decision mode: stop once no block in the band can finish within early_exit_score
+        if (banded_matrix->early_exit_score >= 0 &&
+            banded_band_exceeds(scores, first_block_v, last_block_v, pos_v, banded_pattern->pattern_length,
+                                text_length, (k + 1) * BPM_W64_LENGTH, banded_matrix->early_exit_score, banded_matrix->ends_free))
+        {
+            banded_set_early_exit(banded_matrix, first_block_v, last_block_v);
+            return;
+        }
 
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char1, &PHin_0, &MHin_0);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i+1, pos_v, enc_char1, &PHin_0, &MHin_0);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i+2, pos_v, enc_char1, &PHin_0, &MHin_0);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char2, &PHin_1, &MHin_1);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i+1, pos_v, enc_char2, &PHin_1, &MHin_1);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char3, &PHin_2, &MHin_2);
+        // chech if the band of the lower side should be cutted
+        int cut_band_lower = (first_block_v + 2 < last_block_v) && (finish_v_pos_inside_band > BPM_W64_LENGTH * (first_block_v + 1)) && (scores[first_block_v + pos_v + 1] + (finish_v_pos_inside_band - BPM_W64_LENGTH * (first_block_v + 1))) > banded_matrix->cutoff_score;
 
-                __m256i Pv_in = _mm256_set_epi64x(Pv[first_block_v+2], Pv[first_block_v+1], Pv[first_block_v], 0); 
-                __m256i Mv_in = _mm256_set_epi64x(Mv[first_block_v+2], Mv[first_block_v+1], Mv[first_block_v], 0); 
-                __m256i PHin  = _mm256_set_epi64x(PHin_0, PHin_1, PHin_2, PHin_3);  
-                __m256i MHin  = _mm256_set_epi64x(MHin_0, MHin_1, MHin_2, MHin_3);
-                __m256i MHout = MHin; 
-                __m256i PHout = PHout;
+        // if we are in the prolog columns, we have to decrease the first_block_v (apart of cutting the band if necessary)
+        if (cut_band_lower && (pos_h >= prologue_columns))
+        {
+            first_block_v++;
+        }
+        else if (!cut_band_lower && (pos_h < prologue_columns))
+        {
+            first_block_v--;
+        }
 
-                for (i = first_block_v+3; i <= last_block_v; ++i)
-                {
-                    Pv_in = _mm256_permute4x64_epi64(Pv_in, 0x39);
-                    Mv_in = _mm256_permute4x64_epi64(Mv_in, 0x39);
+        // Shift results one block in the last column of a 64-column block
+        for (int64_t j = first_block_v; j < last_block_v; j++)
+        {
+            Pv[j] = Pv[j + 1];
+            Mv[j] = Mv[j + 1];
+        }
+        Pv[last_block_v] = BPM_W64_ONES;
+        Mv[last_block_v] = 0;
+        // Update the score for the new column
+        int64_t pos = last_block_v + pos_v;
+        scores[pos + 1] = scores[pos] + BPM_W64_LENGTH;
 
-                    Pv_in = _mm256_insert_epi64(Pv_in,   Pv[i], 3);
-                    Mv_in = _mm256_insert_epi64(Mv_in,   Mv[i], 3);
+        // chech if the band of the higher side should be cutted
+        int cut_band_higer = (first_block_v + 2 < last_block_v) && (BPM_W64_LENGTH * (last_block_v - 1) > finish_v_pos_inside_band) && (scores[last_block_v + pos_v - 1] + (BPM_W64_LENGTH * (last_block_v - 1) - finish_v_pos_inside_band)) > banded_matrix->cutoff_score;
 
-                    uint64_t Eq_3 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v),     enc_char1)];
-                    uint64_t Eq_2 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v - 1), enc_char2)];
-                    uint64_t Eq_1 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v - 2), enc_char3)];
-                    uint64_t Eq_0 = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v - 3), enc_char4)];
-                    
-                    __m256i Eq    = _mm256_set_epi64x (Eq_3, Eq_2, Eq_1, Eq_0); 
-                    __m256i score = _mm256_lddqu_si256((__m256i*)&scores[i+pos_v-3]);
-                    __m256i mask  = _mm256_lddqu_si256((__m256i const*)&level_mask[i+pos_v-3]);
-                    
-                    BPM_ADVANCE_BLOCK_SI256(Eq, mask, Pv_in, Mv_in, PHin, MHin, PHout, MHout);
+        if (cut_band_higer || (pos_v + last_block_v >= num_block_rows))
+        {
+            last_block_v--;
+        }
+        pos_v++;
+        pos_h++;
+    }
 
-                    Pv[i-3] = _mm256_extract_epi64(Pv_in, 0);
-                    Mv[i-3] = _mm256_extract_epi64(Mv_in, 0);
+    for (; text_position < text_finish_pos; ++text_position)
+    {
+        // Fetch next character
+        const uint8_t enc_char = (uint8_t)text[text_position];
+        const uint64_t *const PEQ_row = PEQ + BPM_PATTERN_PEQ_ROW_IDX(0, enc_char, PEQ_row_stride);
+        banded_matrix->cells += (last_block_v - first_block_v + 1) * BPM_W64_LENGTH;
+        // Advance all blocks
+        int64_t i;
+        uint64_t PHin = 1, MHin = 0, PHout, MHout;
+        // Main Loop
+        for (i = first_block_v; i <= last_block_v; ++i)
+        {
+            /* Calculate Step Data */
+            uint64_t Pv_in = Pv[i];
+            uint64_t Mv_in = Mv[i];
+            const uint64_t mask = level_mask[i + pos_v];
+            const uint64_t Eq = PEQ_row[i + pos_v];
 
-                    MHin = MHout; 
-                    PHin = PHout;
-                    score = _mm256_add_epi64(score, PHout);
-                    score = _mm256_sub_epi64(score, MHout);
-                    _mm256_storeu_si256((__m256i*)&scores[i+pos_v-3], score);
-                }
-                i = last_block_v;
-                _mm256_storeu_si256((__m256i*)&Pv[i-3], Pv_in);
-                _mm256_storeu_si256((__m256i*)&Mv[i-3], Mv_in);
+            /* Compute Block */
+            BPM_ADVANCE_BLOCK(Eq, mask, Pv_in, Mv_in, PHin, MHin, PHout, MHout);
 
-                PHin_1 = _mm256_extract_epi64(PHout, 2);
-                MHin_1 = _mm256_extract_epi64(MHout, 2);
-                PHin_2 = _mm256_extract_epi64(PHout, 1);
-                MHin_2 = _mm256_extract_epi64(MHout, 1);
-                PHin_3 = _mm256_extract_epi64(PHout, 0);
-                MHin_3 = _mm256_extract_epi64(MHout, 0);
+            /* Swap propagate Hv */
+            Pv[i] = Pv_in;
+            Mv[i] = Mv_in;
+            PHin = PHout;
+            MHin = MHout;
+            scores[i + pos_v] = scores[i + pos_v] + PHout - MHout;
+        }
+    }
+    uint64_t final_score;
+    if (banded_pattern->pattern_length % BPM_W64_LENGTH)
+    {
+        final_score = scores[(banded_pattern->pattern_length) / BPM_W64_LENGTH] - (BPM_W64_LENGTH - (banded_pattern->pattern_length % BPM_W64_LENGTH));
+    }
+    else
+    {
+        final_score = scores[(banded_pattern->pattern_length - 1) / BPM_W64_LENGTH];
+    }
+    banded_matrix->cigar->score = final_score;
+    banded_matrix->higher_block = last_block_v;
+    banded_matrix->lower_block = first_block_v;
+}
+
+// Advances 8 text columns over the band. Lane L computes column text_position + 7 - L
+// on block i - 7 + L, so every iteration shifts each block one lane down to the next column
+QUICKED_TARGET("avx512f")
+static inline __attribute__((always_inline)) void banded_advance_columns_x8_avx512(
+    uint64_t* Pv,
+    uint64_t* Mv,
+    const uint64_t *const PEQ,
+    const uint64_t PEQ_row_stride,
+    const uint64_t *const level_mask,
+    int64_t* scores,
+    const char* text,
+    const int64_t text_position,
+    const int64_t first_block_v,
+    const int64_t last_block_v,
+    const int64_t pos_v)
+{
+    uint8_t enc_char[8];
+    uint64_t PHin[8], MHin[8];
+    for (int c = 0; c < 8; c++)
+    {
+        enc_char[c] = (uint8_t)text[text_position + c];
+        PHin[c] = 1;
+        MHin[c] = 0;
+    }
+
+    // Prologue: blocks above the first full anti-diagonal
+    for (int c = 0; c < 7; c++)
+    {
+        for (int64_t i = first_block_v; i < first_block_v + 7 - c; i++)
+        {
+            compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i, pos_v, enc_char[c], &PHin[c], &MHin[c]);
+        }
+    }
+
+    // Lane L holds block first_block_v - 1 + L (lane 0 is shifted out before being used)
+    const __m512i ones = _mm512_set1_epi64(1);
+    __m512i Pv_in = _mm512_maskz_loadu_epi64(0xFE, Pv + first_block_v - 1);
+    __m512i Mv_in = _mm512_maskz_loadu_epi64(0xFE, Mv + first_block_v - 1);
+    __m512i score = _mm512_maskz_loadu_epi64(0xFE, scores + first_block_v + pos_v - 1);
+    // Lane L reads block i - 7 + L from the row of the character of its column
+    const __m512i Eq_idx = _mm512_set_epi64(
+        BPM_PATTERN_PEQ_ROW_IDX(pos_v,     enc_char[0], (int64_t)PEQ_row_stride),
+        BPM_PATTERN_PEQ_ROW_IDX(pos_v - 1, enc_char[1], (int64_t)PEQ_row_stride),
+        BPM_PATTERN_PEQ_ROW_IDX(pos_v - 2, enc_char[2], (int64_t)PEQ_row_stride),
+        BPM_PATTERN_PEQ_ROW_IDX(pos_v - 3, enc_char[3], (int64_t)PEQ_row_stride),
+        BPM_PATTERN_PEQ_ROW_IDX(pos_v - 4, enc_char[4], (int64_t)PEQ_row_stride),
+        BPM_PATTERN_PEQ_ROW_IDX(pos_v - 5, enc_char[5], (int64_t)PEQ_row_stride),
+        BPM_PATTERN_PEQ_ROW_IDX(pos_v - 6, enc_char[6], (int64_t)PEQ_row_stride),
+        BPM_PATTERN_PEQ_ROW_IDX(pos_v - 7, enc_char[7], (int64_t)PEQ_row_stride));
+    __mmask8 PH = 0, MH = 0;
+    for (int L = 0; L < 8; L++)
+    {
+        PH |= (__mmask8)(PHin[7 - L] << L);
+        MH |= (__mmask8)(MHin[7 - L] << L);
+    }
+
+    for (int64_t i = first_block_v + 7; i <= last_block_v; ++i)
+    {
+        Pv_in = _mm512_alignr_epi64(_mm512_set1_epi64(Pv[i]), Pv_in, 1);
+        Mv_in = _mm512_alignr_epi64(_mm512_set1_epi64(Mv[i]), Mv_in, 1);
+        score = _mm512_alignr_epi64(_mm512_set1_epi64(scores[i + pos_v]), score, 1);
+
+        const __m512i Eq   = _mm512_i64gather_epi64(Eq_idx, (const void*)(PEQ + i), 8);
+        const __m512i mask = _mm512_loadu_si512((const void*)&level_mask[i + pos_v - 7]);
+
+        __mmask8 PHout, MHout;
+        BPM_ADVANCE_BLOCK_SI512(Eq, mask, ones, Pv_in, Mv_in, PH, MH, PHout, MHout);
+        PH = PHout;
+        MH = MHout;
+        score = _mm512_mask_add_epi64(score, PHout, score, ones);
+        score = _mm512_mask_sub_epi64(score, MHout, score, ones);
+
+        // Lane 0 has gone through the 8 columns
+        Pv[i - 7] = _mm_cvtsi128_si64(_mm512_castsi512_si128(Pv_in));
+        Mv[i - 7] = _mm_cvtsi128_si64(_mm512_castsi512_si128(Mv_in));
+        scores[i + pos_v - 7] = _mm_cvtsi128_si64(_mm512_castsi512_si128(score));
+    }
+    _mm512_storeu_si512((void*)&Pv[last_block_v - 7], Pv_in);
+    _mm512_storeu_si512((void*)&Mv[last_block_v - 7], Mv_in);
+    _mm512_storeu_si512((void*)&scores[last_block_v + pos_v - 7], score);
+
+    // Epilogue: blocks below the last full anti-diagonal
+    for (int c = 1; c < 8; c++)
+    {
+        PHin[c] = (PH >> (7 - c)) & 1;
+        MHin[c] = (MH >> (7 - c)) & 1;
+        for (int64_t i = last_block_v - c + 1; i <= last_block_v; i++)
+        {
+            compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i, pos_v, enc_char[c], &PHin[c], &MHin[c]);
+        }
+    }
+}
+
+QUICKED_TARGET("avx512f")
+void bpm_compute_matrix_banded_cutoff_score_avx512(
+    banded_matrix_t *const banded_matrix,
+    const banded_pattern_t *const banded_pattern,
+    const char* text,
+    const int64_t text_length,
+    const int64_t text_finish_pos)
+{
+    // Pattern variables
+    const uint64_t *PEQ = banded_pattern->PEQ;
+    const uint64_t PEQ_row_stride = banded_pattern->PEQ_row_stride;
+    const int64_t effective_bandwidth_blocks = banded_matrix->effective_bandwidth_blocks;
+    const int64_t num_block_rows = DIV_CEIL(banded_pattern->pattern_length, BPM_W64_LENGTH);
+
+    const uint64_t *const level_mask = banded_pattern->level_mask;
+    uint64_t *const Pv = banded_matrix->Pv;
+    uint64_t *const Mv = banded_matrix->Mv;
+    int64_t *const scores = banded_matrix->scores;
+
+    const int64_t sequence_length_diff = banded_matrix->sequence_length_diff;
+    const int64_t prologue_columns = banded_matrix->prolog_column_blocks;
+    const int64_t finish_v_pos_inside_band = prologue_columns * BPM_W64_LENGTH + sequence_length_diff;
+
+    // Prepare last block of the next column
+    int64_t pos_v = -prologue_columns;
+    int64_t pos_h = 0;
+    int64_t first_block_v = prologue_columns;
+    int64_t last_block_v = effective_bandwidth_blocks - 1;
+
+    bpm_reset_search(effective_bandwidth_blocks, Pv, Mv, scores);
 
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char2, &PHin_1, &MHin_1);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i-1, pos_v, enc_char3, &PHin_2, &MHin_2);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char3, &PHin_2, &MHin_2);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i-2, pos_v, enc_char4, &PHin_3, &MHin_3);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i-1, pos_v, enc_char4, &PHin_3, &MHin_3);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char4, &PHin_3, &MHin_3);
+    // Advance in DP-bit_encoded matrix
+    int64_t text_position = 0, k;
+    // uint64_t count = 0;
+    //  Main loop
+
+    int64_t text_block = (text_finish_pos / 64);
+
+    for (k = 0; k < text_block; k++)
+    {
+        if (last_block_v - first_block_v >= 8)
+        {
+            for (text_position = k * 64; text_position < (k+1) * 64; text_position+=8)
+            {
+                banded_advance_columns_x8_avx512(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, text, text_position, first_block_v, last_block_v, pos_v);
+            }
+        }
+        else if (last_block_v - first_block_v >= 4)
+        {
+            for (text_position = k * 64; text_position < (k+1) * 64; text_position+=4)
+            {
+                banded_advance_columns_x4_avx(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, text, text_position, first_block_v, last_block_v, pos_v);
             }          
         }
         else 
         {
             for (text_position = k * 64; text_position < (k+1) * 64; text_position+=2)
             {
-                const uint8_t enc_char  = dna_encode(text[text_position]);
-                const uint8_t enc_char2 = dna_encode(text[text_position+1]);
-                int64_t i = first_block_v;  
-                uint64_t PHin_0 = 1, MHin_0 = 0, PHin_1 = 1, MHin_1 = 0;
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i, pos_v, enc_char, &PHin_0, &MHin_0);
-                for (i = first_block_v+1; i <= last_block_v; ++i)
-                {
-                    compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i-1, pos_v, enc_char2, &PHin_1, &MHin_1);
-                    compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v,  enc_char, &PHin_0, &MHin_0);
-                }
-                i = last_block_v;
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i, pos_v, enc_char2, &PHin_1, &MHin_1);
+                banded_advance_columns_x2(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, text, text_position, first_block_v, last_block_v, pos_v);
             }
         }
-        
+        banded_matrix->cells += (last_block_v - first_block_v + 1) * BPM_W64_LENGTH * BPM_W64_LENGTH;
+
+        // Decision mode: stop once no block in the band can finish within early_exit_score
+        if (banded_matrix->early_exit_score >= 0 &&
+            banded_band_exceeds(scores, first_block_v, last_block_v, pos_v, banded_pattern->pattern_length,
+                                text_length, (k + 1) * BPM_W64_LENGTH, banded_matrix->early_exit_score, banded_matrix->ends_free))
+        {
+            banded_set_early_exit(banded_matrix, first_block_v, last_block_v);
+            return;
+        }
 
         // chech if the band of the lower side should be cutted
         int cut_band_lower = (first_block_v + 2 < last_block_v) && (finish_v_pos_inside_band > BPM_W64_LENGTH * (first_block_v + 1)) && (scores[first_block_v + pos_v + 1] + (finish_v_pos_inside_band - BPM_W64_LENGTH * (first_block_v + 1))) > banded_matrix->cutoff_score;
@@ -752,7 +1222,9 @@ void bpm_compute_matrix_banded_cutoff_score_avx(
     for (; text_position < text_finish_pos; ++text_position)
     {
         // Fetch next character
-        const uint8_t enc_char = dna_encode(text[text_position]);
+        const uint8_t enc_char = (uint8_t)text[text_position];
+        const uint64_t *const PEQ_row = PEQ + BPM_PATTERN_PEQ_ROW_IDX(0, enc_char, PEQ_row_stride);
+        banded_matrix->cells += (last_block_v - first_block_v + 1) * BPM_W64_LENGTH;
         // Advance all blocks
         int64_t i;
         uint64_t PHin = 1, MHin = 0, PHout, MHout;
@@ -763,7 +1235,7 @@ void bpm_compute_matrix_banded_cutoff_score_avx(
             uint64_t Pv_in = Pv[i];
             uint64_t Mv_in = Mv[i];
             const uint64_t mask = level_mask[i + pos_v];
-            const uint64_t Eq = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v), enc_char)];
+            const uint64_t Eq = PEQ_row[i + pos_v];
 
             /* Compute Block */
             BPM_ADVANCE_BLOCK(Eq, mask, Pv_in, Mv_in, PHin, MHin, PHout, MHout);
@@ -793,17 +1265,17 @@ void bpm_compute_matrix_banded_cutoff_score_avx(
 
 void bpm_compute_matrix_banded_cutoff_score(
     banded_matrix_t *const banded_matrix,
-    banded_pattern_t *const banded_pattern,
+    const banded_pattern_t *const banded_pattern,
     const char* text,
     const int64_t text_length,
     const int64_t text_finish_pos)
 {
     // Pattern variables
     const uint64_t *PEQ = banded_pattern->PEQ;
-    // TODO: remove if necessary
-    const int64_t k_end = ABS(((int64_t)text_length) - (int64_t)(banded_pattern->pattern_length)) + 1;
-    const int64_t real_bandwidth = MAX(MAX(k_end, banded_matrix->cutoff_score), 65);
-    const int64_t effective_bandwidth_blocks = DIV_CEIL(real_bandwidth, BPM_W64_LENGTH) + 1;
+    const uint64_t PEQ_row_stride = banded_pattern->PEQ_row_stride;
+    // The band of the full matrix. DIV_CEIL(cutoff_score, 64) + 1 blocks fall one short when the length
+    // difference takes up most of the cutoff, and lose the alignment if the cutoff is exact (Hirschberg subproblems)
+    const int64_t effective_bandwidth_blocks = banded_matrix->effective_bandwidth_blocks;
     const int64_t num_block_rows = DIV_CEIL(banded_pattern->pattern_length, BPM_W64_LENGTH);
 
     const uint64_t *const level_mask = banded_pattern->level_mask;
@@ -837,57 +1309,66 @@ void bpm_compute_matrix_banded_cutoff_score(
             for (text_position = k * 64; text_position < (k+1) * 64; text_position+=4)
             {
                 // Fetch next character
-                const uint8_t enc_char1 = dna_encode(text[text_position]);
-                const uint8_t enc_char2 = dna_encode(text[text_position+1]);
-                const uint8_t enc_char3 = dna_encode(text[text_position+2]);
-                const uint8_t enc_char4 = dna_encode(text[text_position+3]);
+                const uint8_t enc_char1 = (uint8_t)text[text_position];
+                const uint8_t enc_char2 = (uint8_t)text[text_position+1];
+                const uint8_t enc_char3 = (uint8_t)text[text_position+2];
+                const uint8_t enc_char4 = (uint8_t)text[text_position+3];
 
                 int64_t i = first_block_v;
                 
                 uint64_t PHin_0 = 1ul, MHin_0 = 0ul, PHin_1 = 1ul, MHin_1 = 0ul, PHin_2 = 1ul, MHin_2 = 0ul, PHin_3 = 1ul, MHin_3 = 0ul;
 
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char1, &PHin_0, &MHin_0);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i+1, pos_v, enc_char1, &PHin_0, &MHin_0);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i+2, pos_v, enc_char1, &PHin_0, &MHin_0);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char2, &PHin_1, &MHin_1);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i+1, pos_v, enc_char2, &PHin_1, &MHin_1);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char3, &PHin_2, &MHin_2);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char1, &PHin_0, &MHin_0);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i+1, pos_v, enc_char1, &PHin_0, &MHin_0);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i+2, pos_v, enc_char1, &PHin_0, &MHin_0);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char2, &PHin_1, &MHin_1);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i+1, pos_v, enc_char2, &PHin_1, &MHin_1);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char3, &PHin_2, &MHin_2);
 
                 for (i = first_block_v+3; i <= last_block_v; ++i)
                 {
-                    compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char1, &PHin_0, &MHin_0);
-                    compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i-1, pos_v, enc_char2, &PHin_1, &MHin_1);
-                    compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i-2, pos_v, enc_char3, &PHin_2, &MHin_2);
-                    compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i-3, pos_v, enc_char4, &PHin_3, &MHin_3);
+                    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char1, &PHin_0, &MHin_0);
+                    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i-1, pos_v, enc_char2, &PHin_1, &MHin_1);
+                    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i-2, pos_v, enc_char3, &PHin_2, &MHin_2);
+                    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i-3, pos_v, enc_char4, &PHin_3, &MHin_3);
                 }
                 i = last_block_v;
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char2, &PHin_1, &MHin_1);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i-1, pos_v, enc_char3, &PHin_2, &MHin_2);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char3, &PHin_2, &MHin_2);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i-2, pos_v, enc_char4, &PHin_3, &MHin_3);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i-1, pos_v, enc_char4, &PHin_3, &MHin_3);
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v, enc_char4, &PHin_3, &MHin_3);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char2, &PHin_1, &MHin_1);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i-1, pos_v, enc_char3, &PHin_2, &MHin_2);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char3, &PHin_2, &MHin_2);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i-2, pos_v, enc_char4, &PHin_3, &MHin_3);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i-1, pos_v, enc_char4, &PHin_3, &MHin_3);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v, enc_char4, &PHin_3, &MHin_3);
             }          
         }
         else 
         {
             for (text_position = k * 64; text_position < (k+1) * 64; text_position+=2)
             {
-                const uint8_t enc_char  = dna_encode(text[text_position]);
-                const uint8_t enc_char2 = dna_encode(text[text_position+1]);
+                const uint8_t enc_char  = (uint8_t)text[text_position];
+                const uint8_t enc_char2 = (uint8_t)text[text_position+1];
                 int64_t i = first_block_v;  
                 uint64_t PHin_0 = 1, MHin_0 = 0, PHin_1 = 1, MHin_1 = 0;
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i, pos_v, enc_char, &PHin_0, &MHin_0);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i, pos_v, enc_char, &PHin_0, &MHin_0);
                 for (i = first_block_v+1; i <= last_block_v; ++i)
                 {
-                    compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i-1, pos_v, enc_char2, &PHin_1, &MHin_1);
-                    compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i,   pos_v,  enc_char, &PHin_0, &MHin_0);
+                    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i-1, pos_v, enc_char2, &PHin_1, &MHin_1);
+                    compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i,   pos_v,  enc_char, &PHin_0, &MHin_0);
                 }
                 i = last_block_v;
-                compute_advance_block(Pv, Mv, PEQ, level_mask, scores, i, pos_v, enc_char2, &PHin_1, &MHin_1);
+                compute_advance_block(Pv, Mv, PEQ, PEQ_row_stride, level_mask, scores, i, pos_v, enc_char2, &PHin_1, &MHin_1);
             }
         }
-        
+        banded_matrix->cells += (last_block_v - first_block_v + 1) * BPM_W64_LENGTH * BPM_W64_LENGTH;
+
+        // Decision mode: stop once no block in the band can finish within early_exit_score
+        if (banded_matrix->early_exit_score >= 0 &&
+            banded_band_exceeds(scores, first_block_v, last_block_v, pos_v, banded_pattern->pattern_length,
+                                text_length, (k + 1) * BPM_W64_LENGTH, banded_matrix->early_exit_score, banded_matrix->ends_free))
+        {
+            banded_set_early_exit(banded_matrix, first_block_v, last_block_v);
+            return;
+        }
 
         // chech if the band of the lower side should be cutted
         int cut_band_lower = (first_block_v + 2 < last_block_v) && (finish_v_pos_inside_band > BPM_W64_LENGTH * (first_block_v + 1)) && (scores[first_block_v + pos_v + 1] + (finish_v_pos_inside_band - BPM_W64_LENGTH * (first_block_v + 1))) > banded_matrix->cutoff_score;
@@ -928,7 +1409,9 @@ void bpm_compute_matrix_banded_cutoff_score(
     for (; text_position < text_finish_pos; ++text_position)
     {
         // Fetch next character
-        const uint8_t enc_char = dna_encode(text[text_position]);
+        const uint8_t enc_char = (uint8_t)text[text_position];
+        const uint64_t *const PEQ_row = PEQ + BPM_PATTERN_PEQ_ROW_IDX(0, enc_char, PEQ_row_stride);
+        banded_matrix->cells += (last_block_v - first_block_v + 1) * BPM_W64_LENGTH;
         // Advance all blocks
         int64_t i;
         uint64_t PHin = 1, MHin = 0, PHout, MHout;
@@ -939,7 +1422,7 @@ void bpm_compute_matrix_banded_cutoff_score(
             uint64_t Pv_in = Pv[i];
             uint64_t Mv_in = Mv[i];
             const uint64_t mask = level_mask[i + pos_v];
-            const uint64_t Eq = PEQ[BPM_PATTERN_PEQ_IDX((i + pos_v), enc_char)];
+            const uint64_t Eq = PEQ_row[i + pos_v];
 
             /* Compute Block */
             BPM_ADVANCE_BLOCK(Eq, mask, Pv_in, Mv_in, PHin, MHin, PHout, MHout);
@@ -967,26 +1450,489 @@ void bpm_compute_matrix_banded_cutoff_score(
 }
 
 
-void banded_backtrace_matrix_cutoff(
+/*
+ * Wavefront-parallel score-only pass. The blocks of the band are split into
+ * contiguous groups, one per thread, and the threads are pipelined over the
+ * tiles of 64 text columns: a group consumes the horizontal carries out of the
+ * group above a few columns after they are produced. At the end of each tile,
+ * the owner of the first band block decides the upper cut and the owner of the
+ * last one the lower cut (and the early exit); every group shifts its own blocks,
+ * taking the first block of the group below from its handoff. The band evolves
+ * exactly as in the serial pass, so the results are the same.
+ */
+#define BANDED_WAVEFRONT_MIN_BLOCKS 16          // Band blocks per thread, fewer make the threads wait more than they compute
+#define BANDED_WAVEFRONT_MIN_WORK   (1ll << 16) // Band blocks times tiles (one thread is faster below it)
+#define BANDED_WAVEFRONT_CHUNK      8           // Columns between two carry publications
+#define BANDED_WAVEFRONT_DONE       INT64_MAX   // Progress of a group with nothing left to compute
+
+typedef struct {
+    _Alignas(64) _Atomic int64_t columns_done; // Text columns whose carries into the next group are written
+    _Alignas(64) _Atomic int64_t tiles_done;   // Tiles computed, with their handoff and exceeds flag written
+    // Ring of tiles (tile % ring_length)
+    uint8_t *carries;             // PHout | MHout << 1 of the last block, 64 per tile
+    uint64_t *handoff_Pv;         // First block of the group after the tile
+    uint64_t *handoff_Mv;
+    int64_t *handoff_score_first; // Scores of the first and last blocks of the group after the tile
+    int64_t *handoff_score_last;
+    bool *exceeds;                // No block of the group can finish within early_exit_score
+    // Band blocks [lo, hi)
+    int64_t lo;
+    int64_t hi;
+    uint64_t cells;
+} banded_wavefront_group_t;
+
+// First or last band block of each tile, decided at the end of the previous tile by its owner
+typedef struct {
+    _Alignas(64) _Atomic int64_t tiles;       // Known for the tiles [0, tiles)
+    int64_t *values;                          // Ring of tiles
+} banded_wavefront_limit_t;
+
+typedef struct {
+    banded_matrix_t *banded_matrix;
+    const banded_pattern_t *banded_pattern;
+    const char *text;
+    int64_t text_length;
+    int64_t num_tiles;                        // Full tiles, each one ends shifting the band
+    int64_t tail_columns;                     // Columns after the last full tile
+    int64_t ring_length;                      // Tiles kept in the rings (more than between any two active groups)
+    banded_wavefront_limit_t first;
+    banded_wavefront_limit_t last;
+    _Alignas(64) _Atomic int64_t exit_tile;   // Tile where the band exceeded early_exit_score (-1 if none)
+    _Atomic int start;                        // Set once all the threads exist (-1: not all of them could be created)
+    int64_t exit_first;
+    int64_t exit_last;
+    int num_groups;
+    banded_wavefront_group_t *groups;
+} banded_wavefront_t;
+
+typedef struct {
+    banded_wavefront_t *wavefront;
+    int group;
+} banded_wavefront_thread_t;
+
+// Returns false if the pass exited early meanwhile
+static inline bool banded_wavefront_wait(
+    _Atomic int64_t *const progress,
+    const int64_t target,
+    banded_wavefront_t *const wavefront)
+{
+    uint64_t spins = 0;
+    while (atomic_load_explicit(progress, memory_order_acquire) < target)
+    {
+        if (atomic_load_explicit(&wavefront->exit_tile, memory_order_relaxed) >= 0) return false;
+        if ((++spins & 63) == 0) sched_yield();
+    }
+    return true;
+}
+
+/*
+ * Band limit of a tile clamped to [lo - 1, hi]: exact within [lo, hi), otherwise
+ * it only tells the side. A limit moves at most one block per tile, so the latest
+ * known one usually tells the side without waiting for the owner.
+ */
+static inline bool banded_wavefront_limit(
+    banded_wavefront_t *const wavefront,
+    banded_wavefront_limit_t *const limit,
+    const int64_t tile,
+    const int64_t lo,
+    const int64_t hi,
+    int64_t *const value)
+{
+    const int64_t ring_length = wavefront->ring_length;
+    const int64_t known = atomic_load_explicit(&limit->tiles, memory_order_acquire);
+    if (known <= tile)
+    {
+        const int64_t latest = limit->values[(known - 1) % ring_length];
+        const int64_t moves = tile - (known - 1);
+        if (latest + moves < lo)
+        {
+            *value = lo - 1;
+            return true;
+        }
+        if (latest - moves >= hi)
+        {
+            *value = hi;
+            return true;
+        }
+        if (!banded_wavefront_wait(&limit->tiles, tile + 1, wavefront)) return false;
+    }
+    *value = MIN(MAX(limit->values[tile % ring_length], lo - 1), hi);
+    return true;
+}
+
+static inline void banded_wavefront_limit_publish(
+    banded_wavefront_t *const wavefront,
+    banded_wavefront_limit_t *const limit,
+    const int64_t tile,
+    const int64_t value)
+{
+    limit->values[tile % wavefront->ring_length] = value;
+    atomic_store_explicit(&limit->tiles, tile + 1, memory_order_release);
+}
+
+static void banded_wavefront_group_finish(
+    banded_wavefront_group_t *const group)
+{
+    atomic_store_explicit(&group->columns_done, BANDED_WAVEFRONT_DONE, memory_order_release);
+    atomic_store_explicit(&group->tiles_done, BANDED_WAVEFRONT_DONE, memory_order_release);
+}
+
+static void banded_wavefront_group_compute(
+    banded_wavefront_t *const wavefront,
+    const int g)
+{
+    banded_matrix_t *const banded_matrix = wavefront->banded_matrix;
+    const banded_pattern_t *const banded_pattern = wavefront->banded_pattern;
+    const char *const text = wavefront->text;
+    banded_wavefront_group_t *const group = &wavefront->groups[g];
+    banded_wavefront_group_t *const prev = (g > 0) ? &wavefront->groups[g - 1] : NULL;
+    banded_wavefront_group_t *const next = (g + 1 < wavefront->num_groups) ? &wavefront->groups[g + 1] : NULL;
+    const int64_t lo = group->lo;
+    const int64_t hi = group->hi;
+    const int64_t ring_length = wavefront->ring_length;
+
+    // Pattern variables
+    const uint64_t *const PEQ = banded_pattern->PEQ;
+    const uint64_t PEQ_row_stride = banded_pattern->PEQ_row_stride;
+    const uint64_t *const level_mask = banded_pattern->level_mask;
+    const int64_t num_block_rows = DIV_CEIL(banded_pattern->pattern_length, BPM_W64_LENGTH);
+    uint64_t *const Pv = banded_matrix->Pv;
+    uint64_t *const Mv = banded_matrix->Mv;
+    int64_t *const scores = banded_matrix->scores;
+    const int64_t prologue_columns = banded_matrix->prolog_column_blocks;
+    const int64_t finish_v_pos_inside_band = prologue_columns * BPM_W64_LENGTH + banded_matrix->sequence_length_diff;
+    const int64_t cutoff_score = banded_matrix->cutoff_score;
+    const int64_t early_exit_score = banded_matrix->early_exit_score;
+
+    for (int64_t k = 0; k <= wavefront->num_tiles; ++k)
+    {
+        const bool full_tile = (k < wavefront->num_tiles);
+        const int64_t num_columns = full_tile ? BPM_W64_LENGTH : wavefront->tail_columns;
+        if (num_columns == 0) break;
+        const int64_t pos_v = k - prologue_columns;
+        const int64_t slot = k % ring_length;
+
+        int64_t first, last;
+        if (!banded_wavefront_limit(wavefront, &wavefront->first, k, lo, hi, &first) ||
+            !banded_wavefront_limit(wavefront, &wavefront->last, k, lo, hi, &last)) return;
+        // The last block only moves up, and the first one only down after the prologue.
+        // Groups leave from the edges of the band inwards, so that the active ones stay in step
+        if (last < lo)
+        {
+            if (next != NULL && !banded_wavefront_wait(&next->tiles_done, BANDED_WAVEFRONT_DONE, wavefront)) return;
+            break;
+        }
+        if (first >= hi && k >= prologue_columns)
+        {
+            if (prev != NULL && !banded_wavefront_wait(&prev->tiles_done, BANDED_WAVEFRONT_DONE, wavefront)) return;
+            break;
+        }
+
+        const int64_t first_block_v = MAX(lo, first);
+        const int64_t last_block_v = MIN(hi - 1, last);
+        const bool carried = (first < lo); // The group above feeds the first block
+
+        // Advance the blocks of the group, a chunk of columns at a time
+        for (int64_t column = 0; column < num_columns; column += BANDED_WAVEFRONT_CHUNK)
+        {
+            const int64_t column_end = MIN(column + BANDED_WAVEFRONT_CHUNK, num_columns);
+            if (carried && !banded_wavefront_wait(&prev->columns_done, k * BPM_W64_LENGTH + column_end, wavefront)) return;
+            for (int64_t c = column; c < column_end; ++c)
+            {
+                const uint8_t enc_char = (uint8_t)text[k * BPM_W64_LENGTH + c];
+                const uint64_t *const PEQ_row = PEQ + BPM_PATTERN_PEQ_ROW_IDX(0, enc_char, PEQ_row_stride);
+                const uint8_t carry = carried ? prev->carries[slot * BPM_W64_LENGTH + c] : 1;
+                uint64_t PHin = carry & 1, MHin = carry >> 1, PHout, MHout;
+                for (int64_t i = first_block_v; i <= last_block_v; ++i)
+                {
+                    uint64_t Pv_in = Pv[i];
+                    uint64_t Mv_in = Mv[i];
+                    const uint64_t mask = level_mask[i + pos_v];
+                    const uint64_t Eq = PEQ_row[i + pos_v];
+                    BPM_ADVANCE_BLOCK(Eq, mask, Pv_in, Mv_in, PHin, MHin, PHout, MHout);
+                    Pv[i] = Pv_in;
+                    Mv[i] = Mv_in;
+                    PHin = PHout;
+                    MHin = MHout;
+                    scores[i + pos_v] = scores[i + pos_v] + PHout - MHout;
+                }
+                group->carries[slot * BPM_W64_LENGTH + c] = (uint8_t)(PHin | (MHin << 1));
+            }
+            atomic_store_explicit(&group->columns_done, k * BPM_W64_LENGTH + column_end, memory_order_release);
+        }
+        if (first_block_v <= last_block_v)
+        {
+            group->cells += (last_block_v - first_block_v + 1) * BPM_W64_LENGTH * num_columns;
+        }
+        if (!full_tile) break;
+
+        // Handoff to the neighbours, before any block is shifted (only read while the group is in the band)
+        if (first_block_v <= last_block_v && first_block_v == lo)
+        {
+            group->handoff_Pv[slot] = Pv[lo];
+            group->handoff_Mv[slot] = Mv[lo];
+            group->handoff_score_first[slot] = scores[lo + pos_v];
+        }
+        if (first_block_v <= last_block_v && last_block_v == hi - 1)
+        {
+            group->handoff_score_last[slot] = scores[hi - 1 + pos_v];
+        }
+        group->exceeds[slot] = (first_block_v > last_block_v) || (early_exit_score >= 0 &&
+            banded_band_exceeds(scores, first_block_v, last_block_v, pos_v, banded_pattern->pattern_length,
+                                wavefront->text_length, (k + 1) * BPM_W64_LENGTH, early_exit_score, false));
+        atomic_store_explicit(&group->tiles_done, k + 1, memory_order_release);
+        // Neighbours stay within a tile of each other, so that the rings are never overrun
+        if (prev != NULL && !banded_wavefront_wait(&prev->tiles_done, k, wavefront)) return;
+        if (next != NULL && !banded_wavefront_wait(&next->tiles_done, k, wavefront)) return;
+
+        // Owner of the first block: upper cut
+        if (lo <= first && first < hi)
+        {
+            int64_t score_below;
+            if (first + 1 == hi && next != NULL)
+            {
+                if (!banded_wavefront_wait(&next->tiles_done, k + 1, wavefront)) return;
+                score_below = next->handoff_score_first[slot];
+            }
+            else
+            {
+                score_below = scores[first + 1 + pos_v];
+            }
+            int64_t last_bound;
+            if (!banded_wavefront_limit(wavefront, &wavefront->last, k, first + 3, INT64_MAX / 2, &last_bound)) return;
+            const bool cut_band_lower = (first + 2 < last_bound) && (finish_v_pos_inside_band > BPM_W64_LENGTH * (first + 1)) &&
+                                        (score_below + (finish_v_pos_inside_band - BPM_W64_LENGTH * (first + 1))) > cutoff_score;
+            int64_t next_first = first;
+            if (cut_band_lower && (k >= prologue_columns)) next_first++;
+            else if (!cut_band_lower && (k < prologue_columns)) next_first--;
+            banded_wavefront_limit_publish(wavefront, &wavefront->first, k + 1, next_first);
+        }
+
+        // Shift the blocks of the group one position (the band moves one block down)
+        int64_t next_first;
+        if (!banded_wavefront_limit(wavefront, &wavefront->first, k + 1, lo, hi, &next_first)) return;
+        const int64_t shift_begin = MAX(lo, next_first);
+        const int64_t shift_end = MIN(hi, last) - 1;
+        for (int64_t j = shift_begin; j <= shift_end; ++j)
+        {
+            if (j + 1 < hi)
+            {
+                Pv[j] = Pv[j + 1];
+                Mv[j] = Mv[j + 1];
+            }
+            else
+            {
+                if (!banded_wavefront_wait(&next->tiles_done, k + 1, wavefront)) return;
+                Pv[j] = next->handoff_Pv[slot];
+                Mv[j] = next->handoff_Mv[slot];
+            }
+        }
+
+        // Owner of the last block: early exit, new block and lower cut
+        if (lo <= last && last < hi)
+        {
+            if (early_exit_score >= 0)
+            {
+                bool exceeds = true;
+                for (int u = 0; u < wavefront->num_groups && exceeds; ++u)
+                {
+                    if (!banded_wavefront_wait(&wavefront->groups[u].tiles_done, k + 1, wavefront)) return;
+                    exceeds = (atomic_load_explicit(&wavefront->groups[u].tiles_done, memory_order_acquire) == BANDED_WAVEFRONT_DONE) ||
+                              wavefront->groups[u].exceeds[slot];
+                }
+                if (exceeds)
+                {
+                    banded_wavefront_limit(wavefront, &wavefront->first, k, 0, INT64_MAX / 2, &wavefront->exit_first);
+                    wavefront->exit_last = last;
+                    atomic_store_explicit(&wavefront->exit_tile, k, memory_order_release);
+                    return;
+                }
+            }
+
+            // The row of the first block of the group is the group above's from the next tile on: its score is read from the handoff
+            Pv[last] = BPM_W64_ONES;
+            Mv[last] = 0;
+            scores[last + pos_v + 1] = ((last == lo) ? group->handoff_score_first[slot] : scores[last + pos_v]) + BPM_W64_LENGTH;
+
+            int64_t score_above;
+            if (last == lo && prev != NULL)
+            {
+                if (!banded_wavefront_wait(&prev->tiles_done, k + 1, wavefront)) return;
+                score_above = prev->handoff_score_last[slot];
+            }
+            else if (last - 1 == lo)
+            {
+                score_above = group->handoff_score_first[slot];
+            }
+            else
+            {
+                score_above = (last > 0) ? scores[last - 1 + pos_v] : 0;
+            }
+            int64_t first_bound;
+            if (!banded_wavefront_limit(wavefront, &wavefront->first, k + 1, 0, last - 2, &first_bound)) return;
+            const bool cut_band_higher = (first_bound < last - 2) && (BPM_W64_LENGTH * (last - 1) > finish_v_pos_inside_band) &&
+                                         (score_above + (BPM_W64_LENGTH * (last - 1) - finish_v_pos_inside_band)) > cutoff_score;
+            const int64_t next_last = (cut_band_higher || (pos_v + last >= num_block_rows)) ? last - 1 : last;
+            banded_wavefront_limit_publish(wavefront, &wavefront->last, k + 1, next_last);
+        }
+    }
+    banded_wavefront_group_finish(group);
+}
+
+static void* banded_wavefront_thread(
+    void *arg)
+{
+    banded_wavefront_thread_t *const thread = (banded_wavefront_thread_t*) arg;
+    banded_wavefront_t *const wavefront = thread->wavefront;
+    int start;
+    while ((start = atomic_load_explicit(&wavefront->start, memory_order_acquire)) == 0) sched_yield();
+    if (start > 0) banded_wavefront_group_compute(wavefront, thread->group);
+    return NULL;
+}
+
+// Returns false (nothing computed) if the band is too narrow or the text too short to pay off
+static bool bpm_compute_matrix_banded_cutoff_score_wavefront(
     banded_matrix_t *const banded_matrix,
     const banded_pattern_t *const banded_pattern,
     const char* text,
-    const int64_t text_length)
+    const int64_t text_length,
+    const int64_t text_finish_pos,
+    const int num_threads)
+{
+    const int64_t effective_bandwidth_blocks = banded_matrix->effective_bandwidth_blocks;
+    const int64_t num_tiles = text_finish_pos / BPM_W64_LENGTH;
+    const int num_groups = (int) MIN((int64_t)num_threads, effective_bandwidth_blocks / BANDED_WAVEFRONT_MIN_BLOCKS);
+    if (num_groups < 2 || effective_bandwidth_blocks * num_tiles < BANDED_WAVEFRONT_MIN_WORK ||
+        banded_matrix->ends_free || effective_bandwidth_blocks < banded_matrix->prolog_column_blocks + 1)
+    {
+        return false;
+    }
+
+    // Rings and threads
+    const int64_t ring_length = 4 * num_groups + 8; // Active groups are less than 2 tiles apart per group
+    banded_wavefront_t wavefront = {
+        .banded_matrix = banded_matrix,
+        .banded_pattern = banded_pattern,
+        .text = text,
+        .text_length = text_length,
+        .num_tiles = num_tiles,
+        .tail_columns = text_finish_pos % BPM_W64_LENGTH,
+        .ring_length = ring_length,
+        .num_groups = num_groups,
+    };
+    const uint64_t ring_size = ring_length * (BPM_W64_LENGTH + 4 * UINT64_SIZE + 1);
+    void *const memory = calloc(1, num_groups * (sizeof(banded_wavefront_group_t) + ring_size) + 2 * ring_length * UINT64_SIZE + 64);
+    pthread_t *const threads = (pthread_t*) malloc(num_groups * sizeof(pthread_t));
+    banded_wavefront_thread_t *const thread_args = (banded_wavefront_thread_t*) malloc(num_groups * sizeof(banded_wavefront_thread_t));
+    if (memory == NULL || threads == NULL || thread_args == NULL)
+    {
+        free(memory);
+        free(threads);
+        free(thread_args);
+        return false;
+    }
+    wavefront.groups = (banded_wavefront_group_t*) (((uintptr_t)memory + 63) & ~(uintptr_t)63);
+    char *ring_memory = (char*) (wavefront.groups + num_groups);
+    wavefront.first.values = (int64_t*) ring_memory;
+    wavefront.last.values = wavefront.first.values + ring_length;
+    ring_memory += 2 * ring_length * UINT64_SIZE;
+    for (int g = 0; g < num_groups; ++g)
+    {
+        banded_wavefront_group_t *const group = &wavefront.groups[g];
+        group->handoff_Pv = (uint64_t*) ring_memory;
+        group->handoff_Mv = group->handoff_Pv + ring_length;
+        group->handoff_score_first = (int64_t*) (group->handoff_Mv + ring_length);
+        group->handoff_score_last = group->handoff_score_first + ring_length;
+        group->carries = (uint8_t*) (group->handoff_score_last + ring_length);
+        group->exceeds = (bool*) (group->carries + ring_length * BPM_W64_LENGTH);
+        ring_memory += ring_size;
+        group->lo = (effective_bandwidth_blocks * g) / num_groups;
+        group->hi = (effective_bandwidth_blocks * (g + 1)) / num_groups;
+        group->cells = 0;
+        atomic_init(&group->columns_done, 0);
+        atomic_init(&group->tiles_done, 0);
+    }
+    wavefront.first.values[0] = banded_matrix->prolog_column_blocks;
+    wavefront.last.values[0] = effective_bandwidth_blocks - 1;
+    atomic_init(&wavefront.first.tiles, 1);
+    atomic_init(&wavefront.last.tiles, 1);
+    atomic_init(&wavefront.exit_tile, -1);
+    atomic_init(&wavefront.start, 0);
+
+    bpm_reset_search(effective_bandwidth_blocks, banded_matrix->Pv, banded_matrix->Mv, banded_matrix->scores);
+
+    // The calling thread computes the first group
+    int num_spawned = 0;
+    for (; num_spawned < num_groups - 1; num_spawned++)
+    {
+        thread_args[num_spawned] = (banded_wavefront_thread_t){.wavefront = &wavefront, .group = num_spawned + 1};
+        if (pthread_create(&threads[num_spawned], NULL, banded_wavefront_thread, &thread_args[num_spawned]) != 0) break;
+    }
+    const bool started = (num_spawned == num_groups - 1);
+    atomic_store_explicit(&wavefront.start, started ? 1 : -1, memory_order_release);
+    if (started) banded_wavefront_group_compute(&wavefront, 0);
+    for (int i = 0; i < num_spawned; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    free(thread_args);
+    if (!started)
+    {
+        free(memory);
+        return false;
+    }
+
+    // Results
+    for (int g = 0; g < num_groups; ++g)
+    {
+        banded_matrix->cells += wavefront.groups[g].cells;
+    }
+    if (atomic_load(&wavefront.exit_tile) >= 0)
+    {
+        banded_set_early_exit(banded_matrix, wavefront.exit_first, wavefront.exit_last);
+    }
+    else
+    {
+        const uint64_t pattern_length = banded_pattern->pattern_length;
+        if (pattern_length % BPM_W64_LENGTH)
+        {
+            banded_matrix->cigar->score = banded_matrix->scores[pattern_length / BPM_W64_LENGTH] - (BPM_W64_LENGTH - (pattern_length % BPM_W64_LENGTH));
+        }
+        else
+        {
+            banded_matrix->cigar->score = banded_matrix->scores[(pattern_length - 1) / BPM_W64_LENGTH];
+        }
+        banded_matrix->higher_block = wavefront.last.values[num_tiles % ring_length];
+        banded_matrix->lower_block = wavefront.first.values[num_tiles % ring_length];
+    }
+    free(memory);
+    return true;
+}
+
+static inline __attribute__((always_inline)) void banded_backtrace_matrix_cutoff_emit(
+    banded_matrix_t *const banded_matrix,
+    const banded_pattern_t *const banded_pattern,
+    const char* text,
+    const int64_t text_length,
+    const bool packed)
 {
     // Parameters
     const char* pattern = banded_pattern->pattern;
     const uint64_t pattern_length = banded_pattern->pattern_length;
     const uint64_t *const Pv = banded_matrix->Pv;
     const uint64_t *const Mv = banded_matrix->Mv;
-    char *const operations = banded_matrix->cigar->operations;
-    int op_sentinel = banded_matrix->cigar->end_offset - 1;
+    cigar_t *const cigar = banded_matrix->cigar;
+    int op_sentinel = cigar->end_offset - 1;
     const int effective_bandwidth_blocks = banded_matrix->effective_bandwidth_blocks;
     const int64_t prologue_columns = banded_matrix->prolog_column_blocks;
 
     // Retrieve the alignment. Store the match
     const uint64_t num_words64 = effective_bandwidth_blocks;
-    int64_t h = text_length - 1;
+    int64_t h = banded_matrix->text_end - 1;
     int64_t v = pattern_length - 1;
+    UNUSED(text_length);
+    int score = 0;
 
     while (v >= 0 && h >= 0)
     {
@@ -1004,53 +1950,100 @@ void banded_backtrace_matrix_cutoff(
         // CIGAR operation Test
         if (Pv[bdp_idx_r] & mask_r)
         {
-            operations[op_sentinel--] = 'D';
+            bpm_backtrace_push(cigar, &op_sentinel, packed, 'D', SAM_CIGAR_DEL);
+            score++;
             --v;
         }
         else if (Mv[(bdp_idx)] & mask)
         {
-            operations[op_sentinel--] = 'I';
+            bpm_backtrace_push(cigar, &op_sentinel, packed, 'I', SAM_CIGAR_INS);
+            score++;
             --h;
         }
         else if ((text[h] == pattern[v]))
         {
-            operations[op_sentinel--] = 'M';
+            bpm_backtrace_push(cigar, &op_sentinel, packed, 'M', SAM_CIGAR_EQ);
             --h;
             --v;
         }
         else
         {
-            operations[op_sentinel--] = 'X';
+            bpm_backtrace_push(cigar, &op_sentinel, packed, 'X', SAM_CIGAR_X);
+            score++;
             --h;
             --v;
         }
     }
+    if (banded_matrix->ends_free)
+    { // Leading text gaps are free
+        banded_matrix->text_begin = h + 1;
+        h = -1;
+    }
     while (h >= 0)
     {
-        operations[op_sentinel--] = 'I';
+        bpm_backtrace_push(cigar, &op_sentinel, packed, 'I', SAM_CIGAR_INS);
+        score++;
         --h;
     }
     while (v >= 0)
     {
-        operations[op_sentinel--] = 'D';
+        bpm_backtrace_push(cigar, &op_sentinel, packed, 'D', SAM_CIGAR_DEL);
+        score++;
         --v;
     }
-    banded_matrix->cigar->begin_offset = op_sentinel + 1;
+    if (packed)
+    {
+        cigar_reverse_CIGAR(cigar);
+    }
+    cigar->begin_offset = op_sentinel + 1;
+    cigar->score = score;
+}
+
+void banded_backtrace_matrix_cutoff(
+    banded_matrix_t *const banded_matrix,
+    const banded_pattern_t *const banded_pattern,
+    const char* text,
+    const int64_t text_length)
+{
+    if (banded_matrix->packed_cigar)
+    {
+        banded_backtrace_matrix_cutoff_emit(banded_matrix, banded_pattern, text, text_length, true);
+    }
+    else
+    {
+        banded_backtrace_matrix_cutoff_emit(banded_matrix, banded_pattern, text, text_length, false);
+    }
 }
 
 void banded_compute(
     banded_matrix_t *const banded_matrix,
-    banded_pattern_t *const banded_pattern,
+    const banded_pattern_t *const banded_pattern,
     const char* text,
     const int64_t text_length,
     const int64_t text_finish_pos,
     const bool only_score,
     const bool force_scalar)
 {
-    if (only_score)
+    if (only_score && banded_matrix->ends_free)
+    { // The SIMD kernels only compute the final cell: track the last row one column at a time
+        UNUSED(force_scalar);
+        bpm_compute_matrix_banded_cutoff(banded_matrix, banded_pattern, text, text_finish_pos, true);
+    }
+    else if (only_score && banded_matrix->num_threads > 1 &&
+             bpm_compute_matrix_banded_cutoff_score_wavefront(banded_matrix, banded_pattern, text, text_length, text_finish_pos,
+                                                              banded_matrix->num_threads))
+    {
+        UNUSED(force_scalar); // Computed by the wavefront threads
+    }
+    else if (only_score)
     {
-        #ifdef __AVX2__
-        if (!force_scalar)
+        #ifdef QUICKED_SIMD_X86
+        const quicked_simd_t simd = (force_scalar) ? QUICKED_SIMD_SCALAR : quicked_cpu_simd();
+        if (simd >= QUICKED_SIMD_AVX512)
+        {
+            bpm_compute_matrix_banded_cutoff_score_avx512(banded_matrix, banded_pattern, text, text_length, text_finish_pos);
+        }
+        else if (simd >= QUICKED_SIMD_AVX2)
         {
             bpm_compute_matrix_banded_cutoff_score_avx(banded_matrix, banded_pattern, text, text_length, text_finish_pos);
         }
@@ -1064,9 +2057,12 @@ void banded_compute(
     else
     {
         // Fill Matrix (Pv,Mv)
-        bpm_compute_matrix_banded_cutoff(banded_matrix, banded_pattern, text, text_length);
+        bpm_compute_matrix_banded_cutoff(banded_matrix, banded_pattern, text, text_length, false);
 
-        // Backtrace and generate CIGAR
-        banded_backtrace_matrix_cutoff(banded_matrix, banded_pattern, text, text_length);
+        // Backtrace and generate CIGAR (the matrix is incomplete after an early exit)
+        if (!banded_matrix->early_exit)
+        {
+            banded_backtrace_matrix_cutoff(banded_matrix, banded_pattern, text, text_length);
+        }
     }
 }
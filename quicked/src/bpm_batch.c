@@ -0,0 +1,260 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "quicked_utils/include/commons.h"
+#include "quicked_utils/include/dna_text.h"
+#include "bpm_batch.h"
+#include "bpm_commons.h"
+#include "quicked_cpu.h"
+#include "quicked_encode.h"
+#include <string.h>
+
+#ifdef QUICKED_SIMD_X86
+#include <immintrin.h>
+#endif
+
+/*
+ * Pairs of a batch, interleaved lane by lane: the values of all the lanes for
+ * the same block (and character, or text position) are contiguous.
+ */
+typedef struct {
+    uint64_t lanes;
+    uint64_t num_blocks;        // Of the longest pattern
+    uint64_t max_text_length;
+    uint64_t PEQ[BPM_BATCH_MAX_BLOCKS * BPM_ALPHABET_LENGTH * BPM_BATCH_MAX_LANES];
+    uint64_t level_mask[BPM_BATCH_MAX_BLOCKS * BPM_BATCH_MAX_LANES];
+    uint64_t last_block[BPM_BATCH_MAX_BLOCKS * BPM_BATCH_MAX_LANES];   // All ones in the lanes whose pattern ends in the block
+    int64_t score[BPM_BATCH_MAX_LANES];                                 // Score of the first column (pattern length)
+    int64_t text_end[BPM_BATCH_MAX_LANES];                              // Last text position (-1 in empty lanes)
+    uint8_t text[BPM_BATCH_MAX_BLOCKS * BPM_W64_LENGTH * BPM_BATCH_MAX_LANES];
+} bpm_batch_t;
+
+uint64_t bpm_batch_lanes(
+    const quicked_simd_t simd)
+{
+    #ifdef QUICKED_SIMD_X86
+    if (simd >= QUICKED_SIMD_AVX512) return 8;
+    if (simd >= QUICKED_SIMD_AVX2) return 4;
+    #endif
+    UNUSED(simd);
+    return 0;
+}
+
+bool bpm_batch_fits(
+    const int pattern_length,
+    const int text_length)
+{
+    const int max_length = BPM_BATCH_MAX_BLOCKS * BPM_W64_LENGTH;
+    return pattern_length > 0 && pattern_length <= max_length &&
+           text_length > 0 && text_length <= max_length;
+}
+
+static void bpm_batch_setup(
+    bpm_batch_t *const batch,
+    const char **patterns,
+    const int *pattern_lengths,
+    const char **texts,
+    const int *text_lengths,
+    const uint64_t num_pairs,
+    const uint64_t lanes,
+    const quicked_simd_t simd)
+{
+    batch->lanes = lanes;
+    batch->num_blocks = 0;
+    batch->max_text_length = 0;
+    for (uint64_t l = 0; l < num_pairs; l++)
+    {
+        batch->num_blocks = MAX(batch->num_blocks, DIV_CEIL((uint64_t)pattern_lengths[l], BPM_W64_LENGTH));
+        batch->max_text_length = MAX(batch->max_text_length, (uint64_t)text_lengths[l]);
+    }
+
+    // Empty lanes match nothing
+    memset(batch->PEQ, 0, batch->num_blocks * BPM_ALPHABET_LENGTH * lanes * BPM_W64_SIZE);
+    memset(batch->last_block, 0, batch->num_blocks * lanes * BPM_W64_SIZE);
+    for (uint64_t i = 0; i < batch->num_blocks * lanes; i++)
+    {
+        batch->level_mask[i] = BPM_W64_MASK;
+    }
+    memset(batch->text, ENC_DNA_CHAR_N, batch->max_text_length * lanes);
+
+    for (uint64_t l = 0; l < lanes; l++)
+    {
+        batch->score[l] = 0;
+        batch->text_end[l] = -1;
+    }
+
+    uint8_t encoded[BPM_BATCH_MAX_BLOCKS * BPM_W64_LENGTH];
+    uint64_t PEQ[BPM_BATCH_MAX_BLOCKS * BPM_ALPHABET_LENGTH];
+    for (uint64_t l = 0; l < num_pairs; l++)
+    {
+        // Pattern
+        const uint64_t pattern_length = pattern_lengths[l];
+        const uint64_t num_blocks = DIV_CEIL(pattern_length, BPM_W64_LENGTH);
+        quicked_encode_ascii(patterns[l], pattern_length, encoded, simd);
+        bpm_pattern_compile_peq(PEQ, (const char *)encoded, pattern_length, simd);
+        for (uint64_t i = 0; i < num_blocks * BPM_ALPHABET_LENGTH; ++i)
+        {
+            batch->PEQ[i * lanes + l] = PEQ[i];
+        }
+        batch->level_mask[(num_blocks - 1) * lanes + l] = 1ull << ((pattern_length - 1) % BPM_W64_LENGTH);
+        batch->last_block[(num_blocks - 1) * lanes + l] = BPM_W64_ONES;
+        batch->score[l] = pattern_length;
+
+        // Text
+        const uint64_t text_length = text_lengths[l];
+        quicked_encode_ascii(texts[l], text_length, encoded, simd);
+        for (uint64_t j = 0; j < text_length; ++j)
+        {
+            batch->text[j * lanes + l] = encoded[j];
+        }
+        batch->text_end[l] = text_length - 1;
+    }
+}
+
+#ifdef QUICKED_SIMD_X86
+QUICKED_TARGET("avx2")
+static void bpm_batch_compute_score_avx2(
+    const bpm_batch_t *const batch,
+    int64_t *const scores)
+{
+    const uint64_t num_blocks = batch->num_blocks;
+    __m256i Pv[BPM_BATCH_MAX_BLOCKS], Mv[BPM_BATCH_MAX_BLOCKS];
+    for (uint64_t b = 0; b < num_blocks; b++)
+    {
+        Pv[b] = _mm256_set1_epi64x(BPM_W64_ONES);
+        Mv[b] = _mm256_setzero_si256();
+    }
+
+    const __m256i ones = _mm256_set1_epi64x(1);
+    const __m256i lane_idx = _mm256_set_epi64x(3, 2, 1, 0);
+    const __m256i text_end = _mm256_loadu_si256((const __m256i*)batch->text_end);
+    __m256i score = _mm256_loadu_si256((const __m256i*)batch->score);
+    __m256i final_score = score;
+
+    for (uint64_t j = 0; j < batch->max_text_length; j++)
+    {
+        // PEQ index of each lane: character * lanes + lane
+        int32_t chars;
+        memcpy(&chars, &batch->text[j * 4], sizeof(chars));
+        __m256i Eq_idx = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(chars));
+        Eq_idx = _mm256_add_epi64(_mm256_slli_epi64(Eq_idx, 2), lane_idx);
+
+        __m256i PHin = ones, MHin = _mm256_setzero_si256();
+        for (uint64_t b = 0; b < num_blocks; b++)
+        {
+            const __m256i Eq = _mm256_i64gather_epi64((const long long*)&batch->PEQ[BPM_PATTERN_PEQ_IDX(b, 0) * 4], Eq_idx, 8);
+            const __m256i mask = _mm256_loadu_si256((const __m256i*)&batch->level_mask[b * 4]);
+            __m256i PHout, MHout;
+            BPM_ADVANCE_BLOCK_SI256(Eq, mask, Pv[b], Mv[b], PHin, MHin, PHout, MHout);
+            const __m256i last_block = _mm256_loadu_si256((const __m256i*)&batch->last_block[b * 4]);
+            score = _mm256_add_epi64(score, _mm256_and_si256(_mm256_sub_epi64(PHout, MHout), last_block));
+            PHin = PHout;
+            MHin = MHout;
+        }
+
+        // Keep the score of the lanes whose text ends here
+        const __m256i done = _mm256_cmpeq_epi64(text_end, _mm256_set1_epi64x(j));
+        final_score = _mm256_blendv_epi8(final_score, score, done);
+    }
+
+    _mm256_storeu_si256((__m256i*)scores, final_score);
+}
+
+QUICKED_TARGET("avx512f")
+static void bpm_batch_compute_score_avx512(
+    const bpm_batch_t *const batch,
+    int64_t *const scores)
+{
+    const uint64_t num_blocks = batch->num_blocks;
+    __m512i Pv[BPM_BATCH_MAX_BLOCKS], Mv[BPM_BATCH_MAX_BLOCKS];
+    __mmask8 last_block[BPM_BATCH_MAX_BLOCKS];
+    for (uint64_t b = 0; b < num_blocks; b++)
+    {
+        Pv[b] = _mm512_set1_epi64(BPM_W64_ONES);
+        Mv[b] = _mm512_setzero_si512();
+        const __m512i last_block_lanes = _mm512_loadu_si512((const void*)&batch->last_block[b * 8]);
+        last_block[b] = _mm512_test_epi64_mask(last_block_lanes, last_block_lanes);
+    }
+
+    const __m512i ones = _mm512_set1_epi64(1);
+    const __m512i lane_idx = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+    const __m512i text_end = _mm512_loadu_si512((const void*)batch->text_end);
+    __m512i score = _mm512_loadu_si512((const void*)batch->score);
+    __m512i final_score = score;
+
+    for (uint64_t j = 0; j < batch->max_text_length; j++)
+    {
+        // PEQ index of each lane: character * lanes + lane
+        __m512i Eq_idx = _mm512_cvtepu8_epi64(_mm_loadl_epi64((const __m128i*)&batch->text[j * 8]));
+        Eq_idx = _mm512_add_epi64(_mm512_slli_epi64(Eq_idx, 3), lane_idx);
+
+        __mmask8 PHin = 0xFF, MHin = 0;
+        for (uint64_t b = 0; b < num_blocks; b++)
+        {
+            const __m512i Eq = _mm512_i64gather_epi64(Eq_idx, (const void*)&batch->PEQ[BPM_PATTERN_PEQ_IDX(b, 0) * 8], 8);
+            const __m512i mask = _mm512_loadu_si512((const void*)&batch->level_mask[b * 8]);
+            __mmask8 PHout, MHout;
+            BPM_ADVANCE_BLOCK_SI512(Eq, mask, ones, Pv[b], Mv[b], PHin, MHin, PHout, MHout);
+            score = _mm512_mask_add_epi64(score, PHout & last_block[b], score, ones);
+            score = _mm512_mask_sub_epi64(score, MHout & last_block[b], score, ones);
+            PHin = PHout;
+            MHin = MHout;
+        }
+
+        // Keep the score of the lanes whose text ends here
+        const __mmask8 done = _mm512_cmpeq_epi64_mask(text_end, _mm512_set1_epi64(j));
+        final_score = _mm512_mask_mov_epi64(final_score, done, score);
+    }
+
+    _mm512_storeu_si512((void*)scores, final_score);
+}
+#endif
+
+void bpm_batch_compute_score(
+    const char **patterns,
+    const int *pattern_lengths,
+    const char **texts,
+    const int *text_lengths,
+    const uint64_t num_pairs,
+    int64_t *scores,
+    const quicked_simd_t simd)
+{
+    const uint64_t lanes = bpm_batch_lanes(simd);
+    bpm_batch_t batch;
+    bpm_batch_setup(&batch, patterns, pattern_lengths, texts, text_lengths, num_pairs, lanes, simd);
+
+    int64_t lane_scores[BPM_BATCH_MAX_LANES];
+    #ifdef QUICKED_SIMD_X86
+    if (lanes == 8)
+    {
+        bpm_batch_compute_score_avx512(&batch, lane_scores);
+    }
+    else
+    {
+        bpm_batch_compute_score_avx2(&batch, lane_scores);
+    }
+    #endif
+
+    memcpy(scores, lane_scores, num_pairs * sizeof(int64_t));
+}
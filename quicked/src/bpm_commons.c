@@ -0,0 +1,160 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "quicked_utils/include/commons.h"
+#include "bpm_commons.h"
+#include "quicked_cpu.h"
+
+#ifdef QUICKED_SIMD_X86
+#include <immintrin.h>
+#endif
+
+static void bpm_pattern_compile_peq_block(
+    uint64_t *const PEQ,
+    const uint64_t block_stride,
+    const uint64_t char_stride,
+    const char* pattern,
+    const uint64_t pattern_length,
+    const uint64_t block)
+{
+    uint64_t PEQ_block[BPM_ALPHABET_LENGTH] = {0};
+    const uint64_t begin = block * BPM_W64_LENGTH;
+    const uint64_t end = MIN(begin + BPM_W64_LENGTH, pattern_length);
+    for (uint64_t i = begin; i < end; ++i)
+    {
+        PEQ_block[(uint8_t)pattern[i]] |= 1ull << (i - begin);
+    }
+    if (end - begin < BPM_W64_LENGTH)
+    { // Padding
+        const uint64_t padding = BPM_W64_ONES << (end - begin);
+        for (uint64_t enc_char = 0; enc_char < BPM_ALPHABET_LENGTH; ++enc_char)
+        {
+            PEQ_block[enc_char] |= padding;
+        }
+    }
+    for (uint64_t enc_char = 0; enc_char < BPM_ALPHABET_LENGTH; ++enc_char)
+    {
+        PEQ[block * block_stride + enc_char * char_stride] = PEQ_block[enc_char];
+    }
+}
+
+#ifdef QUICKED_SIMD_X86
+// Full blocks only; returns the first block left
+QUICKED_TARGET("avx2")
+static uint64_t bpm_pattern_compile_peq_avx2(
+    uint64_t *const PEQ,
+    const uint64_t block_stride,
+    const uint64_t char_stride,
+    const char* pattern,
+    const uint64_t pattern_length)
+{
+    const uint64_t num_full_blocks = pattern_length / BPM_W64_LENGTH;
+    for (uint64_t block = 0; block < num_full_blocks; ++block)
+    {
+        const __m256i low = _mm256_loadu_si256((const __m256i *)&pattern[block * BPM_W64_LENGTH]);
+        const __m256i high = _mm256_loadu_si256((const __m256i *)&pattern[block * BPM_W64_LENGTH + 32]);
+        for (uint64_t enc_char = 0; enc_char < BPM_ALPHABET_LENGTH; ++enc_char)
+        {
+            const __m256i character = _mm256_set1_epi8(enc_char);
+            const uint32_t eq_low = _mm256_movemask_epi8(_mm256_cmpeq_epi8(low, character));
+            const uint32_t eq_high = _mm256_movemask_epi8(_mm256_cmpeq_epi8(high, character));
+            PEQ[block * block_stride + enc_char * char_stride] = ((uint64_t)eq_high << 32) | eq_low;
+        }
+    }
+    return num_full_blocks;
+}
+
+// All the blocks, the last one loaded with a mask
+QUICKED_TARGET("avx512f,avx512bw")
+static uint64_t bpm_pattern_compile_peq_avx512(
+    uint64_t *const PEQ,
+    const uint64_t block_stride,
+    const uint64_t char_stride,
+    const char* pattern,
+    const uint64_t pattern_length)
+{
+    const uint64_t num_words64 = DIV_CEIL(pattern_length, BPM_W64_LENGTH);
+    for (uint64_t block = 0; block < num_words64; ++block)
+    {
+        const uint64_t left = pattern_length - block * BPM_W64_LENGTH;
+        const __mmask64 valid = (left >= BPM_W64_LENGTH) ? BPM_W64_ONES : ~(BPM_W64_ONES << left);
+        const __m512i chars = _mm512_maskz_loadu_epi8(valid, &pattern[block * BPM_W64_LENGTH]);
+        for (uint64_t enc_char = 0; enc_char < BPM_ALPHABET_LENGTH; ++enc_char)
+        {
+            // Padding matches any character
+            const __mmask64 eq = _mm512_cmpeq_epi8_mask(chars, _mm512_set1_epi8(enc_char));
+            PEQ[block * block_stride + enc_char * char_stride] = eq | ~valid;
+        }
+    }
+    return num_words64;
+}
+#endif
+
+// PEQ entry (block, character) at block*block_stride + character*char_stride
+static void bpm_pattern_compile_peq_strided(
+    uint64_t *const PEQ,
+    const uint64_t block_stride,
+    const uint64_t char_stride,
+    const char* pattern,
+    const uint64_t pattern_length,
+    const quicked_simd_t simd)
+{
+    const uint64_t num_words64 = DIV_CEIL(pattern_length, BPM_W64_LENGTH);
+    uint64_t block = 0;
+    #ifdef QUICKED_SIMD_X86
+    if (simd >= QUICKED_SIMD_AVX512)
+    {
+        block = bpm_pattern_compile_peq_avx512(PEQ, block_stride, char_stride, pattern, pattern_length);
+    }
+    else if (simd >= QUICKED_SIMD_AVX2)
+    {
+        block = bpm_pattern_compile_peq_avx2(PEQ, block_stride, char_stride, pattern, pattern_length);
+    }
+    #else
+    UNUSED(simd);
+    #endif
+    for (; block < num_words64; ++block)
+    {
+        bpm_pattern_compile_peq_block(PEQ, block_stride, char_stride, pattern, pattern_length, block);
+    }
+}
+
+void bpm_pattern_compile_peq(
+    uint64_t *const PEQ,
+    const char* pattern,
+    const uint64_t pattern_length,
+    const quicked_simd_t simd)
+{
+    bpm_pattern_compile_peq_strided(PEQ, BPM_ALPHABET_LENGTH, 1, pattern, pattern_length, simd);
+}
+
+void bpm_pattern_compile_peq_rows(
+    uint64_t *const PEQ,
+    const uint64_t row_stride,
+    const char* pattern,
+    const uint64_t pattern_length,
+    const quicked_simd_t simd)
+{
+    bpm_pattern_compile_peq_strided(PEQ, 1, row_stride, pattern, pattern_length, simd);
+}
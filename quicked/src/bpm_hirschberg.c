@@ -28,21 +28,42 @@
 #include "quicked_utils/include/dna_text.h"
 #include "bpm_banded.h"
 #include "quicked.h"
+#include "bpm_hirschberg.h"
 #include "bpm_commons.h"
+#include "quicked_cpu.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
-quicked_status_t bpm_compute_matrix_hirschberg(
-    const char* text,
-    const char* text_r,
+/*
+ * Middle point of a Hirschberg division
+ */
+typedef struct {
+    int64_t text_length_left;
+    int64_t pattern_length_left;
+    int64_t score_left;
+    int64_t score_right;
+    uint64_t cells;
+} hirschberg_split_t;
+
+static void hirschberg_stats_add(
+    hirschberg_stats_t *const stats,
+    const uint64_t depth,
+    const uint64_t cells)
+{
+    // Parallel tasks share the same stats
+    #pragma omp critical(hirschberg_stats)
+    {
+        stats->max_depth = MAX(stats->max_depth, depth);
+        stats->cells += cells;
+    }
+}
+
+static uint64_t hirschberg_footprint(
     const int64_t text_length,
-    const char* pattern,
-    const char* pattern_r,
     const int64_t pattern_length,
-    const int64_t cutoff_score,
-    cigar_t *cigar_out,
-    const bool force_scalar,
-    mm_allocator_t *const mm_allocator)
+    const int64_t cutoff_score)
 {
-
     const int64_t k_end = ABS(((int64_t)text_length) - (int64_t)(pattern_length)) + 1;
     const int64_t cutoff_score_real = MAX(MAX(k_end, cutoff_score), 65);
     const int64_t sequence_length_diff = pattern_length - text_length;
@@ -60,128 +81,290 @@ quicked_status_t bpm_compute_matrix_hirschberg(
         effective_bandwidth_blocks = DIV_CEIL(relative_cutoff_score, BPM_W64_LENGTH) + 1 + prolog_column_blocks;
     }
 
-    uint64_t alignment_footprint = effective_bandwidth_blocks * text_length * BPM_W64_SIZE * 2;
+    return effective_bandwidth_blocks * text_length * BPM_W64_SIZE * 2;
+}
 
-    if (alignment_footprint > BUFFER_SIZE_16M)
-    { // divide the alignment in 2
+/*
+ * Distance between the first pattern_rows pattern bases and the text of a score-only
+ * pass, at its last column. The block holding row pattern_rows - 1 is inside the band,
+ * so its score is corrected by the vertical deltas of the rows below pattern_rows.
+ */
+static int64_t hirschberg_row_score(
+    const banded_matrix_t *const banded_matrix,
+    const int64_t pattern_rows,
+    const int64_t text_columns,
+    const int64_t first_block_band_pos_v)
+{
+    if (pattern_rows == 0)
+    {
+        return text_columns;
+    }
+    const int64_t block = (pattern_rows - 1) / BPM_W64_LENGTH;
+    const int64_t rows_in_block = pattern_rows - block * BPM_W64_LENGTH;
+    const uint64_t below = (rows_in_block == BPM_W64_LENGTH) ? 0 : BPM_W64_ONES << rows_in_block;
+    const int64_t band_block = block - first_block_band_pos_v;
+    return banded_matrix->scores[block] - POPCOUNT_64(banded_matrix->Pv[band_block] & below) +
+           POPCOUNT_64(banded_matrix->Mv[band_block] & below);
+}
 
-        const int64_t text_len = (text_length + 1) / 2;
-        const int64_t text_len_r = text_length - text_len;
-
-        const int64_t pattern_len = pattern_length;
-
-        banded_pattern_t banded_pattern;
-        banded_pattern_t banded_pattern_r;
-        banded_pattern_compile(
-            &banded_pattern, pattern,
-            pattern_length, mm_allocator);
-        banded_pattern_compile(
-            &banded_pattern_r, pattern_r,
-            pattern_length, mm_allocator);
-
-        banded_matrix_t banded_matrix, banded_matrix_r;
-
-        // Compute left side (for getting the central column)
-        banded_matrix_allocate(
-            &banded_matrix, pattern_length,
-            text_length, cutoff_score, SCORE_ONLY, mm_allocator);
-
-        banded_compute(
-            &banded_matrix, &banded_pattern, text,
-            text_length, text_len, SCORE_ONLY, force_scalar);
-
-        // Compute right side (for getting the central column)
-        banded_matrix_allocate(
-            &banded_matrix_r, pattern_length,
-            text_length, cutoff_score, SCORE_ONLY, mm_allocator);
-
-        banded_compute(
-            &banded_matrix_r, &banded_pattern_r, text_r,
-            text_length, text_len_r, SCORE_ONLY, force_scalar);
-
-        // vertival position of the first blocks computed on each aligments
-        int64_t first_block_band_pos_v = (text_len / BPM_W64_LENGTH) - (banded_matrix.prolog_column_blocks);
-        int64_t first_block_band_pos_v_r = (text_len_r / BPM_W64_LENGTH) - (banded_matrix.prolog_column_blocks);
-
-        // Higher and lower cell's position computen in each aligments
-        int64_t bottom_cell;
-        int64_t higher_cell, higher_cell_r;
-        int64_t starting_pos;
-        const int64_t bottom_pos = banded_matrix.lower_block * 64 + 63 + first_block_band_pos_v * 64;
-        const int64_t bottom_pos_r = (pattern_len - 1) - (banded_matrix_r.higher_block * 64 + 63 + first_block_band_pos_v_r * 64);
-        const int64_t higher_pos = banded_matrix.higher_block * 64 + 63 + first_block_band_pos_v * 64;
-        const int64_t higher_pos_r = (pattern_len - 1) - (banded_matrix_r.lower_block * 64 + 63 + first_block_band_pos_v_r * 64);
-
-        // TODO:: make it properly
-        if((bottom_pos > higher_pos_r) || (bottom_pos_r > higher_pos)){
-            banded_pattern_free(&banded_pattern, mm_allocator);
-            banded_pattern_free(&banded_pattern_r, mm_allocator);
-            banded_matrix_free(&banded_matrix, mm_allocator);
-            banded_matrix_free(&banded_matrix_r, mm_allocator);
-            return QUICKED_FAIL_NON_CONVERGENCE;
-        }
+/*
+ * Score-only forward and reverse passes up to the central column, and search
+ * of the middle joint cell. If parallel, the two passes run as concurrent tasks;
+ * wide bands are further split between wavefront_threads (see banded_compute).
+ */
+static quicked_status_t hirschberg_split(
+    const char* text,
+    const char* text_r,
+    const int64_t text_length,
+    const char* pattern,
+    const char* pattern_r,
+    const int64_t pattern_length,
+    const int64_t cutoff_score,
+    const bool force_scalar,
+    const banded_pattern_t *const compiled_pattern,
+    const banded_pattern_t *const compiled_pattern_r,
+    quicked_workspace_t *const workspace,
+    const bool parallel,
+    const int wavefront_threads, // Threads sharing the band of each pass
+    hirschberg_split_t *const split)
+{
+    mm_allocator_t *const mm_allocator = workspace->mm_allocator;
 
-        // select lower cell between the two aligmnets
-        if (bottom_pos > bottom_pos_r)
-        {
-            bottom_cell = banded_matrix.lower_block * 64 + 63;
-            starting_pos = bottom_pos;
-        }
-        else
-        {
-            bottom_cell = bottom_pos_r - first_block_band_pos_v * 64;
-            starting_pos = bottom_pos_r;
-        }
+    const int64_t text_len = (text_length + 1) / 2;
+    const int64_t text_len_r = text_length - text_len;
 
-        // select higher cell between the two aligmnets
-        if (higher_pos < higher_pos_r)
-        {
-            higher_cell = banded_matrix.higher_block * 64 + 63;
-            higher_cell_r = (pattern_len - 1) - higher_pos - first_block_band_pos_v_r * 64;
-        }
-        else
-        {
-            higher_cell = higher_pos_r - first_block_band_pos_v * 64;
-            higher_cell_r = banded_matrix_r.lower_block * 64 + 63;
-        }
-        const uint64_t number_of_cells = higher_cell - bottom_cell + 2;
+    const int64_t pattern_len = pattern_length;
 
-        int32_t *cell_score = (int32_t *)mm_allocator_malloc(mm_allocator, number_of_cells * sizeof(int32_t));
-        int32_t *cell_score_r = (int32_t *)mm_allocator_malloc(mm_allocator, number_of_cells * sizeof(int32_t));
+    // Precompiled patterns are only valid at the top level (full pattern)
+    const banded_pattern_t *banded_pattern = compiled_pattern;
+    const banded_pattern_t *banded_pattern_r = compiled_pattern_r;
+    banded_pattern_t banded_pattern_local, banded_pattern_r_local;
+    const quicked_simd_t simd = (force_scalar) ? QUICKED_SIMD_SCALAR : quicked_cpu_simd();
+    if (banded_pattern == NULL)
+    {
+        banded_pattern_compile_workspace(
+            &banded_pattern_local, pattern,
+            pattern_length, simd, &workspace->forward, mm_allocator);
+        banded_pattern = &banded_pattern_local;
+    }
+    if (banded_pattern_r == NULL)
+    {
+        banded_pattern_compile_workspace(
+            &banded_pattern_r_local, pattern_r,
+            pattern_length, simd, &workspace->reverse, mm_allocator);
+        banded_pattern_r = &banded_pattern_r_local;
+    }
+
+    banded_matrix_t banded_matrix, banded_matrix_r;
+
+    banded_matrix_allocate_workspace(
+        &banded_matrix, pattern_length,
+        text_length, cutoff_score, SCORE_ONLY, false,
+        &workspace->forward, mm_allocator);
+    banded_matrix_allocate_workspace(
+        &banded_matrix_r, pattern_length,
+        text_length, cutoff_score, SCORE_ONLY, false,
+        &workspace->reverse, mm_allocator);
+    banded_matrix.num_threads = wavefront_threads;
+    banded_matrix_r.num_threads = wavefront_threads;
+
+    // Compute right side (for getting the central column)
+    #pragma omp task if(parallel) default(shared)
+    banded_compute(
+        &banded_matrix_r, banded_pattern_r, text_r,
+        text_length, text_len_r, SCORE_ONLY, force_scalar);
+
+    // Compute left side (for getting the central column)
+    banded_compute(
+        &banded_matrix, banded_pattern, text,
+        text_length, text_len, SCORE_ONLY, force_scalar);
+
+    #pragma omp taskwait
+    split->cells = banded_matrix.cells + banded_matrix_r.cells;
+
+    // vertival position of the first blocks computed on each aligments
+    int64_t first_block_band_pos_v = (text_len / BPM_W64_LENGTH) - (banded_matrix.prolog_column_blocks);
+    int64_t first_block_band_pos_v_r = (text_len_r / BPM_W64_LENGTH) - (banded_matrix.prolog_column_blocks);
+
+    // Higher and lower cell's position computen in each aligments
+    int64_t bottom_cell;
+    int64_t higher_cell, higher_cell_r;
+    int64_t starting_pos;
+    const int64_t bottom_pos = banded_matrix.lower_block * 64 + 1 + first_block_band_pos_v * 64;
+    const int64_t bottom_pos_r = (pattern_len - 1) - (banded_matrix_r.higher_block * 64 + 63 + first_block_band_pos_v_r * 64);
+    const int64_t higher_pos = banded_matrix.higher_block * 64 + 63 + first_block_band_pos_v * 64;
+    const int64_t higher_pos_r = (pattern_len - 1) - (banded_matrix_r.lower_block * 64 + 1 + first_block_band_pos_v_r * 64);
+
+    // TODO:: make it properly
+    if((bottom_pos > higher_pos_r) || (bottom_pos_r > higher_pos)){
+        return QUICKED_FAIL_NON_CONVERGENCE;
+    }
+
+    // select lower cell between the two aligmnets
+    if (bottom_pos > bottom_pos_r)
+    {
+        bottom_cell = banded_matrix.lower_block * 64 + 1;
+        starting_pos = bottom_pos;
+    }
+    else
+    {
+        bottom_cell = bottom_pos_r - first_block_band_pos_v * 64;
+        starting_pos = bottom_pos_r;
+    }
+
+    // select higher cell between the two aligmnets
+    if (higher_pos < higher_pos_r)
+    {
+        higher_cell = banded_matrix.higher_block * 64 + 63;
+        higher_cell_r = (pattern_len - 1) - higher_pos - first_block_band_pos_v_r * 64;
+    }
+    else
+    {
+        higher_cell = higher_pos_r - first_block_band_pos_v * 64;
+        higher_cell_r = banded_matrix_r.lower_block * 64 + 1;
+    }
+    const uint64_t number_of_cells = higher_cell - bottom_cell + 2;
+
+    // One extra cell, as the prefix sums below write up to cell_score[number_of_cells]
+    int32_t *cell_score = (int32_t *)workspace_buffer_reserve(&workspace->cell_score, (number_of_cells + 1) * sizeof(int32_t), false, mm_allocator);
+    int32_t *cell_score_r = (int32_t *)workspace_buffer_reserve(&workspace->cell_score_r, (number_of_cells + 1) * sizeof(int32_t), false, mm_allocator);
+
+    // compute scores of the left side
+    cell_score[0] = 0;
+    for (uint64_t i = 0; i < number_of_cells; i++)
+    {
+        const uint64_t block = (bottom_cell + i) / BPM_W64_LENGTH;
+        const uint64_t cell = (bottom_cell + i) % BPM_W64_LENGTH;
+        cell_score[i + 1] = cell_score[i] + ((banded_matrix.Pv[block] >> cell) & 0x1ULL) - ((banded_matrix.Mv[block] >> cell) & 0x1ULL);
+    }
+    // compute scores of the right side
+    cell_score_r[0] = 0;
+    for (uint64_t i = 0; i < number_of_cells; i++)
+    {
+        const uint64_t block = (higher_cell_r + i) / BPM_W64_LENGTH;
+        const uint64_t cell = (higher_cell_r + i) % BPM_W64_LENGTH;
+        cell_score_r[i + 1] = cell_score_r[i] + ((banded_matrix_r.Pv[block] >> cell) & 0x1ULL) - ((banded_matrix_r.Mv[block] >> cell) & 0x1ULL);
+    }
 
-        // compute scores of the left side
-        cell_score[0] = 0;
-        for (uint64_t i = 0; i < number_of_cells; i++)
+    // search the middle joint cell
+    uint64_t smaller_pos = 0;
+    int64_t smaller_score = cell_score_r[number_of_cells - 1] + cell_score[0];
+    for (uint64_t i = 1; i < number_of_cells; i++)
+    {
+        int64_t new_score = cell_score_r[number_of_cells - 1 - i] + cell_score[i];
+        if (new_score < smaller_score)
         {
-            const uint64_t block = (bottom_cell + i) / BPM_W64_LENGTH;
-            const uint64_t cell = (bottom_cell + i) % BPM_W64_LENGTH;
-            cell_score[i + 1] = cell_score[i] + ((banded_matrix.Pv[block] >> cell) & 0x1ULL) - ((banded_matrix.Mv[block] >> cell) & 0x1ULL);
+            smaller_pos = i;
+            smaller_score = new_score;
         }
-        // compute scores of the right side
-        cell_score_r[0] = 0;
-        for (uint64_t i = 0; i < number_of_cells; i++)
+    }
+
+    // Divide the text and the pattern for the recursive call
+    int64_t pattern_length_left = starting_pos + smaller_pos;
+    int64_t pattern_length_right = pattern_length - pattern_length_left;
+
+    // Obtain the score of each sub alignment. Read from the block of the middle cell, as the range
+    // of candidate cells may be too narrow to hold a block boundary
+    int64_t score_l = hirschberg_row_score(&banded_matrix, pattern_length_left, text_len, first_block_band_pos_v);
+    int64_t score_r = hirschberg_row_score(&banded_matrix_r, pattern_length_right, text_len_r, first_block_band_pos_v_r);
+
+    split->text_length_left = text_len;
+    split->pattern_length_left = pattern_length_left;
+    split->score_left = score_l;
+    split->score_right = score_r;
+    return QUICKED_OK;
+}
+
+static uint64_t hirschberg_leaf(
+    const char* text,
+    const int64_t text_length,
+    const char* pattern,
+    const int64_t pattern_length,
+    const int64_t cutoff_score,
+    cigar_t *cigar_out,
+    const bool force_scalar,
+    const banded_pattern_t *const compiled_pattern,
+    quicked_workspace_t *const workspace,
+    hirschberg_stream_t *const stream)
+{
+    mm_allocator_t *const mm_allocator = workspace->mm_allocator;
+
+    const banded_pattern_t *banded_pattern = compiled_pattern;
+    banded_pattern_t banded_pattern_local;
+    banded_matrix_t banded_matrix;
+    const quicked_simd_t simd = (force_scalar) ? QUICKED_SIMD_SCALAR : quicked_cpu_simd();
+
+    // Allocate
+    if (banded_pattern == NULL)
+    {
+        banded_pattern_compile_workspace(
+            &banded_pattern_local, pattern,
+            pattern_length, simd, &workspace->forward, mm_allocator);
+        banded_pattern = &banded_pattern_local;
+    }
+    banded_matrix_allocate_workspace(
+        &banded_matrix, pattern_length,
+        text_length, cutoff_score, false, false,
+        &workspace->forward, mm_allocator);
+
+    // Align
+    banded_compute(
+        &banded_matrix, banded_pattern, text,
+        text_length, pattern_length, false, force_scalar);
+    // Merge cigar
+    cigar_t *const cigar = banded_matrix.cigar;
+    if (stream != NULL)
+    {
+        stream->score += cigar->score;
+        if (stream->callback != NULL)
         {
-            const uint64_t block = (higher_cell_r + i) / BPM_W64_LENGTH;
-            const uint64_t cell = (higher_cell_r + i) % BPM_W64_LENGTH;
-            cell_score_r[i + 1] = cell_score_r[i] + ((banded_matrix_r.Pv[block] >> cell) & 0x1ULL) - ((banded_matrix_r.Mv[block] >> cell) & 0x1ULL);
+            stream->callback(cigar->operations + cigar->begin_offset,
+                             cigar->end_offset - cigar->begin_offset, stream->user_data);
         }
+    }
+    else
+    {
+        cigar_prepend_forward(cigar, cigar_out);
+    }
+    return banded_matrix.cells;
+}
 
-        // search the middle joint cell
-        uint64_t smaller_pos = 0;
-        int64_t smaller_score = cell_score_r[number_of_cells - 1] + cell_score[0];
-        for (uint64_t i = 1; i < number_of_cells; i++)
-        {
-            int64_t new_score = cell_score_r[number_of_cells - 1 - i] + cell_score[i];
-            if (new_score < smaller_score)
-            {
-                smaller_pos = i;
-                smaller_score = new_score;
-            }
+static quicked_status_t hirschberg_recursive(
+    const char* text,
+    const char* text_r,
+    const int64_t text_length,
+    const char* pattern,
+    const char* pattern_r,
+    const int64_t pattern_length,
+    const int64_t cutoff_score,
+    const uint64_t leaf_footprint,
+    cigar_t *cigar_out,
+    const bool force_scalar,
+    const banded_pattern_t *const compiled_pattern,
+    const banded_pattern_t *const compiled_pattern_r,
+    quicked_workspace_t *const workspace,
+    hirschberg_stream_t *const stream,
+    const uint64_t depth,
+    hirschberg_stats_t *const stats)
+{
+    if (hirschberg_footprint(text_length, pattern_length, cutoff_score) > leaf_footprint)
+    { // divide the alignment in 2
+        hirschberg_split_t split;
+        quicked_status_t status = hirschberg_split(
+            text, text_r, text_length,
+            pattern, pattern_r, pattern_length,
+            cutoff_score, force_scalar,
+            compiled_pattern, compiled_pattern_r,
+            workspace, false, 1, &split);
+        hirschberg_stats_add(stats, depth, split.cells);
+
+        if(quicked_check_error(status)){
+            return status;
         }
 
-        // Divide the text and the pattern for the recursive call
-        int64_t pattern_length_left = starting_pos + smaller_pos;
-        int64_t pattern_length_right = pattern_length - pattern_length_left;
+        const int64_t text_len = split.text_length_left;
+        const int64_t pattern_length_left = split.pattern_length_left;
+        const int64_t pattern_length_right = pattern_length - pattern_length_left;
 
         const char* pattern_r_left = pattern_r + pattern_length_right;
         const char* pattern_right = pattern + pattern_length_left;
@@ -190,81 +373,226 @@ quicked_status_t bpm_compute_matrix_hirschberg(
         const char* text_right = text + text_len;
         const char* text_r_left = text_r + text_length_right;
 
-        // Obtain the score of rach sub aligmnet
-        int64_t block_reference = DIV_CEIL(pattern_length_left, BPM_W64_LENGTH) - (number_of_cells < smaller_pos + BPM_W64_LENGTH);
-        int64_t score_pos_l = block_reference * BPM_W64_LENGTH - (bottom_cell + first_block_band_pos_v * 64);
-        int64_t score_l = cell_score[smaller_pos] - cell_score[score_pos_l] + banded_matrix.scores[block_reference - 1];
-
-        int64_t block_reference_r = DIV_CEIL(pattern_length_right, BPM_W64_LENGTH) - (smaller_pos < BPM_W64_LENGTH);
-        int64_t score_pos_r = block_reference_r * BPM_W64_LENGTH - (higher_cell_r + first_block_band_pos_v_r * 64);
-        int64_t score_r = cell_score_r[number_of_cells - 1 - smaller_pos] - cell_score_r[score_pos_r] + banded_matrix_r.scores[block_reference_r - 1];
-
-        // Free
-        banded_pattern_free(&banded_pattern, mm_allocator);
-        banded_pattern_free(&banded_pattern_r, mm_allocator);
-        banded_matrix_free(&banded_matrix, mm_allocator);
-        banded_matrix_free(&banded_matrix_r, mm_allocator);
-        mm_allocator_free(mm_allocator, cell_score);
-        mm_allocator_free(mm_allocator, cell_score_r);
-
-        quicked_status_t status;
-        // Compute right
-        status = bpm_compute_matrix_hirschberg(
-            text_right,
-            text_r,
-            text_length_right,
-            pattern_right,
-            pattern_r,
-            pattern_length_right,
-            score_r,
-            cigar_out,
-            force_scalar,
-            mm_allocator);
-        
-        if(quicked_check_error(status)){
-            return status;
-        }
+        // The workspace buffers are reused by the recursive calls from here on.
+        // The operations are prepended to cigar_out (right half first), but streamed in order (left half first)
+        for (int half = 0; half < 2; half++)
+        {
+            const bool left = (stream != NULL) == (half == 0);
+            if (left)
+            {
+                status = hirschberg_recursive(
+                    text,
+                    text_r_left,
+                    text_len,
+                    pattern,
+                    pattern_r_left,
+                    pattern_length_left,
+                    split.score_left,
+                    leaf_footprint,
+                    cigar_out,
+                    force_scalar,
+                    NULL,
+                    NULL,
+                    workspace,
+                    stream,
+                    depth + 1,
+                    stats);
+            }
+            else
+            {
+                status = hirschberg_recursive(
+                    text_right,
+                    text_r,
+                    text_length_right,
+                    pattern_right,
+                    pattern_r,
+                    pattern_length_right,
+                    split.score_right,
+                    leaf_footprint,
+                    cigar_out,
+                    force_scalar,
+                    NULL,
+                    NULL,
+                    workspace,
+                    stream,
+                    depth + 1,
+                    stats);
+            }
 
-        // Compute left
-        status = bpm_compute_matrix_hirschberg(
-            text,
-            text_r_left,
-            text_len,
-            pattern,
-            pattern_r_left,
-            pattern_length_left,
-            score_l,
-            cigar_out,
-            force_scalar,
-            mm_allocator);
-        
-        if(quicked_check_error(status)){
-            return status;
+            if(quicked_check_error(status)){
+                return status;
+            }
         }
     }
     else
     { // solve the alignment
+        const uint64_t cells = hirschberg_leaf(text, text_length, pattern, pattern_length, cutoff_score,
+                                               cigar_out, force_scalar, compiled_pattern, workspace, stream);
+        hirschberg_stats_add(stats, depth, cells);
+    }
+    return QUICKED_OK;
+}
+
+quicked_status_t bpm_compute_matrix_hirschberg(
+    const char* text,
+    const char* text_r,
+    const int64_t text_length,
+    const char* pattern,
+    const char* pattern_r,
+    const int64_t pattern_length,
+    const int64_t cutoff_score,
+    const uint64_t leaf_footprint,
+    cigar_t *cigar_out,
+    const bool force_scalar,
+    const banded_pattern_t *const compiled_pattern,
+    const banded_pattern_t *const compiled_pattern_r,
+    quicked_workspace_t *const workspace,
+    hirschberg_stream_t *const stream,
+    hirschberg_stats_t *const stats)
+{
+    return hirschberg_recursive(text, text_r, text_length, pattern, pattern_r, pattern_length,
+                                cutoff_score, MAX(leaf_footprint, BPM_HIRSCHBERG_MIN_LEAF_FOOTPRINT), cigar_out, force_scalar,
+                                compiled_pattern, compiled_pattern_r, workspace, stream, 0, stats);
+}
+
+/*
+ * Task-parallel Hirschberg. Each task writes its operations right-aligned into
+ * its own slice of the operations buffer (a subproblem never needs more than
+ * text_length + pattern_length operations); the gaps are compacted at the end.
+ */
+static void hirschberg_task(
+    const char* text,
+    const char* text_r,
+    const int64_t text_length,
+    const char* pattern,
+    const char* pattern_r,
+    const int64_t pattern_length,
+    const int64_t cutoff_score,
+    const uint64_t leaf_footprint,
+    char *const operations,
+    const bool force_scalar,
+    const banded_pattern_t *const compiled_pattern,
+    const banded_pattern_t *const compiled_pattern_r,
+    quicked_workspace_pool_t *const pool,
+    const int num_threads,
+    const uint64_t depth,
+    hirschberg_stats_t *const stats,
+    quicked_status_t *const status_out)
+{
+    const int64_t slice_length = text_length + pattern_length;
+    cigar_t cigar_slice = {
+        .operations = operations,
+        .begin_offset = slice_length,
+        .end_offset = slice_length,
+    };
+    quicked_workspace_t *const workspace = quicked_workspace_pool_acquire(pool);
+    quicked_status_t status;
+
+    // Below the grain size, the subproblem is solved serially by a single task
+    if (hirschberg_footprint(text_length, pattern_length, cutoff_score) <= BPM_HIRSCHBERG_TASK_FOOTPRINT)
+    {
+        status = hirschberg_recursive(
+            text, text_r, text_length,
+            pattern, pattern_r, pattern_length,
+            cutoff_score, leaf_footprint, &cigar_slice, force_scalar,
+            compiled_pattern, compiled_pattern_r,
+            workspace, NULL, depth, stats);
+        quicked_workspace_pool_release(pool, workspace);
+        if (quicked_check_error(status))
+        {
+            #pragma omp atomic write
+            *status_out = status;
+        }
+        return;
+    }
 
-        banded_pattern_t banded_pattern;
-        banded_matrix_t banded_matrix;
-
-        // Allocate
-        banded_pattern_compile(
-            &banded_pattern, pattern,
-            pattern_length, mm_allocator);
-        banded_matrix_allocate(
-            &banded_matrix, pattern_length,
-            text_length, cutoff_score, false, mm_allocator);
-
-        // Align
-        banded_compute(
-            &banded_matrix, &banded_pattern, text,
-            text_length, pattern_length, false, force_scalar);
-        // Merge cigar
-        cigar_prepend_forward(banded_matrix.cigar, cigar_out);
-        // free variables
-        banded_pattern_free(&banded_pattern, mm_allocator);
-        banded_matrix_free(&banded_matrix, mm_allocator);
+    hirschberg_split_t split;
+    status = hirschberg_split(
+        text, text_r, text_length,
+        pattern, pattern_r, pattern_length,
+        cutoff_score, force_scalar,
+        compiled_pattern, compiled_pattern_r,
+        workspace, true, MAX(1, num_threads >> (depth + 1)), &split);
+    hirschberg_stats_add(stats, depth, split.cells);
+    // The split results are plain values, so the workspace can go back to the pool
+    quicked_workspace_pool_release(pool, workspace);
+    if (quicked_check_error(status))
+    {
+        #pragma omp atomic write
+        *status_out = status;
+        return;
+    }
+
+    const int64_t text_len = split.text_length_left;
+    const int64_t pattern_length_left = split.pattern_length_left;
+    const int64_t pattern_length_right = pattern_length - pattern_length_left;
+    const int64_t text_length_right = text_length - text_len;
+
+    // Compute right
+    #pragma omp task default(shared)
+    hirschberg_task(
+        text + text_len, text_r, text_length_right,
+        pattern + pattern_length_left, pattern_r, pattern_length_right,
+        split.score_right, leaf_footprint, operations + text_len + pattern_length_left,
+        force_scalar, NULL, NULL, pool, num_threads, depth + 1, stats, status_out);
+
+    // Compute left
+    hirschberg_task(
+        text, text_r + text_length_right, text_len,
+        pattern, pattern_r + pattern_length_right, pattern_length_left,
+        split.score_left, leaf_footprint, operations,
+        force_scalar, NULL, NULL, pool, num_threads, depth + 1, stats, status_out);
+
+    #pragma omp taskwait
+}
+
+quicked_status_t bpm_compute_matrix_hirschberg_parallel(
+    const char* text,
+    const char* text_r,
+    const int64_t text_length,
+    const char* pattern,
+    const char* pattern_r,
+    const int64_t pattern_length,
+    const int64_t cutoff_score,
+    const uint64_t leaf_footprint,
+    cigar_t *cigar_out,
+    const bool force_scalar,
+    const banded_pattern_t *const compiled_pattern,
+    const banded_pattern_t *const compiled_pattern_r,
+    quicked_workspace_pool_t *const pool,
+    const int num_threads,
+    hirschberg_stats_t *const stats)
+{
+    // Empty slice positions are marked with 0 and removed afterwards
+    const int64_t operations_length = text_length + pattern_length;
+    char *const operations = cigar_out->operations + cigar_out->begin_offset - operations_length;
+    memset(operations, 0, operations_length);
+
+    quicked_status_t status = QUICKED_OK;
+    #pragma omp parallel num_threads(num_threads)
+    #pragma omp single
+    hirschberg_task(
+        text, text_r, text_length,
+        pattern, pattern_r, pattern_length,
+        cutoff_score, MAX(leaf_footprint, BPM_HIRSCHBERG_MIN_LEAF_FOOTPRINT), operations, force_scalar,
+        compiled_pattern, compiled_pattern_r,
+        pool, num_threads, 0, stats, &status);
+
+    if (quicked_check_error(status))
+    {
+        return status;
     }
+
+    // Compact the slices towards the end of the buffer
+    int64_t op_sentinel = operations_length - 1;
+    for (int64_t i = operations_length - 1; i >= 0; i--)
+    {
+        if (operations[i] != 0)
+        {
+            operations[op_sentinel--] = operations[i];
+        }
+    }
+    cigar_out->begin_offset -= operations_length - (op_sentinel + 1);
+
     return QUICKED_OK;
 }
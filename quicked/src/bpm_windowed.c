@@ -24,13 +24,11 @@
 
 #include "quicked_utils/include/commons.h"
 #include "quicked_utils/include/mm_allocator.h"
-#include "quicked_utils/include/dna_text.h"
 #include "bpm_windowed.h"
 #include "bpm_commons.h"
+#include "quicked_cpu.h"
 
-#ifndef __SSE4_1__
-#warning "SSE4.1 or higher is required for SIMD windows"
-#else
+#ifdef QUICKED_SIMD_X86
 #include <immintrin.h>
 #endif
 
@@ -38,27 +36,35 @@
  * Setup
  */
 
-void windowed_pattern_compile(
+uint64_t windowed_pattern_size(
+    const uint64_t pattern_length)
+{
+    const uint64_t pattern_num_words64 = DIV_CEIL(pattern_length, BPM_W64_LENGTH);
+    const uint64_t aux_vector_size = pattern_num_words64 * BPM_W64_SIZE;
+    const uint64_t PEQ_size = BPM_ALPHABET_LENGTH * aux_vector_size;
+    const uint64_t score_size = pattern_num_words64 * UINT64_SIZE;
+    return PEQ_size + 3 * aux_vector_size + 2 * score_size + (pattern_num_words64 + 1) * UINT64_SIZE;
+}
+
+void windowed_pattern_init(
     windowed_pattern_t *const windowed_pattern,
     const char* pattern,
     const uint64_t pattern_length,
-    mm_allocator_t *const mm_allocator)
+    const quicked_simd_t simd,
+    void *memory)
 {
     // Calculate dimensions
     const uint64_t pattern_num_words64 = DIV_CEIL(pattern_length, BPM_W64_LENGTH);
-    const uint64_t PEQ_length = pattern_num_words64 * BPM_W64_LENGTH;
     const uint64_t pattern_mod = pattern_length % BPM_W64_LENGTH;
     // Init fields
     windowed_pattern->pattern = pattern;
     windowed_pattern->pattern_length = pattern_length;
     windowed_pattern->pattern_num_words64 = pattern_num_words64;
     windowed_pattern->pattern_mod = pattern_mod;
-    // Allocate memory
+    // Layout memory
     const uint64_t aux_vector_size = pattern_num_words64 * BPM_W64_SIZE;
     const uint64_t PEQ_size = BPM_ALPHABET_LENGTH * aux_vector_size;
     const uint64_t score_size = pattern_num_words64 * UINT64_SIZE;
-    const uint64_t total_memory = PEQ_size + 3 * aux_vector_size + 2 * score_size + (pattern_num_words64 + 1) * UINT64_SIZE;
-    void *memory = mm_allocator_malloc(mm_allocator, total_memory);
     windowed_pattern->PEQ = memory;
     memory += PEQ_size;
     windowed_pattern->P = memory;
@@ -73,25 +79,8 @@ void windowed_pattern_compile(
     memory += score_size;
     windowed_pattern->pattern_left = memory;
     // Init PEQ
-    memset(windowed_pattern->PEQ, 0, PEQ_size);
+    bpm_pattern_compile_peq(windowed_pattern->PEQ, pattern, pattern_length, simd);
     uint64_t i;
-    for (i = 0; i < pattern_length; ++i)
-    {
-        const uint8_t enc_char = dna_encode(pattern[i]);
-        const uint64_t block = i / BPM_W64_LENGTH;
-        const uint64_t mask = 1ull << (i % BPM_W64_LENGTH);
-        windowed_pattern->PEQ[BPM_PATTERN_PEQ_IDX(block, enc_char)] |= mask;
-    }
-    for (; i < PEQ_length; ++i)
-    { // Padding
-        const uint64_t block = i / BPM_W64_LENGTH;
-        const uint64_t mask = 1ull << (i % BPM_W64_LENGTH);
-        uint64_t j;
-        for (j = 0; j < BPM_ALPHABET_LENGTH; ++j)
-        {
-            windowed_pattern->PEQ[BPM_PATTERN_PEQ_IDX(block, j)] |= mask;
-        }
-    }
     // Init auxiliary data
     uint64_t pattern_left = pattern_length;
     const uint64_t top = pattern_num_words64 - 1;
@@ -121,6 +110,29 @@ void windowed_pattern_compile(
     }
 }
 
+void windowed_pattern_compile(
+    windowed_pattern_t *const windowed_pattern,
+    const char* pattern,
+    const uint64_t pattern_length,
+    const quicked_simd_t simd,
+    mm_allocator_t *const mm_allocator)
+{
+    void *memory = mm_allocator_malloc(mm_allocator, windowed_pattern_size(pattern_length));
+    windowed_pattern_init(windowed_pattern, pattern, pattern_length, simd, memory);
+}
+
+void windowed_pattern_compile_workspace(
+    windowed_pattern_t *const windowed_pattern,
+    const char* pattern,
+    const uint64_t pattern_length,
+    const quicked_simd_t simd,
+    workspace_pass_t *const pass,
+    mm_allocator_t *const mm_allocator)
+{
+    void *memory = workspace_buffer_reserve(&pass->pattern, windowed_pattern_size(pattern_length), false, mm_allocator);
+    windowed_pattern_init(windowed_pattern, pattern, pattern_length, simd, memory);
+}
+
 void windowed_pattern_free(
     windowed_pattern_t *const windowed_pattern,
     mm_allocator_t *const mm_allocator)
@@ -128,6 +140,57 @@ void windowed_pattern_free(
     mm_allocator_free(mm_allocator, windowed_pattern->PEQ);
 }
 
+// Lanes of the widest windowed kernel (padding of the reversed window text)
+#define WINDOWED_MAX_LANES 8
+
+uint64_t windowed_matrix_window_size(
+    const int window_size)
+{
+    const uint64_t window_length = BPM_W64_LENGTH * window_size;
+    const uint64_t PEQ_size = window_size * UINT64_SIZE * BPM_ALPHABET_LENGTH;
+    const uint64_t carry_size = (window_length + 1) * UINT64_SIZE;
+    return PEQ_size + 2 * carry_size + window_length + 2 * WINDOWED_MAX_LANES;
+}
+
+void windowed_matrix_window_init(
+    windowed_matrix_t *const windowed_matrix,
+    const int window_size,
+    void *memory)
+{
+    const uint64_t window_length = BPM_W64_LENGTH * window_size;
+    const uint64_t PEQ_size = window_size * UINT64_SIZE * BPM_ALPHABET_LENGTH;
+    const uint64_t carry_size = (window_length + 1) * UINT64_SIZE;
+    windowed_matrix->PEQ_window = memory;
+    memory += PEQ_size;
+    windowed_matrix->PH_carry = memory;
+    memory += carry_size;
+    windowed_matrix->MH_carry = memory;
+    memory += carry_size;
+    windowed_matrix->text_window = memory;
+}
+
+void windowed_matrix_setup(
+    windowed_matrix_t *const windowed_matrix,
+    const uint64_t pattern_length,
+    const uint64_t text_length)
+{
+    windowed_matrix->pos_v = pattern_length - 1;
+    windowed_matrix->pos_h = text_length - 1;
+    windowed_matrix->high_error_window = 0;
+    windowed_matrix->cells = 0;
+    windowed_matrix->ends_free = false;
+    windowed_matrix->locating_end = false;
+    windowed_matrix->text_begin = 0;
+    windowed_matrix->text_end = text_length;
+    windowed_matrix->PEQ_window_pos_v = -1;
+    windowed_matrix->PEQ_window_blocks = 0;
+    // CIGAR
+    windowed_matrix->cigar->end_offset = pattern_length + text_length;
+    windowed_matrix->cigar->begin_offset = pattern_length + text_length - 1;
+    windowed_matrix->cigar->score = 0;
+    windowed_matrix->packed_cigar = false;
+}
+
 void windowed_matrix_allocate(
     windowed_matrix_t *const windowed_matrix,
     const uint64_t pattern_length,
@@ -145,17 +208,38 @@ void windowed_matrix_allocate(
     uint64_t *const Mv = (uint64_t *)mm_allocator_malloc(mm_allocator, aux_matrix_size);
     windowed_matrix->Mv = Mv;
     windowed_matrix->Pv = Pv;
-    windowed_matrix->pos_v = pattern_length - 1;
-    windowed_matrix->pos_h = text_length - 1;
-    windowed_matrix->high_error_window = 0;
     // CIGAR
     windowed_matrix->cigar = cigar_new(pattern_length + text_length,mm_allocator);
-    windowed_matrix->cigar->end_offset = pattern_length + text_length;
-    windowed_matrix->cigar->begin_offset = pattern_length + text_length - 1;
-    windowed_matrix->cigar->score = 0;
+    windowed_matrix_setup(windowed_matrix, pattern_length, text_length);
+
+    void *const window = mm_allocator_malloc(mm_allocator, windowed_matrix_window_size(window_size));
+    windowed_matrix_window_init(windowed_matrix, window_size, window);
+}
+
+void windowed_matrix_allocate_workspace(
+    windowed_matrix_t *const windowed_matrix,
+    const uint64_t pattern_length,
+    const uint64_t text_length,
+    const int window_size,
+    const bool score_only,
+    workspace_pass_t *const pass,
+    mm_allocator_t *const mm_allocator)
+{
+    const uint64_t num_words64 = window_size;
+    const uint64_t aux_matrix_size = num_words64 * UINT64_SIZE * (BPM_W64_LENGTH * window_size + 2); /* (+1 base-column) */
+    windowed_matrix->Pv = (uint64_t *)workspace_buffer_reserve(&pass->Pv, aux_matrix_size, false, mm_allocator);
+    windowed_matrix->Mv = (uint64_t *)workspace_buffer_reserve(&pass->Mv, aux_matrix_size, false, mm_allocator);
+    // CIGAR (operations are only needed for the backtrace)
+    cigar_t *const cigar = &pass->cigar;
+    cigar->max_operations = pattern_length + text_length;
+    cigar->operations = score_only ? NULL : (char *)workspace_buffer_reserve(&pass->operations, cigar->max_operations, false, mm_allocator);
+    cigar->cigar_buffer = NULL;
+    cigar_clear(cigar);
+    windowed_matrix->cigar = cigar;
+    windowed_matrix_setup(windowed_matrix, pattern_length, text_length);
 
-    const uint64_t aux_PEQ_size = window_size * UINT64_SIZE * BPM_ALPHABET_LENGTH; /* (+1 base-column) */
-    windowed_matrix->PEQ_window = (uint64_t *)mm_allocator_malloc(mm_allocator, aux_PEQ_size);
+    void *const window = workspace_buffer_reserve(&pass->PEQ_window, windowed_matrix_window_size(window_size), false, mm_allocator);
+    windowed_matrix_window_init(windowed_matrix, window_size, window);
 }
 
 void windowed_matrix_free(
@@ -199,14 +283,78 @@ void windowed_reset_differences_zero(
     }
 }
 
+// Left border: the pattern rows before the text pay for it, as do those of a window locating the end
+// of an ends-free alignment. Otherwise they are left free
+static inline void windowed_reset_left(
+    windowed_matrix_t *const windowed_matrix,
+    const int64_t pos_h,
+    const int window_size)
+{
+    if (pos_h == 0 || windowed_matrix->locating_end) {
+        windowed_reset_differences(windowed_matrix->Pv, windowed_matrix->Mv, window_size);
+    } else {
+        windowed_reset_differences_zero(windowed_matrix->Pv, windowed_matrix->Mv, window_size);
+    }
+}
+
+// Horizontal carry into the first pattern row: it pays for the text it skips, unless ends-free
+static inline uint64_t windowed_top_carry(
+    const windowed_matrix_t *const windowed_matrix,
+    const int64_t pos_v)
+{
+    return (pos_v == 0 && !windowed_matrix->ends_free) ? 1 : 0;
+}
+
+void windowed_compute_window_peq(
+    windowed_matrix_t *const windowed_matrix,
+    const windowed_pattern_t *const windowed_pattern,
+    const int64_t pos_v,
+    const int64_t steps_v)
+{
+    const uint64_t *PEQ = windowed_pattern->PEQ;
+    uint64_t *const PEQ_window = windowed_matrix->PEQ_window;
+    uint64_t shift = pos_v % UINT64_LENGTH;
+    uint64_t shift_mask = shift ? 0xFFFFFFFFFFFFFFFFULL : 0ULL;
+    int64_t pos_v_block = (pos_v / UINT64_LENGTH);
+
+    // A window that moves up by whole blocks keeps the bit alignment of the
+    // previous one, so the blocks they overlap on are only moved: [reuse_begin,reuse_end)
+    int64_t reuse_begin = steps_v, reuse_end = steps_v;
+    const int64_t prev_pos_v = windowed_matrix->PEQ_window_pos_v;
+    if (prev_pos_v >= pos_v && (prev_pos_v - pos_v) % UINT64_LENGTH == 0)
+    {
+        const int64_t offset = (prev_pos_v - pos_v) / UINT64_LENGTH;
+        const int64_t reused = MIN(windowed_matrix->PEQ_window_blocks, steps_v - offset);
+        if (reused > 0)
+        {
+            memmove(&PEQ_window[BPM_PATTERN_PEQ_IDX(offset, 0)], PEQ_window, reused * BPM_ALPHABET_LENGTH * UINT64_SIZE);
+            reuse_begin = offset;
+            reuse_end = offset + reused;
+        }
+    }
+
+    for (int64_t i = 0; i < steps_v; ++i)
+    {
+        if (i == reuse_begin) i = reuse_end;
+        if (i >= steps_v) break;
+        for (uint64_t enc_char = 0; enc_char < BPM_ALPHABET_LENGTH; enc_char++)
+        {
+            const uint64_t Eq = PEQ[BPM_PATTERN_PEQ_IDX(i + pos_v_block, enc_char)] >> shift | ((PEQ[BPM_PATTERN_PEQ_IDX(i + pos_v_block + 1, enc_char)] << (BPM_W64_LENGTH - shift)) & shift_mask);
+            PEQ_window[BPM_PATTERN_PEQ_IDX(i, enc_char)] = Eq;
+        }
+    }
+
+    windowed_matrix->PEQ_window_pos_v = pos_v;
+    windowed_matrix->PEQ_window_blocks = steps_v;
+}
+
 void windowed_compute_window(
     windowed_matrix_t *const windowed_matrix,
-    windowed_pattern_t *const windowed_pattern,
+    const windowed_pattern_t *const windowed_pattern,
     const char* text,
     const int window_size)
 {
     // Pattern variables
-    const uint64_t *PEQ = windowed_pattern->PEQ;
     // const uint64_t num_words64 = windowed_pattern->pattern_num_words64;
     const uint64_t num_words64 = window_size;
     // int64_t* const score = windowed_pattern->score;
@@ -222,39 +370,20 @@ void windowed_compute_window(
     int64_t pos_v = (pos_v_fi - UINT64_LENGTH * (window_size) + 1 >= 0) ? pos_v_fi - UINT64_LENGTH * (window_size) + 1 : 0;
     int64_t pos_h = (pos_h_fi - UINT64_LENGTH * (window_size) + 1 >= 0) ? pos_h_fi - UINT64_LENGTH * (window_size) + 1 : 0;
 
-    if (pos_h == 0) {
-        windowed_reset_differences(Pv, Mv, window_size);
-    } else {
-        windowed_reset_differences_zero(Pv, Mv, window_size);
-    }
+    windowed_reset_left(windowed_matrix, pos_h, window_size);
 
     int64_t steps_v = (pos_v_fi - pos_v) / UINT64_LENGTH + 1;
     int64_t steps_h = pos_h_fi - pos_h;
-    uint64_t shift = pos_v % UINT64_LENGTH;
-    uint64_t shift_mask = shift ? 0xFFFFFFFFFFFFFFFFULL : 0ULL;
-    int64_t pos_v_block = (pos_v / UINT64_LENGTH);
 
-    for (int64_t i = 0; i < steps_v; ++i)
-    {
-        for (uint64_t enc_char = 0; enc_char < BPM_ALPHABET_LENGTH; enc_char++)
-        {
-            const uint64_t Eq = PEQ[BPM_PATTERN_PEQ_IDX(i + pos_v_block, enc_char)] >> shift | ((PEQ[BPM_PATTERN_PEQ_IDX(i + pos_v_block + 1, enc_char)] << (BPM_W64_LENGTH - shift)) & shift_mask);
-            PEQ_window[BPM_PATTERN_PEQ_IDX(i, enc_char)] = Eq;
-        }
-    }
+    windowed_compute_window_peq(windowed_matrix, windowed_pattern, pos_v, steps_v);
 
     // First cell
-    uint64_t Ph_first;
-    if (pos_v == 0) {
-        Ph_first = 1;
-    } else {
-        Ph_first = 0;
-    }
+    const uint64_t Ph_first = windowed_top_carry(windowed_matrix, pos_v);
 
     for (text_position = 0; text_position <= steps_h; ++text_position)
     {
         // Fetch next character
-        const uint8_t enc_char = dna_encode(text[text_position + pos_h]);
+        const uint8_t enc_char = (uint8_t)text[text_position + pos_h];
         // Advance all blocks
         int64_t i;
         uint64_t PHin = Ph_first, MHin = 0, PHout, MHout;
@@ -279,15 +408,15 @@ void windowed_compute_window(
     }
 }
 
-#ifdef __SSE4_1__
+#ifdef QUICKED_SIMD_X86
+QUICKED_TARGET("sse4.1")
 void windowed_compute_window_sse(
     windowed_matrix_t *const windowed_matrix,
-    windowed_pattern_t *const windowed_pattern,
+    const windowed_pattern_t *const windowed_pattern,
     const char* text,
     const int window_size)
 {
     // Pattern variables
-    const uint64_t *PEQ = windowed_pattern->PEQ;
     const uint64_t num_words64 = window_size;
     uint64_t *const Pv = windowed_matrix->Pv;
     uint64_t *const Mv = windowed_matrix->Mv;
@@ -300,38 +429,19 @@ void windowed_compute_window_sse(
     int64_t pos_v = (pos_v_fi - UINT64_LENGTH * (window_size) + 1 >= 0) ? pos_v_fi - UINT64_LENGTH * (window_size) + 1 : 0;
     int64_t pos_h = (pos_h_fi - UINT64_LENGTH * (window_size) + 1 >= 0) ? pos_h_fi - UINT64_LENGTH * (window_size) + 1 : 0;
 
-    if (pos_h == 0) {
-        windowed_reset_differences(Pv, Mv, window_size);
-    } else {
-        windowed_reset_differences_zero(Pv, Mv, window_size);
-    }
+    windowed_reset_left(windowed_matrix, pos_h, window_size);
 
     int64_t steps_v = (pos_v_fi - pos_v) / UINT64_LENGTH + 1;
     int64_t steps_h = pos_h_fi - pos_h;
-    uint64_t shift = pos_v % UINT64_LENGTH;
-    uint64_t shift_mask = shift ? 0xFFFFFFFFFFFFFFFFULL : 0ULL;
-    int64_t pos_v_block = (pos_v / UINT64_LENGTH);
 
     // Generate aligned PEQ vectors
-    for (int64_t i = 0; i < steps_v; ++i)
-    {
-        for (uint64_t enc_char = 0; enc_char < BPM_ALPHABET_LENGTH; enc_char++)
-        {
-            const uint64_t Eq = PEQ[BPM_PATTERN_PEQ_IDX(i + pos_v_block, enc_char)] >> shift | ((PEQ[BPM_PATTERN_PEQ_IDX(i + pos_v_block + 1, enc_char)] << (BPM_W64_LENGTH - shift)) & shift_mask);
-            PEQ_window[BPM_PATTERN_PEQ_IDX(i, enc_char)] = Eq;
-        }
-    }
+    windowed_compute_window_peq(windowed_matrix, windowed_pattern, pos_v, steps_v);
 
     // First cell
-    uint64_t Ph_first, Mh_first = 0;
-    if (pos_v == 0) {
-        Ph_first = 1;
-    } else {
-        Ph_first = 0;
-    }
+    uint64_t Ph_first = windowed_top_carry(windowed_matrix, pos_v), Mh_first = 0;
 
     {
-        const uint8_t enc_char = dna_encode(text[0 + pos_h]);
+        const uint8_t enc_char = (uint8_t)text[0 + pos_h];
         const uint64_t bdp_idx = BPM_PATTERN_BDP_IDX(0, num_words64, 0);
         const uint64_t next_bdp_idx = bdp_idx + num_words64;
         uint64_t Pv_in = Pv[bdp_idx];
@@ -356,9 +466,9 @@ void windowed_compute_window_sse(
     for (text_position = 1; text_position <= steps_h; text_position += 2)
     {
         // Fetch next character
-        uint8_t enc_char = dna_encode(text[text_position + pos_h]);
-        uint8_t enc_char_2 = dna_encode(text[text_position + pos_h - 1]);
-        uint8_t enc_char_3 = dna_encode(text[text_position + pos_h + 1]);
+        uint8_t enc_char = (uint8_t)text[text_position + pos_h];
+        uint8_t enc_char_2 = (uint8_t)text[text_position + pos_h - 1];
+        uint8_t enc_char_3 = (uint8_t)text[text_position + pos_h + 1];
 
         /* Calculate Step Data */
         uint64_t Eq = PEQ_window[BPM_PATTERN_PEQ_IDX(0, enc_char)];
@@ -429,7 +539,7 @@ void windowed_compute_window_sse(
     Ph_first = _mm_extract_epi64(PHout, 1);
     Mh_first = _mm_extract_epi64(MHout, 1);
     {
-        const uint8_t enc_char = dna_encode(text[steps_h + pos_h]);
+        const uint8_t enc_char = (uint8_t)text[steps_h + pos_h];
         const uint64_t bdp_idx = BPM_PATTERN_BDP_IDX(steps_h, num_words64, 1);
         const uint64_t next_bdp_idx = bdp_idx + num_words64;
         uint64_t Pv_in = Pv[bdp_idx];
@@ -445,19 +555,256 @@ void windowed_compute_window_sse(
 }
 #endif
 
-void windowed_backtrace(
+/*
+ * Wavefront kernels (any window_size): lane k of a group of blocks computes
+ * block (group+k) of column (step-k), so each step advances a diagonal of the
+ * window. The blocks left over after the last full group are computed one
+ * column at a time, taking the carries of the last group
+ */
+void windowed_compute_window_setup_wavefront(
+    windowed_matrix_t *const windowed_matrix,
+    const char* text,
+    const int64_t steps_h,
+    const uint64_t Ph_first,
+    const int lanes)
+{
+    uint64_t *const PH_carry = windowed_matrix->PH_carry;
+    uint64_t *const MH_carry = windowed_matrix->MH_carry;
+    uint8_t *const text_window = windowed_matrix->text_window;
+    // Reversed, so that the lanes of a step read consecutive characters: column c is at (lanes-1) + (steps_h-c)
+    memset(text_window, 0, lanes - 1);
+    for (int64_t c = 0; c <= steps_h; ++c)
+    {
+        text_window[(lanes - 1) + (steps_h - c)] = (uint8_t)text[c];
+        PH_carry[c] = Ph_first;
+        MH_carry[c] = 0;
+    }
+    memset(text_window + lanes + steps_h, 0, lanes - 1);
+}
+
+void windowed_compute_window_remaining_blocks(
+    windowed_matrix_t *const windowed_matrix,
+    const char* text,
+    const int window_size,
+    const int64_t first_block,
+    const int64_t steps_v,
+    const int64_t steps_h)
+{
+    const uint64_t num_words64 = window_size;
+    uint64_t *const Pv = windowed_matrix->Pv;
+    uint64_t *const Mv = windowed_matrix->Mv;
+    const uint64_t *const PEQ_window = windowed_matrix->PEQ_window;
+    const uint64_t *const PH_carry = windowed_matrix->PH_carry;
+    const uint64_t *const MH_carry = windowed_matrix->MH_carry;
+    if (first_block >= steps_v) return;
+
+    for (int64_t text_position = 0; text_position <= steps_h; ++text_position)
+    {
+        const uint8_t enc_char = (uint8_t)text[text_position];
+        uint64_t PHin = PH_carry[text_position], MHin = MH_carry[text_position], PHout, MHout;
+        for (int64_t i = first_block; i < steps_v; ++i)
+        {
+            const uint64_t bdp_idx = BPM_PATTERN_BDP_IDX(text_position, num_words64, i);
+            const uint64_t next_bdp_idx = bdp_idx + num_words64;
+            uint64_t Pv_in = Pv[bdp_idx];
+            uint64_t Mv_in = Mv[bdp_idx];
+            const uint64_t Eq = PEQ_window[BPM_PATTERN_PEQ_IDX(i, enc_char)];
+            BPM_ADVANCE_BLOCK_NO_MASK(Eq, Pv_in, Mv_in, PHin, MHin, PHout, MHout);
+            Pv[next_bdp_idx] = Pv_in;
+            Mv[next_bdp_idx] = Mv_in;
+            PHin = PHout;
+            MHin = MHout;
+        }
+    }
+}
+
+#ifdef QUICKED_SIMD_X86
+QUICKED_TARGET("avx2")
+void windowed_compute_window_avx2(
+    windowed_matrix_t *const windowed_matrix,
+    const windowed_pattern_t *const windowed_pattern,
+    const char* text,
+    const int window_size)
+{
+    const uint64_t num_words64 = window_size;
+    uint64_t *const Pv = windowed_matrix->Pv;
+    uint64_t *const Mv = windowed_matrix->Mv;
+    const uint64_t *const PEQ_window = windowed_matrix->PEQ_window;
+    uint64_t *const PH_carry = windowed_matrix->PH_carry;
+    uint64_t *const MH_carry = windowed_matrix->MH_carry;
+    const uint8_t *const text_window = windowed_matrix->text_window;
+    int64_t pos_v_fi = windowed_matrix->pos_v;
+    int64_t pos_h_fi = windowed_matrix->pos_h;
+
+    int64_t pos_v = (pos_v_fi - UINT64_LENGTH * (window_size) + 1 >= 0) ? pos_v_fi - UINT64_LENGTH * (window_size) + 1 : 0;
+    int64_t pos_h = (pos_h_fi - UINT64_LENGTH * (window_size) + 1 >= 0) ? pos_h_fi - UINT64_LENGTH * (window_size) + 1 : 0;
+
+    windowed_reset_left(windowed_matrix, pos_h, window_size);
+
+    int64_t steps_v = (pos_v_fi - pos_v) / UINT64_LENGTH + 1;
+    int64_t steps_h = pos_h_fi - pos_h;
+
+    windowed_compute_window_peq(windowed_matrix, windowed_pattern, pos_v, steps_v);
+    windowed_compute_window_setup_wavefront(windowed_matrix, text + pos_h, steps_h, windowed_top_carry(windowed_matrix, pos_v), 4);
+
+    const __m256i mask = _mm256_set1_epi64x(BPM_W64_MASK);
+    const __m256i lane = _mm256_set_epi64x(3, 2, 1, 0);
+    const __m256i last_column = _mm256_set1_epi64x(steps_h);
+    int64_t group;
+    for (group = 0; group + 4 <= steps_v; group += 4)
+    {
+        __m256i Pv_v = _mm256_loadu_si256((const __m256i *)&Pv[group]);
+        __m256i Mv_v = _mm256_loadu_si256((const __m256i *)&Mv[group]);
+        __m256i PHout = _mm256_setzero_si256(), MHout = _mm256_setzero_si256();
+        const __m256i peq_idx = _mm256_set1_epi64x(group * BPM_ALPHABET_LENGTH);
+        const __m256i lane_peq_idx = _mm256_add_epi64(peq_idx, _mm256_set_epi64x(3 * BPM_ALPHABET_LENGTH, 2 * BPM_ALPHABET_LENGTH, BPM_ALPHABET_LENGTH, 0));
+
+        for (int64_t step = 0; step <= steps_h + 3; ++step)
+        {
+            // Lane 0 takes the carries of the previous group, the others those of their lower lane
+            const uint64_t PH_first = (step <= steps_h) ? PH_carry[step] : 0;
+            const uint64_t MH_first = (step <= steps_h) ? MH_carry[step] : 0;
+            __m256i PHin = _mm256_permute4x64_epi64(PHout, _MM_SHUFFLE(2, 1, 0, 3));
+            __m256i MHin = _mm256_permute4x64_epi64(MHout, _MM_SHUFFLE(2, 1, 0, 3));
+            PHin = _mm256_blend_epi32(PHin, _mm256_castsi128_si256(_mm_cvtsi64_si128(PH_first)), 0x03);
+            MHin = _mm256_blend_epi32(MHin, _mm256_castsi128_si256(_mm_cvtsi64_si128(MH_first)), 0x03);
+
+            int32_t chars;
+            memcpy(&chars, &text_window[steps_h - step + 3], sizeof(chars));
+            const __m256i Eq_idx = _mm256_add_epi64(lane_peq_idx, _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(chars)));
+            const __m256i Eq = _mm256_i64gather_epi64((const long long *)PEQ_window, Eq_idx, 8);
+
+            __m256i Pv_out = Pv_v, Mv_out = Mv_v;
+            BPM_ADVANCE_BLOCK_SI256(Eq, mask, Pv_out, Mv_out, PHin, MHin, PHout, MHout);
+
+            // Lanes outside the window columns keep their state
+            const __m256i column = _mm256_sub_epi64(_mm256_set1_epi64x(step), lane);
+            const __m256i idle = _mm256_or_si256(_mm256_cmpgt_epi64(_mm256_setzero_si256(), column),
+                                                 _mm256_cmpgt_epi64(column, last_column));
+            Pv_v = _mm256_blendv_epi8(Pv_out, Pv_v, idle);
+            Mv_v = _mm256_blendv_epi8(Mv_out, Mv_v, idle);
+
+            uint64_t Pv_lanes[4], Mv_lanes[4];
+            _mm256_storeu_si256((__m256i *)Pv_lanes, Pv_v);
+            _mm256_storeu_si256((__m256i *)Mv_lanes, Mv_v);
+            const int64_t first_lane = MAX(0, step - steps_h), last_lane = MIN(3, step);
+            for (int64_t k = first_lane; k <= last_lane; ++k)
+            {
+                const uint64_t next_bdp_idx = BPM_PATTERN_BDP_IDX(step - k + 1, num_words64, group + k);
+                Pv[next_bdp_idx] = Pv_lanes[k];
+                Mv[next_bdp_idx] = Mv_lanes[k];
+            }
+
+            // The last lane hands its carries over to the next group
+            if (step >= 3)
+            {
+                PH_carry[step - 3] = _mm256_extract_epi64(PHout, 3);
+                MH_carry[step - 3] = _mm256_extract_epi64(MHout, 3);
+            }
+        }
+    }
+
+    windowed_compute_window_remaining_blocks(windowed_matrix, text + pos_h, window_size, group, steps_v, steps_h);
+}
+
+QUICKED_TARGET("avx512f")
+void windowed_compute_window_avx512(
+    windowed_matrix_t *const windowed_matrix,
+    const windowed_pattern_t *const windowed_pattern,
+    const char* text,
+    const int window_size)
+{
+    const uint64_t num_words64 = window_size;
+    uint64_t *const Pv = windowed_matrix->Pv;
+    uint64_t *const Mv = windowed_matrix->Mv;
+    const uint64_t *const PEQ_window = windowed_matrix->PEQ_window;
+    uint64_t *const PH_carry = windowed_matrix->PH_carry;
+    uint64_t *const MH_carry = windowed_matrix->MH_carry;
+    const uint8_t *const text_window = windowed_matrix->text_window;
+    int64_t pos_v_fi = windowed_matrix->pos_v;
+    int64_t pos_h_fi = windowed_matrix->pos_h;
+
+    int64_t pos_v = (pos_v_fi - UINT64_LENGTH * (window_size) + 1 >= 0) ? pos_v_fi - UINT64_LENGTH * (window_size) + 1 : 0;
+    int64_t pos_h = (pos_h_fi - UINT64_LENGTH * (window_size) + 1 >= 0) ? pos_h_fi - UINT64_LENGTH * (window_size) + 1 : 0;
+
+    windowed_reset_left(windowed_matrix, pos_h, window_size);
+
+    int64_t steps_v = (pos_v_fi - pos_v) / UINT64_LENGTH + 1;
+    int64_t steps_h = pos_h_fi - pos_h;
+
+    windowed_compute_window_peq(windowed_matrix, windowed_pattern, pos_v, steps_v);
+    windowed_compute_window_setup_wavefront(windowed_matrix, text + pos_h, steps_h, windowed_top_carry(windowed_matrix, pos_v), 8);
+
+    const __m512i ones = _mm512_set1_epi64(1);
+    const __m512i mask = _mm512_set1_epi64(BPM_W64_MASK);
+    // Lane k stores block (group+k) of column (step-k): (step+1-k)*num_words64 + group+k
+    int64_t lane_offsets[8];
+    for (int64_t k = 0; k < 8; ++k) lane_offsets[k] = k * (1 - (int64_t)num_words64);
+    const __m512i lane_offset = _mm512_loadu_si512((const void *)lane_offsets);
+    int64_t group;
+    for (group = 0; group + 8 <= steps_v; group += 8)
+    {
+        __m512i Pv_v = _mm512_loadu_si512((const void *)&Pv[group]);
+        __m512i Mv_v = _mm512_loadu_si512((const void *)&Mv[group]);
+        __mmask8 PHout = 0, MHout = 0;
+        const __m512i lane_peq_idx = _mm512_add_epi64(_mm512_set1_epi64(group * BPM_ALPHABET_LENGTH),
+                                                      _mm512_set_epi64(7 * BPM_ALPHABET_LENGTH, 6 * BPM_ALPHABET_LENGTH,
+                                                                       5 * BPM_ALPHABET_LENGTH, 4 * BPM_ALPHABET_LENGTH,
+                                                                       3 * BPM_ALPHABET_LENGTH, 2 * BPM_ALPHABET_LENGTH,
+                                                                       BPM_ALPHABET_LENGTH, 0));
+
+        for (int64_t step = 0; step <= steps_h + 7; ++step)
+        {
+            // Lane 0 takes the carries of the previous group, the others those of their lower lane
+            const __mmask8 PH_first = (step <= steps_h) ? (__mmask8)PH_carry[step] : 0;
+            const __mmask8 MH_first = (step <= steps_h) ? (__mmask8)MH_carry[step] : 0;
+            const __mmask8 PHin = (__mmask8)(PHout << 1) | PH_first;
+            const __mmask8 MHin = (__mmask8)(MHout << 1) | MH_first;
+
+            const __m512i chars = _mm512_cvtepu8_epi64(_mm_loadl_epi64((const __m128i *)&text_window[steps_h - step + 7]));
+            const __m512i Eq = _mm512_i64gather_epi64(_mm512_add_epi64(lane_peq_idx, chars), (const void *)PEQ_window, 8);
+
+            __m512i Pv_out = Pv_v, Mv_out = Mv_v;
+            BPM_ADVANCE_BLOCK_SI512(Eq, mask, ones, Pv_out, Mv_out, PHin, MHin, PHout, MHout);
+
+            // Lanes outside the window columns keep their state
+            const __mmask8 started = (step >= 7) ? 0xFF : (__mmask8)((2u << step) - 1);
+            const __mmask8 finished = (step > steps_h) ? (__mmask8)((1u << (step - steps_h)) - 1) : 0;
+            const __mmask8 active = started & ~finished;
+            Pv_v = _mm512_mask_mov_epi64(Pv_v, active, Pv_out);
+            Mv_v = _mm512_mask_mov_epi64(Mv_v, active, Mv_out);
+
+            const uint64_t next_bdp_idx = BPM_PATTERN_BDP_IDX(step + 1, num_words64, group);
+            _mm512_mask_i64scatter_epi64((void *)&Pv[next_bdp_idx], active, lane_offset, Pv_v, 8);
+            _mm512_mask_i64scatter_epi64((void *)&Mv[next_bdp_idx], active, lane_offset, Mv_v, 8);
+
+            // The last lane hands its carries over to the next group
+            if (step >= 7)
+            {
+                PH_carry[step - 7] = (PHout >> 7) & 1;
+                MH_carry[step - 7] = (MHout >> 7) & 1;
+            }
+        }
+    }
+
+    windowed_compute_window_remaining_blocks(windowed_matrix, text + pos_h, window_size, group, steps_v, steps_h);
+}
+#endif
+
+static inline __attribute__((always_inline)) void windowed_backtrace_emit(
     windowed_matrix_t *const windowed_matrix,
     const windowed_pattern_t *const windowed_pattern,
     const char* text,
     const int window_size,
-    const int overlap_size)
+    const int overlap_size,
+    const bool packed)
 {
     // Parameters
     const char* pattern = windowed_pattern->pattern;
     const uint64_t *const Pv = windowed_matrix->Pv;
     const uint64_t *const Mv = windowed_matrix->Mv;
-    char *const operations = windowed_matrix->cigar->operations;
-    int op_sentinel = windowed_matrix->cigar->begin_offset;
+    cigar_t *const cigar = windowed_matrix->cigar;
+    int op_sentinel = cigar->begin_offset;
     // Retrieve the alignment. Store the match
     const uint64_t num_words64 = window_size;
     int64_t h = windowed_matrix->pos_h;
@@ -466,6 +813,7 @@ void windowed_backtrace(
     int64_t h_overlap = windowed_matrix->pos_h - UINT64_LENGTH * (window_size - overlap_size) + 1 > 0 ? (windowed_matrix->pos_h - (window_size - overlap_size) * UINT64_LENGTH + 1) : 0;
     int64_t v_min = windowed_matrix->pos_v - UINT64_LENGTH * (window_size) + 1 > 0 ? (windowed_matrix->pos_v - (window_size)*UINT64_LENGTH + 1) : 0;
     int64_t v_overlap = windowed_matrix->pos_v - UINT64_LENGTH * (window_size - overlap_size) + 1 > 0 ? (windowed_matrix->pos_v - (window_size - overlap_size) * UINT64_LENGTH + 1) : 0;
+    int64_t score = 0;
 
     while (v >= v_overlap && h >= h_overlap)
     {
@@ -475,22 +823,25 @@ void windowed_backtrace(
 
         if (text[h] == pattern[v])
         {
-            operations[op_sentinel--] = 'M';
+            bpm_backtrace_push(cigar, &op_sentinel, packed, 'M', SAM_CIGAR_EQ);
             --h;
             --v;
         } else if (Pv[bdp_idx] & mask)
         {
-            operations[op_sentinel--] = 'D';
+            bpm_backtrace_push(cigar, &op_sentinel, packed, 'D', SAM_CIGAR_DEL);
+            score++;
             --v;
         }
         else if (Mv[(bdp_idx - num_words64)] & mask)
         {
-            operations[op_sentinel--] = 'I';
+            bpm_backtrace_push(cigar, &op_sentinel, packed, 'I', SAM_CIGAR_INS);
+            score++;
             --h;
         }
         else
         {
-            operations[op_sentinel--] = 'X';
+            bpm_backtrace_push(cigar, &op_sentinel, packed, 'X', SAM_CIGAR_X);
+            score++;
             --h;
             --v;
         }
@@ -498,7 +849,25 @@ void windowed_backtrace(
     windowed_matrix->pos_h = h;
     windowed_matrix->pos_v = v;
 
-    windowed_matrix->cigar->begin_offset = op_sentinel;
+    cigar->begin_offset = op_sentinel;
+    cigar->score += score;
+}
+
+void windowed_backtrace(
+    windowed_matrix_t *const windowed_matrix,
+    const windowed_pattern_t *const windowed_pattern,
+    const char* text,
+    const int window_size,
+    const int overlap_size)
+{
+    if (windowed_matrix->packed_cigar)
+    {
+        windowed_backtrace_emit(windowed_matrix, windowed_pattern, text, window_size, overlap_size, true);
+    }
+    else
+    {
+        windowed_backtrace_emit(windowed_matrix, windowed_pattern, text, window_size, overlap_size, false);
+    }
 }
 
 void windowed_backtrace_score_only(
@@ -560,9 +929,151 @@ void windowed_backtrace_score_only(
     windowed_matrix->cigar->score += score;
 }
 
+// Fills the window ending at (pos_v,pos_h) with the widest kernel available
+static void windowed_fill_window(
+    windowed_matrix_t *const windowed_matrix,
+    const windowed_pattern_t *const windowed_pattern,
+    const char* text,
+    const int window_size,
+    const quicked_simd_t simd)
+{
+    const int64_t window_cells = UINT64_LENGTH * window_size;
+    windowed_matrix->cells += MIN(windowed_matrix->pos_v + 1, window_cells) * MIN(windowed_matrix->pos_h + 1, window_cells);
+
+    // The SSE kernel is specific to window_size == 2 (and its top carries to global alignments);
+    // the wavefront kernels need a full group of blocks
+    #ifdef QUICKED_SIMD_X86
+    if (window_size == 2 && simd >= QUICKED_SIMD_SSE41 && !windowed_matrix->ends_free)
+    {
+        windowed_compute_window_sse(windowed_matrix, windowed_pattern, text, window_size);
+    }
+    else if (window_size >= 8 && simd >= QUICKED_SIMD_AVX512)
+    {
+        windowed_compute_window_avx512(windowed_matrix, windowed_pattern, text, window_size);
+    }
+    else if (window_size >= 4 && simd >= QUICKED_SIMD_AVX2)
+    {
+        windowed_compute_window_avx2(windowed_matrix, windowed_pattern, text, window_size);
+    }
+    else
+    #endif
+    {
+        UNUSED(simd);
+        windowed_compute_window(windowed_matrix, windowed_pattern, text, window_size);
+    }
+}
+
+/*
+ * Ends-free: cheapest cell of the last pattern row in the window just computed.
+ * Its top row is free and its left border charged, so the column sums of the
+ * vertical differences are scores comparable between windows. Ties go to the
+ * rightmost column.
+ */
+static int64_t windowed_best_column(
+    const windowed_matrix_t *const windowed_matrix,
+    const int window_size,
+    int64_t *const best_score)
+{
+    const uint64_t num_words64 = window_size;
+    const uint64_t *const Pv = windowed_matrix->Pv;
+    const uint64_t *const Mv = windowed_matrix->Mv;
+    const int64_t pos_v_fi = windowed_matrix->pos_v;
+    const int64_t pos_h_fi = windowed_matrix->pos_h;
+    const int64_t pos_v = MAX(pos_v_fi - UINT64_LENGTH * window_size + 1, 0);
+    const int64_t pos_h = MAX(pos_h_fi - UINT64_LENGTH * window_size + 1, 0);
+    const int64_t steps_v = (pos_v_fi - pos_v) / UINT64_LENGTH + 1;
+    const int64_t last_bits = (pos_v_fi - pos_v) % UINT64_LENGTH + 1;
+    const uint64_t last_mask = (last_bits == UINT64_LENGTH) ? BPM_W64_ONES : (1ULL << last_bits) - 1;
+
+    int64_t best_column = pos_h_fi;
+    *best_score = INT64_MAX;
+    for (int64_t column = 0; column <= pos_h_fi - pos_h; ++column)
+    {
+        int64_t score = 0;
+        for (int64_t i = 0; i < steps_v; ++i)
+        {
+            const uint64_t bdp_idx = BPM_PATTERN_BDP_IDX(column + 1, num_words64, i);
+            const uint64_t mask = (i == steps_v - 1) ? last_mask : BPM_W64_ONES;
+            score += __builtin_popcountll(Pv[bdp_idx] & mask) - __builtin_popcountll(Mv[bdp_idx] & mask);
+        }
+        if (score <= *best_score)
+        {
+            *best_score = score;
+            best_column = pos_h + column;
+        }
+    }
+    return best_column;
+}
+
+// Ends-free: keeps the cheapest last-row cell of the window ending at corner
+static void windowed_locate_end_window(
+    windowed_matrix_t *const windowed_matrix,
+    const windowed_pattern_t *const windowed_pattern,
+    const char* text,
+    const int window_size,
+    const quicked_simd_t simd,
+    const int64_t corner,
+    int64_t *const best_column,
+    int64_t *const best_score)
+{
+    windowed_matrix->pos_h = corner;
+    windowed_fill_window(windowed_matrix, windowed_pattern, text, window_size, simd);
+    int64_t score;
+    const int64_t column = windowed_best_column(windowed_matrix, window_size, &score);
+    if (score < *best_score)
+    {
+        *best_score = score;
+        *best_column = column;
+    }
+}
+
+/*
+ * Ends-free: the trailing text gaps are free, so the alignment ends on the
+ * cheapest cell of the last pattern row. Overlapping windows anchored on that
+ * row sweep the text from right to left to find it. A window only holds the
+ * alignment of its rows if its corner is close to where it ends (otherwise it
+ * pays for entering through the left border), so windows one block apart
+ * around the best cell found refine it.
+ */
+static void windowed_locate_end(
+    windowed_matrix_t *const windowed_matrix,
+    const windowed_pattern_t *const windowed_pattern,
+    const char* text,
+    const int window_size,
+    const int overlap_size,
+    const quicked_simd_t simd)
+{
+    const int64_t window_cells = UINT64_LENGTH * window_size;
+    const int64_t step = UINT64_LENGTH * (window_size - overlap_size);
+    const int64_t text_last = windowed_matrix->pos_h;
+    int64_t best_column = text_last;
+    int64_t best_score = INT64_MAX;
+
+    windowed_matrix->locating_end = true;
+    for (int64_t corner = text_last; ; corner -= step)
+    {
+        windowed_locate_end_window(windowed_matrix, windowed_pattern, text, window_size, simd,
+                                   corner, &best_column, &best_score);
+        if (corner < window_cells || best_score == 0) break; // The window reached the beginning of the text
+    }
+    const int64_t sweep_column = best_column;
+    for (int64_t corner = sweep_column - window_cells / 2; corner <= sweep_column + window_cells && best_score > 0; corner += UINT64_LENGTH)
+    {
+        if (corner >= 0 && corner <= text_last && corner != sweep_column)
+        {
+            windowed_locate_end_window(windowed_matrix, windowed_pattern, text, window_size, simd,
+                                       corner, &best_column, &best_score);
+        }
+    }
+    windowed_matrix->locating_end = false;
+
+    windowed_matrix->pos_h = best_column;
+    windowed_matrix->text_end = best_column + 1;
+}
+
 void windowed_compute(
     windowed_matrix_t *const windowed_matrix,
-    windowed_pattern_t *const windowed_pattern,
+    const windowed_pattern_t *const windowed_pattern,
     const char* text,
     const int hew_threshold,
     const int window_size,
@@ -570,20 +1081,15 @@ void windowed_compute(
     const bool score_only,
     const bool force_scalar)
 {
+    const quicked_simd_t simd = force_scalar ? QUICKED_SIMD_SCALAR : quicked_cpu_simd();
+    if (windowed_matrix->ends_free && windowed_matrix->pos_v >= 0 && windowed_matrix->pos_h >= 0)
+    {
+        windowed_locate_end(windowed_matrix, windowed_pattern, text, window_size, overlap_size, simd);
+    }
     while (windowed_matrix->pos_v >= 0 && windowed_matrix->pos_h >= 0)
     {
         // Fill window (Pv,Mv)
-        #ifdef __SSE4_1__
-        if (!force_scalar && window_size == 2) // Vectorized version only works for window_size == 2
-        {
-            windowed_compute_window_sse(windowed_matrix, windowed_pattern, text, window_size);
-        }
-        else
-        #endif
-        {
-            UNUSED(force_scalar);
-            windowed_compute_window(windowed_matrix, windowed_pattern, text, window_size);
-        }
+        windowed_fill_window(windowed_matrix, windowed_pattern, text, window_size, simd);
 
         // Compute window backtrace
         if (score_only)
@@ -596,10 +1102,15 @@ void windowed_compute(
         }
     }
 
+    int64_t h = windowed_matrix->pos_h;
+    int64_t v = windowed_matrix->pos_v;
+    if (windowed_matrix->ends_free && v < 0)
+    { // Leading text gaps are free
+        windowed_matrix->text_begin = h + 1;
+        h = -1;
+    }
     if (score_only)
     {
-        int64_t h = windowed_matrix->pos_h;
-        int64_t v = windowed_matrix->pos_v;
         if (h >= 0)
             windowed_matrix->cigar->score += h + 1;
         if (v >= 0)
@@ -607,22 +1118,29 @@ void windowed_compute(
     }
     else
     {
-        int64_t h = windowed_matrix->pos_h;
-        int64_t v = windowed_matrix->pos_v;
-        char *const operations = windowed_matrix->cigar->operations;
-        int op_sentinel = windowed_matrix->cigar->begin_offset;
+        cigar_t *const cigar = windowed_matrix->cigar;
+        const bool packed = windowed_matrix->packed_cigar;
+        int op_sentinel = cigar->begin_offset;
+        if (h >= 0)
+            cigar->score += h + 1;
+        if (v >= 0)
+            cigar->score += v + 1;
         while (h >= 0)
         {
-            operations[op_sentinel--] = 'I';
+            bpm_backtrace_push(cigar, &op_sentinel, packed, 'I', SAM_CIGAR_INS);
             --h;
         }
         while (v >= 0)
         {
-            operations[op_sentinel--] = 'D';
+            bpm_backtrace_push(cigar, &op_sentinel, packed, 'D', SAM_CIGAR_DEL);
             --v;
         }
+        if (packed)
+        {
+            cigar_reverse_CIGAR(cigar);
+        }
         windowed_matrix->pos_h = h;
         windowed_matrix->pos_v = v;
-        windowed_matrix->cigar->begin_offset = op_sentinel + 1;
+        cigar->begin_offset = op_sentinel + 1;
     }
 }
@@ -0,0 +1,227 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "quicked_utils/include/commons.h"
+#include "quicked_utils/include/mm_allocator.h"
+#include "bpm_xdrop.h"
+#include "bpm_commons.h"
+
+// Floor division for a possibly negative numerator (positive denominator)
+static inline int64_t xdrop_div_floor(
+    const int64_t numerator,
+    const int64_t denominator)
+{
+    return (numerator >= 0) ? numerator / denominator : -((-numerator + denominator - 1) / denominator);
+}
+
+/*
+ * Rows (v_first, v_last] of a block hold the distances D(v) of a column, from
+ * D_first to D_last. Since D changes by at most one per row,
+ * D(v) >= D_first - (v - v_first) and D(v) >= D_last - (v_last - v), which bound
+ * the score of row v by a rising and a falling line. Narrows [*v_begin, *v_end]
+ * to the rows that may score at least threshold; empty if *v_begin > *v_end.
+ */
+static inline void xdrop_block_rows(
+    const int64_t v_first,
+    const int64_t distance_first,
+    const int64_t v_last,
+    const int64_t distance_last,
+    const int64_t h,
+    const int64_t threshold,
+    int64_t *const v_begin,
+    int64_t *const v_end)
+{
+    const int64_t weight = BPM_XDROP_DISTANCE_WEIGHT;
+    // Score <= (weight + 1) * v + c_first and score <= c_last - (weight - 1) * v
+    const int64_t c_first = h - weight * (distance_first + v_first);
+    const int64_t c_last = h - weight * (distance_last - v_last);
+    *v_begin = MAX(v_first + 1, -xdrop_div_floor(c_first - threshold, weight + 1));
+    *v_end = MIN(v_last, xdrop_div_floor(c_last - threshold, weight - 1));
+}
+
+/*
+ * Best score among the rows [v_begin, v_end] of a block (see xdrop_block_rows), whose
+ * rows (v_first, v_first + 64] start at distance_first. Sets its row and distance
+ */
+static inline int64_t xdrop_block_best(
+    const uint64_t Pv,
+    const uint64_t Mv,
+    const int64_t v_first,
+    const int64_t distance_first,
+    const int64_t h,
+    const int64_t v_begin,
+    const int64_t v_end,
+    int64_t *const best_v,
+    int64_t *const best_distance)
+{
+    // Distance of the row above v_begin
+    const uint64_t above_mask = (v_begin - v_first - 1 == 0) ? 0 : BPM_W64_ONES >> (BPM_W64_LENGTH - (v_begin - v_first - 1));
+    int64_t distance = distance_first + POPCOUNT_64(Pv & above_mask) - POPCOUNT_64(Mv & above_mask);
+    int64_t best_score = INT64_MIN;
+    for (int64_t v = v_begin; v <= v_end; ++v)
+    {
+        const int64_t bit = v - v_first - 1;
+        distance += (int64_t)((Pv >> bit) & 1) - (int64_t)((Mv >> bit) & 1);
+        const int64_t score = BPM_XDROP_SCORE(v, h, distance);
+        if (score > best_score)
+        {
+            best_score = score;
+            *best_v = v;
+            *best_distance = distance;
+        }
+    }
+    return best_score;
+}
+
+/*
+ * Whether a row of the block may still score threshold: the bounds of xdrop_block_rows
+ * first, then the rows within them
+ */
+static inline bool xdrop_block_alive(
+    const uint64_t Pv,
+    const uint64_t Mv,
+    const uint64_t rows_mask,
+    const int64_t v_first,
+    const int64_t v_last,
+    const int64_t distance_last,
+    const int64_t h,
+    const int64_t threshold)
+{
+    const int64_t distance_first = distance_last - POPCOUNT_64(Pv & rows_mask) + POPCOUNT_64(Mv & rows_mask);
+    int64_t v_begin, v_end, best_v, best_distance;
+    xdrop_block_rows(v_first, distance_first, v_last, distance_last, h, threshold, &v_begin, &v_end);
+    return v_begin <= v_end &&
+           xdrop_block_best(Pv, Mv, v_first, distance_first, h, v_begin, v_end, &best_v, &best_distance) >= threshold;
+}
+
+void bpm_compute_xdrop(
+    const banded_pattern_t *const banded_pattern,
+    const char* text,
+    const int64_t text_length,
+    const int64_t xdrop,
+    cigar_t *const cigar,
+    workspace_pass_t *const pass,
+    mm_allocator_t *const mm_allocator,
+    uint64_t *const cells)
+{
+    // Pattern variables
+    const uint64_t *const PEQ = banded_pattern->PEQ;
+    const uint64_t PEQ_row_stride = banded_pattern->PEQ_row_stride;
+    const uint64_t *const level_mask = banded_pattern->level_mask;
+    const int64_t pattern_length = banded_pattern->pattern_length;
+    const int64_t num_words = banded_pattern->pattern_num_words64;
+
+    // A single column: the blocks [first_block, last_block] still within xdrop
+    uint64_t *const Pv = (uint64_t *)workspace_buffer_reserve(&pass->Pv, num_words * BPM_W64_SIZE, false, mm_allocator);
+    uint64_t *const Mv = (uint64_t *)workspace_buffer_reserve(&pass->Mv, num_words * BPM_W64_SIZE, false, mm_allocator);
+    int64_t *const scores = (int64_t *)workspace_buffer_reserve(&pass->scores, num_words * sizeof(int64_t), false, mm_allocator);
+    int64_t first_block = 0;
+    int64_t last_block = 0;
+    Pv[0] = BPM_W64_ONES;
+    Mv[0] = 0;
+    scores[0] = MIN(BPM_W64_LENGTH, pattern_length); // Distance of the last row of the block
+
+    int64_t best_score = 0; // Empty extension
+    int64_t best_v = 0, best_h = 0, best_distance = 0;
+
+    for (int64_t text_position = 0; text_position < text_length; ++text_position)
+    {
+        const int64_t h = text_position + 1;
+        const uint8_t enc_char = (uint8_t)text[text_position];
+        const uint64_t *const PEQ_row = PEQ + BPM_PATTERN_PEQ_ROW_IDX(0, enc_char, PEQ_row_stride);
+        *cells += (last_block - first_block + 1) * BPM_W64_LENGTH;
+
+        // Advance the blocks (the rows above the band are assumed to grow, as the first row does)
+        uint64_t PHin = 1, MHin = 0, PHout, MHout;
+        for (int64_t i = first_block; i <= last_block; ++i)
+        {
+            uint64_t Pv_in = Pv[i];
+            uint64_t Mv_in = Mv[i];
+            const uint64_t mask = level_mask[i];
+            const uint64_t Eq = PEQ_row[i];
+
+            BPM_ADVANCE_BLOCK(Eq, mask, Pv_in, Mv_in, PHin, MHin, PHout, MHout);
+
+            Pv[i] = Pv_in;
+            Mv[i] = Mv_in;
+            PHin = PHout;
+            MHin = MHout;
+            scores[i] += PHout - MHout;
+        }
+
+        // Look for a better cell, only in the rows that may hold one
+        for (int64_t i = first_block; i <= last_block; ++i)
+        {
+            const uint64_t rows_mask = level_mask[i] | (level_mask[i] - 1);
+            const int64_t v_first = i * BPM_W64_LENGTH;
+            const int64_t v_last = MIN(v_first + BPM_W64_LENGTH, pattern_length);
+            const int64_t distance_first = scores[i] - POPCOUNT_64(Pv[i] & rows_mask) + POPCOUNT_64(Mv[i] & rows_mask);
+            int64_t v_begin, v_end;
+            xdrop_block_rows(v_first, distance_first, v_last, scores[i], h, best_score + 1, &v_begin, &v_end);
+            if (v_begin > v_end) continue;
+            int64_t v, distance;
+            const int64_t score = xdrop_block_best(Pv[i], Mv[i], v_first, distance_first, h, v_begin, v_end, &v, &distance);
+            if (score > best_score)
+            {
+                best_score = score;
+                best_v = v;
+                best_h = h;
+                best_distance = distance;
+            }
+        }
+
+        // Drop the blocks at both ends of the band with every row more than xdrop below the best cell
+        const int64_t threshold = best_score - xdrop;
+        while (first_block <= last_block)
+        {
+            const int64_t v_first = first_block * BPM_W64_LENGTH;
+            if (xdrop_block_alive(Pv[first_block], Mv[first_block], level_mask[first_block] | (level_mask[first_block] - 1),
+                                  v_first, MIN(v_first + BPM_W64_LENGTH, pattern_length), scores[first_block], h, threshold)) break;
+            first_block++;
+        }
+        while (first_block <= last_block)
+        {
+            const int64_t v_first = last_block * BPM_W64_LENGTH;
+            if (xdrop_block_alive(Pv[last_block], Mv[last_block], level_mask[last_block] | (level_mask[last_block] - 1),
+                                  v_first, MIN(v_first + BPM_W64_LENGTH, pattern_length), scores[last_block], h, threshold)) break;
+            last_block--;
+        }
+        if (first_block > last_block) break; // The whole column dropped
+
+        // Grow the band downwards while its last row is still within xdrop (the new block starts as
+        // if it had only gaps from there, an upper bound of its distances)
+        const int64_t v_last = MIN((last_block + 1) * BPM_W64_LENGTH, pattern_length);
+        if (last_block + 1 < num_words && BPM_XDROP_SCORE(v_last, h, scores[last_block]) >= threshold)
+        {
+            last_block++;
+            Pv[last_block] = BPM_W64_ONES;
+            Mv[last_block] = 0;
+            scores[last_block] = scores[last_block - 1] + (MIN((last_block + 1) * BPM_W64_LENGTH, pattern_length) - v_last);
+        }
+    }
+
+    cigar->score = best_distance;
+    cigar->end_v = best_v;
+    cigar->end_h = best_h;
+}
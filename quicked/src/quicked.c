@@ -27,69 +27,332 @@
 #include "bpm_commons.h"
 #include "bpm_windowed.h"
 #include "bpm_hirschberg.h"
+#include "bpm_xdrop.h"
+#include "quicked_anchor.h"
+#include "quicked_hamming.h"
+#include "quicked_workspace.h"
+#include "quicked_pattern.h"
+#include "quicked_cpu.h"
+#include "quicked_encode.h"
 #include "quicked_utils/include/commons.h"
 #include "quicked_utils/include/profiler_timer.h"
 #include <stddef.h>
 
+// Streams num_matches matches to the CIGAR callback
+static void emit_matches(
+    quicked_aligner_t *aligner,
+    int num_matches)
+{
+    char matches[256];
+    memset(matches, 'M', sizeof(matches));
+    while (num_matches > 0)
+    {
+        const int chunk = MIN(num_matches, (int)sizeof(matches));
+        aligner->params->cigar_callback(matches, chunk, aligner->params->cigar_callback_data);
+        num_matches -= chunk;
+    }
+}
+
+// Streams core operations, after the trimmed prefix if it is still pending. The prefix waits for the
+// first core operations, so an alignment rejected before its traceback streams nothing
+static void stream_operations(
+    quicked_aligner_t *aligner,
+    const char* operations,
+    int num_operations)
+{
+    if (aligner->workspace->pending_prefix > 0)
+    {
+        emit_matches(aligner, aligner->workspace->pending_prefix);
+        aligner->workspace->pending_prefix = 0;
+    }
+    aligner->params->cigar_callback(operations, num_operations, aligner->params->cigar_callback_data);
+}
+
+// Hirschberg leaves, streamed through the aligner
+static void stream_hirschberg_leaf(
+    const char* operations,
+    int num_operations,
+    void* user_data)
+{
+    stream_operations((quicked_aligner_t *)user_data, operations, num_operations);
+}
+
+// Run-length string of the operations, between trimmed_prefix and trimmed_suffix matches
+static void print_cigar(
+    quicked_aligner_t *aligner,
+    char *const buffer,
+    const cigar_t *const cigar)
+{
+    const char* const operations = cigar->operations;
+    char last_op = 'M';
+    int last_op_length = aligner->trimmed_prefix;
+    int cursor = 0;
+    for (int i = cigar->begin_offset; i < cigar->end_offset; ++i)
+    {
+        if (operations[i] != last_op)
+        {
+            if (last_op_length > 0) cursor += sprintf(buffer + cursor, "%d%c", last_op_length, last_op);
+            last_op = operations[i];
+            last_op_length = 0;
+        }
+        ++last_op_length;
+    }
+    if (last_op != 'M' && aligner->trimmed_suffix > 0)
+    {
+        cursor += sprintf(buffer + cursor, "%d%c", last_op_length, last_op);
+        last_op = 'M';
+        last_op_length = 0;
+    }
+    last_op_length += (last_op == 'M') ? aligner->trimmed_suffix : 0;
+    if (last_op_length > 0) cursor += sprintf(buffer + cursor, "%d%c", last_op_length, last_op);
+    buffer[cursor] = '\0';
+}
+
+// Adds the trimmed matches ('=') to the SAM runs (reserve_packed_cigar leaves room for two more)
+static void attach_packed_matches(
+    quicked_aligner_t *aligner,
+    cigar_t *const cigar)
+{
+    uint32_t *const runs = cigar->cigar_buffer;
+    int num_runs = cigar->cigar_length;
+    if (aligner->trimmed_prefix > 0)
+    {
+        if (num_runs > 0 && (runs[0] & 0xf) == SAM_CIGAR_EQ)
+        {
+            runs[0] += (uint32_t)aligner->trimmed_prefix << 4;
+        }
+        else
+        {
+            memmove(runs + 1, runs, num_runs * sizeof(uint32_t));
+            runs[0] = ((uint32_t)aligner->trimmed_prefix << 4) | SAM_CIGAR_EQ;
+            num_runs++;
+        }
+    }
+    if (aligner->trimmed_suffix > 0)
+    {
+        if (num_runs > 0 && (runs[num_runs - 1] & 0xf) == SAM_CIGAR_EQ)
+        {
+            runs[num_runs - 1] += (uint32_t)aligner->trimmed_suffix << 4;
+        }
+        else
+        {
+            runs[num_runs++] = ((uint32_t)aligner->trimmed_suffix << 4) | SAM_CIGAR_EQ;
+        }
+    }
+    cigar->cigar_length = num_runs;
+}
+
+// The score is precomputed: accumulated by the backtraces, or set by the caller.
+// The trimmed matches are streamed around the core alignment (stream_operations, quicked_align_dispatch)
 void extract_results(
     quicked_aligner_t *aligner,
     cigar_t *const cigar)
 {
+    aligner->score = cigar->score;
+    aligner->cigar = NULL;
+    aligner->cigar_packed = NULL;
+    aligner->cigar_packed_length = 0;
     if (aligner->params->only_score)
     {
-        // Precomputed score
-        aligner->score = cigar->score;
+        return;
     }
-    else
+
+    // Streamed: the whole alignment as a single segment
+    if (aligner->params->cigar_callback != NULL)
     {
-        // CIGAR
         if (cigar->begin_offset < cigar->end_offset)
         {
-            int buf_size = (2 * (cigar->end_offset - cigar->begin_offset) + 10) * sizeof(char);
-            aligner->cigar = (char*) mm_allocator_malloc(aligner->mm_allocator, buf_size);
-            cigar_sprint(aligner->cigar, buf_size, cigar, true);
+            stream_operations(aligner, cigar->operations + cigar->begin_offset, cigar->end_offset - cigar->begin_offset);
+        }
+        return;
+    }
+
+    // CIGAR
+    const int trimmed = aligner->trimmed_prefix + aligner->trimmed_suffix;
+    if (aligner->params->cigar_format == QUICKED_CIGAR_PACKED)
+    {
+        if (trimmed > 0 && cigar->cigar_buffer != NULL)
+        {
+            attach_packed_matches(aligner, cigar);
         }
+        aligner->cigar_packed = cigar->cigar_buffer;
+        aligner->cigar_packed_length = cigar->cigar_length;
+    }
+    else if (cigar->begin_offset < cigar->end_offset || trimmed > 0)
+    {
+        int buf_size = (2 * (cigar->end_offset - cigar->begin_offset) + 32) * sizeof(char);
+        aligner->cigar = (char*) workspace_buffer_reserve(&aligner->workspace->cigar, buf_size, false, aligner->mm_allocator);
+        print_cigar(aligner, aligner->cigar, cigar);
+    }
+}
+
+// Packed output of a banded/windowed pass: its backtrace emits the SAM runs straight into the workspace.
+// Two more runs fit, for the trimmed matches
+static bool reserve_packed_cigar(
+    quicked_aligner_t *aligner,
+    cigar_t *const cigar,
+    const int max_operations)
+{
+    if (aligner->params->only_score || aligner->params->cigar_callback != NULL ||
+        aligner->params->cigar_format != QUICKED_CIGAR_PACKED)
+    {
+        return false;
+    }
+    cigar->cigar_buffer = (uint32_t*) workspace_buffer_reserve(&aligner->workspace->cigar_packed,
+                                                               (max_operations + 2) * sizeof(uint32_t), false, aligner->mm_allocator);
+    cigar->cigar_length = 0;
+    return true;
+}
 
-        // Score from CIGAR
-        aligner->score = cigar_score_edit(cigar);
+// Without an output CIGAR (callback or only_score), the Hirschberg leaves are streamed instead of
+// gathered, so no buffer proportional to the alignment is needed. Returns NULL otherwise.
+static hirschberg_stream_t *hirschberg_stream_init(
+    quicked_aligner_t *aligner,
+    hirschberg_stream_t *const stream)
+{
+    if (aligner->params->cigar_callback == NULL && !aligner->params->only_score)
+    {
+        return NULL;
     }
+    stream->callback = aligner->params->only_score ? NULL : stream_hirschberg_leaf;
+    stream->user_data = aligner;
+    stream->score = 0;
+    return stream;
+}
+
+static void hirschberg_reserve_cigar(
+    quicked_aligner_t *aligner,
+    cigar_t *const cigar_out,
+    const int max_operations,
+    const hirschberg_stream_t *const stream)
+{
+    cigar_out->operations = (stream != NULL) ? NULL :
+        (char *)workspace_buffer_reserve(&aligner->workspace->operations, max_operations * sizeof(char), false, aligner->mm_allocator);
+    cigar_out->begin_offset = (stream != NULL) ? 0 : max_operations;
+    cigar_out->end_offset = cigar_out->begin_offset;
+}
+
+// The Hirschberg traceback writes operations only: score them, and pack them if requested
+static void hirschberg_finish_cigar(
+    quicked_aligner_t *aligner,
+    cigar_t *const cigar_out,
+    const hirschberg_stream_t *const stream)
+{
+    if (stream != NULL)
+    {
+        cigar_out->score = stream->score;
+    }
+    else if (reserve_packed_cigar(aligner, cigar_out, cigar_out->end_offset - cigar_out->begin_offset))
+    {
+        uint32_t *cigar_buffer;
+        int cigar_length;
+        cigar_get_CIGAR(cigar_out, true, &cigar_buffer, &cigar_length);
+        cigar_out->score = cigar_score_edit_CIGAR(cigar_out);
+    }
+    else
+    {
+        cigar_out->score = cigar_score_edit(cigar_out);
+    }
+}
+
+/*
+ * Largest full matrix (Hirschberg leaf) an alignment may hold. Without a memory
+ * budget, leaves fit in the L2 cache: their backtrace then reads the matrix from
+ * cache, and the deeper recursion costs little since subproblem bands shrink.
+ */
+static uint64_t quicked_leaf_footprint(
+    const quicked_params_t *const params)
+{
+    if (params->memory_budget > 0)
+    {
+        return params->memory_budget;
+    }
+    const uint64_t cache_size = (quicked_cpu_cache_size(2) > 0) ? quicked_cpu_cache_size(2) : quicked_cpu_cache_size(3);
+    return (cache_size > 0) ? MIN(cache_size, BUFFER_SIZE_16M) : BUFFER_SIZE_16M;
+}
+
+static int banded_cutoff_score(
+    const quicked_aligner_t *aligner,
+    const int pattern_len,
+    const int text_len)
+{
+    // FIXME: What if cutoff_score becomes 0?
+    // Ends-free: the band is relative to the aligned span, not to the whole text
+    const int aligned_len = aligner->params->ends_free ? pattern_len : MAX(text_len, pattern_len);
+    int cutoff_score = (aligned_len * (aligner->params->bandwidth)) / 100;
+    // Decision mode: a band of max_score already contains any alignment within max_score
+    const int max_score = aligner->params->max_score;
+    if (max_score >= 0) cutoff_score = MIN(cutoff_score, max_score);
+    return cutoff_score;
+}
+
+// The full banded matrix does not fit in the memory budget: Hirschberg divides it instead
+static bool banded_over_budget(
+    const quicked_aligner_t *aligner,
+    const int pattern_len,
+    const int text_len)
+{
+    const quicked_params_t *const params = aligner->params;
+    return params->memory_budget > 0 && !params->only_score &&
+           banded_matrix_footprint(pattern_len, text_len, banded_cutoff_score(aligner, pattern_len, text_len),
+                                   params->ends_free) > params->memory_budget;
 }
 
 quicked_status_t run_banded(
     quicked_aligner_t *aligner,
+    const quicked_pattern_t *compiled_pattern,
     const char* pattern, const int pattern_len,
     const char* text, const int text_len)
 {
-    // FIXME: What if cutoff_score becomes 0?
-    const int cutoff_score = (MAX(text_len, pattern_len) * (aligner->params->bandwidth)) / 100;
+    const int cutoff_score = banded_cutoff_score(aligner, pattern_len, text_len);
+    const int max_score = aligner->params->max_score;
 
     // Allocate
     mm_allocator_t *const mm_allocator = aligner->mm_allocator;
+    quicked_workspace_t *const workspace = aligner->workspace;
 
-    banded_pattern_t banded_pattern;
-    banded_pattern_compile(&banded_pattern, pattern, pattern_len, mm_allocator);
+    const banded_pattern_t *banded_pattern = (compiled_pattern != NULL) ? &compiled_pattern->banded : NULL;
+    banded_pattern_t banded_pattern_local;
+    if (banded_pattern == NULL)
+    {
+        banded_pattern_compile_workspace(&banded_pattern_local, pattern, pattern_len, aligner->simd, &workspace->forward, mm_allocator);
+        banded_pattern = &banded_pattern_local;
+    }
 
     banded_matrix_t banded_matrix;
-    banded_matrix_allocate(&banded_matrix, pattern_len, text_len, cutoff_score, aligner->params->only_score, mm_allocator);
+    banded_matrix_allocate_workspace(&banded_matrix, pattern_len, text_len, cutoff_score, aligner->params->only_score,
+                                     aligner->params->ends_free, &workspace->forward, mm_allocator);
+    banded_matrix.early_exit_score = max_score;
+    banded_matrix.num_threads = aligner->params->num_threads; // Score-only passes only
+    banded_matrix.packed_cigar = reserve_packed_cigar(aligner, banded_matrix.cigar, pattern_len + text_len);
 
     // Align
     timer_start(aligner->timer);
-    banded_compute(&banded_matrix, &banded_pattern, text, text_len, text_len, aligner->params->only_score, aligner->params->force_scalar);
+    banded_compute(&banded_matrix, banded_pattern, text, text_len, text_len, aligner->params->only_score, aligner->params->force_scalar);
     timer_stop(aligner->timer);
 
-    // Retrieve results
-    extract_results(aligner, banded_matrix.cigar);
+    aligner->stats.final_cutoff = cutoff_score;
+    aligner->stats.cells += banded_matrix.cells;
 
-    // Free
-    banded_pattern_free(&banded_pattern, mm_allocator);
+    if (banded_matrix.early_exit)
+    {
+        return QUICKED_ABOVE_MAX_SCORE;
+    }
 
-    banded_matrix_free(&banded_matrix, mm_allocator);
+    // Retrieve results
+    extract_results(aligner, banded_matrix.cigar);
+    if (aligner->params->ends_free)
+    { // Global alignments keep the whole text, set by quicked_align_dispatch (the matrix only spans its trimmed core)
+        aligner->text_begin = banded_matrix.text_begin;
+        aligner->text_end = banded_matrix.text_end;
+    }
 
     return QUICKED_WIP;
 }
 
 quicked_status_t run_windowed(
     quicked_aligner_t *aligner,
+    const quicked_pattern_t *compiled_pattern,
     const char* pattern, const int pattern_len,
     const char* text, const int text_len)
 {
@@ -98,94 +361,255 @@ quicked_status_t run_windowed(
 
     // Allocate
     mm_allocator_t *const mm_allocator = aligner->mm_allocator;
+    quicked_workspace_t *const workspace = aligner->workspace;
 
-    windowed_pattern_t windowed_pattern;
-    windowed_pattern_compile(&windowed_pattern, pattern, pattern_len, mm_allocator);
+    const windowed_pattern_t *windowed_pattern = (compiled_pattern != NULL) ? &compiled_pattern->windowed : NULL;
+    windowed_pattern_t windowed_pattern_local;
+    if (windowed_pattern == NULL)
+    {
+        windowed_pattern_compile_workspace(&windowed_pattern_local, pattern, pattern_len, aligner->simd, &workspace->forward, mm_allocator);
+        windowed_pattern = &windowed_pattern_local;
+    }
 
     windowed_matrix_t windowed_matrix;
-    windowed_matrix_allocate(&windowed_matrix, pattern_len, text_len, mm_allocator, window_size);
+    windowed_matrix_allocate_workspace(&windowed_matrix, pattern_len, text_len, window_size, aligner->params->only_score,
+                                       &workspace->forward, mm_allocator);
+    windowed_matrix.ends_free = aligner->params->ends_free;
+    windowed_matrix.packed_cigar = reserve_packed_cigar(aligner, windowed_matrix.cigar, pattern_len + text_len);
 
     // Align
     timer_start(aligner->timer);
-    windowed_compute(&windowed_matrix, &windowed_pattern, text, 0, window_size, overlap_size,
+    windowed_compute(&windowed_matrix, windowed_pattern, text, 0, window_size, overlap_size,
                      aligner->params->only_score, aligner->params->force_scalar);
     timer_stop(aligner->timer);
 
+    aligner->stats.cells += windowed_matrix.cells;
 
     // Retrieve results
     extract_results(aligner, windowed_matrix.cigar);
-
-    // Free
-    windowed_pattern_free(&windowed_pattern, mm_allocator);
-    windowed_matrix_free(&windowed_matrix, mm_allocator);
+    if (aligner->params->ends_free)
+    { // Global alignments keep the whole text (see run_banded)
+        aligner->text_begin = windowed_matrix.text_begin;
+        aligner->text_end = windowed_matrix.text_end;
+    }
 
     return QUICKED_WIP;
 }
 
+static quicked_status_t run_hirschberg_traceback(
+    quicked_aligner_t *aligner,
+    const quicked_pattern_t *compiled_pattern,
+    const char* text, const char* text_r, const int text_len,
+    const char* pattern, const char* pattern_r, const int pattern_len,
+    const int64_t cutoff_score,
+    cigar_t *const cigar_out,
+    hirschberg_stream_t *const stream)
+{
+    const banded_pattern_t *const banded_pattern = (compiled_pattern != NULL) ? &compiled_pattern->banded : NULL;
+    const banded_pattern_t *const banded_pattern_r = (compiled_pattern != NULL) ? &compiled_pattern->banded_r : NULL;
+    const uint64_t leaf_footprint = quicked_leaf_footprint(aligner->params);
+    hirschberg_stats_t hirschberg_stats = {0};
+    quicked_status_t status;
+
+    // Streaming needs the leaves in order, so it runs serially
+    if (aligner->params->num_threads > 1 && stream == NULL)
+    {
+        if (aligner->workspace_pool == NULL)
+        {
+            aligner->workspace_pool = quicked_workspace_pool_new(quicked_workspace_segment_size(aligner->params->memory_budget, BUFFER_SIZE_16M),
+                                                                 aligner->params->allocator_pool);
+        }
+        status = bpm_compute_matrix_hirschberg_parallel(text, text_r, text_len, pattern, pattern_r, pattern_len,
+                                                        cutoff_score, leaf_footprint, cigar_out, aligner->params->force_scalar,
+                                                        banded_pattern, banded_pattern_r,
+                                                        aligner->workspace_pool, aligner->params->num_threads,
+                                                        &hirschberg_stats);
+    }
+    else
+    {
+        status = bpm_compute_matrix_hirschberg(text, text_r, text_len, pattern, pattern_r, pattern_len,
+                                               cutoff_score, leaf_footprint, cigar_out, aligner->params->force_scalar,
+                                               banded_pattern, banded_pattern_r, aligner->workspace,
+                                               stream, &hirschberg_stats);
+    }
+
+    aligner->stats.final_cutoff = cutoff_score;
+    aligner->stats.hirschberg_depth = hirschberg_stats.max_depth;
+    aligner->stats.cells += hirschberg_stats.cells;
+
+    return status;
+}
+
+/*
+ * Ends-free: a forward pass (free leading gaps) finds where the best alignment
+ * ends, and a reverse pass over the text up to there finds where it begins.
+ * The alignment is global within that span. Returns its score.
+ */
+static int64_t locate_ends_free(
+    quicked_aligner_t *aligner,
+    const quicked_pattern_t *compiled_pattern,
+    const char* pattern, const char* pattern_r, const int pattern_len,
+    const char* text, const char* text_r, const int text_len,
+    const int64_t cutoff_score,
+    int *const text_begin,
+    int *const text_end)
+{
+    mm_allocator_t *const mm_allocator = aligner->mm_allocator;
+    quicked_workspace_t *const workspace = aligner->workspace;
+
+    const banded_pattern_t *banded_pattern = (compiled_pattern != NULL) ? &compiled_pattern->banded : NULL;
+    banded_pattern_t banded_pattern_local;
+    if (banded_pattern == NULL)
+    {
+        banded_pattern_compile_workspace(&banded_pattern_local, pattern, pattern_len, aligner->simd, &workspace->forward, mm_allocator);
+        banded_pattern = &banded_pattern_local;
+    }
+    banded_matrix_t banded_matrix;
+    banded_matrix_allocate_workspace(&banded_matrix, pattern_len, text_len, cutoff_score, SCORE_ONLY, true,
+                                     &workspace->forward, mm_allocator);
+    banded_compute(&banded_matrix, banded_pattern, text, text_len, text_len, SCORE_ONLY, aligner->params->force_scalar);
+    aligner->stats.cells += banded_matrix.cells;
+
+    const int64_t score = banded_matrix.cigar->score;
+    const int end = banded_matrix.text_end;
+    if (end == 0)
+    { // Only deletions: substituting the first bases instead costs the same
+        *text_begin = 0;
+        *text_end = MIN(pattern_len, text_len);
+        return score;
+    }
+
+    const banded_pattern_t *banded_pattern_r = (compiled_pattern != NULL) ? &compiled_pattern->banded_r : NULL;
+    banded_pattern_t banded_pattern_r_local;
+    if (banded_pattern_r == NULL)
+    {
+        banded_pattern_compile_workspace(&banded_pattern_r_local, pattern_r, pattern_len, aligner->simd, &workspace->reverse, mm_allocator);
+        banded_pattern_r = &banded_pattern_r_local;
+    }
+    banded_matrix_t banded_matrix_r;
+    banded_matrix_allocate_workspace(&banded_matrix_r, pattern_len, end, cutoff_score, SCORE_ONLY, true,
+                                     &workspace->reverse, mm_allocator);
+    banded_compute(&banded_matrix_r, banded_pattern_r, text_r + (text_len - end), end, end,
+                   SCORE_ONLY, aligner->params->force_scalar);
+    aligner->stats.cells += banded_matrix_r.cells;
+
+    *text_begin = end - banded_matrix_r.text_end;
+    *text_end = end;
+    return score;
+}
+
 quicked_status_t run_hirschberg(
     quicked_aligner_t *aligner,
+    const quicked_pattern_t *compiled_pattern,
     const char* pattern, const int pattern_len,
     const char* text, const int text_len)
 {
     // FIXME: What if cutoff_score becomes 0?
-    const int cutoff_score = (MAX(text_len, pattern_len) * (aligner->params->bandwidth)) / 100;
+    const int aligned_len = aligner->params->ends_free ? pattern_len : MAX(text_len, pattern_len);
+    int64_t cutoff_score = (aligned_len * (aligner->params->bandwidth)) / 100;
 
     // Allocate
     mm_allocator_t *const mm_allocator = aligner->mm_allocator;
+    quicked_workspace_t *const workspace = aligner->workspace;
 
-    char *text_r = (char *)mm_allocator_malloc(mm_allocator, text_len);
-    char *pattern_r = (char *)mm_allocator_malloc(mm_allocator, pattern_len);
-
+    char *text_r = (char *)workspace_buffer_reserve(&workspace->text_r, text_len, false, mm_allocator);
     reverse_string(text, text_r, text_len);
-    reverse_string(pattern, pattern_r, pattern_len);
 
-    cigar_t cigar_out;
-    cigar_out.operations = (char *)  mm_allocator_malloc(aligner->mm_allocator, (pattern_len + text_len) * sizeof(char));
-    cigar_out.begin_offset = pattern_len + text_len;
-    cigar_out.end_offset = pattern_len + text_len;
+    const char *pattern_r = (compiled_pattern != NULL) ? compiled_pattern->pattern_r : NULL;
+    if (pattern_r == NULL)
+    {
+        char *const pattern_r_buffer = (char *)workspace_buffer_reserve(&workspace->pattern_r, pattern_len, false, mm_allocator);
+        reverse_string(pattern, pattern_r_buffer, pattern_len);
+        pattern_r = pattern_r_buffer;
+    }
 
     // Align
     timer_start(aligner->timer);
-    quicked_status_t status = bpm_compute_matrix_hirschberg(text, text_r, text_len, pattern, pattern_r, pattern_len,
-                                  cutoff_score, &cigar_out, aligner->params->force_scalar, mm_allocator);
+
+    // Ends-free: the alignment is global within the span of the text it covers
+    int text_begin = 0, text_end = text_len;
+    if (aligner->params->ends_free)
+    {
+        cutoff_score = locate_ends_free(aligner, compiled_pattern, pattern, pattern_r, pattern_len,
+                                        text, text_r, text_len, cutoff_score, &text_begin, &text_end);
+        aligner->text_begin = text_begin;
+        aligner->text_end = text_end;
+        if (aligner->params->only_score)
+        {
+            timer_stop(aligner->timer);
+            cigar_t cigar_score = {.score = cutoff_score};
+            extract_results(aligner, &cigar_score);
+            return QUICKED_WIP;
+        }
+    }
+
+    hirschberg_stream_t stream_local;
+    hirschberg_stream_t *const stream = hirschberg_stream_init(aligner, &stream_local);
+    cigar_t cigar_out;
+    hirschberg_reserve_cigar(aligner, &cigar_out, pattern_len + text_end - text_begin, stream);
+
+    quicked_status_t status = run_hirschberg_traceback(aligner, compiled_pattern, text + text_begin, text_r + (text_len - text_end),
+                                                       text_end - text_begin, pattern, pattern_r, pattern_len,
+                                                       cutoff_score, &cigar_out, stream);
     timer_stop(aligner->timer);
 
     // Retrieve results
+    hirschberg_finish_cigar(aligner, &cigar_out, stream);
     extract_results(aligner, &cigar_out);
 
-    // Free
-    mm_allocator_free(mm_allocator, cigar_out.operations);
-    mm_allocator_free(mm_allocator, pattern_r);
-    mm_allocator_free(mm_allocator, text_r);
     return status;
 }
 
+// pattern_r: NULL if the reversed pattern is precompiled
+static void reverse_sequences(
+    const char* text, char *text_r, const int text_len,
+    const char* pattern, char *pattern_r, const int pattern_len)
+{
+    reverse_string(text, text_r, text_len);
+    if (pattern_r != NULL) reverse_string(pattern, pattern_r, pattern_len);
+}
+
 quicked_status_t run_quicked(
     quicked_aligner_t *aligner,
+    const quicked_pattern_t *compiled_pattern,
     const char* pattern, const int pattern_len,
     const char* text, const int text_len)
 {
     // TODO: Comment phases of the algorithm
 
     mm_allocator_t *const mm_allocator = aligner->mm_allocator;
-
-    char *text_r = (char *)mm_allocator_malloc(mm_allocator, text_len);
-    char *pattern_r = (char *)mm_allocator_malloc(mm_allocator, pattern_len);
-
-    reverse_string(text, text_r, text_len);
-    reverse_string(pattern, pattern_r, pattern_len);
-
-    windowed_pattern_t windowed_pattern;
-    windowed_pattern_compile(&windowed_pattern, pattern, pattern_len, mm_allocator);
+    quicked_workspace_t *const workspace = aligner->workspace;
+    const bool ends_free = aligner->params->ends_free;
+    // Ends-free: the error thresholds are relative to the aligned span, not to the whole text
+    const int aligned_len = ends_free ? pattern_len : MAX(text_len, pattern_len);
+
+    // The sequences are reversed once needed: by the reverse large-window pass, or before the traceback
+    char *const text_r = (char *)workspace_buffer_reserve(&workspace->text_r, text_len, false, mm_allocator);
+    const char *pattern_r = (compiled_pattern != NULL) ? compiled_pattern->pattern_r : NULL;
+    char *const pattern_r_buffer = (pattern_r == NULL) ?
+                                   (char *)workspace_buffer_reserve(&workspace->pattern_r, pattern_len, false, mm_allocator) : NULL;
+    if (pattern_r == NULL) pattern_r = pattern_r_buffer;
+    bool reversed = false;
+
+    // The forward pattern is compiled once and shared by both window sizes
+    const windowed_pattern_t *windowed_pattern = (compiled_pattern != NULL) ? &compiled_pattern->windowed : NULL;
+    windowed_pattern_t windowed_pattern_local;
+    if (windowed_pattern == NULL)
+    {
+        windowed_pattern_compile_workspace(&windowed_pattern_local, pattern, pattern_len, aligner->simd, &workspace->forward, mm_allocator);
+        windowed_pattern = &windowed_pattern_local;
+    }
 
     windowed_matrix_t windowed_matrix;
-    windowed_matrix_allocate(&windowed_matrix, pattern_len, text_len, mm_allocator, QUICKED_FAST_WINDOW_SIZE);
+    windowed_matrix_allocate_workspace(&windowed_matrix, pattern_len, text_len, QUICKED_FAST_WINDOW_SIZE, SCORE_ONLY,
+                                       &workspace->forward, mm_allocator);
+    windowed_matrix.ends_free = ends_free;
 
     timer_start(aligner->timer);
     timer_start(aligner->timer_windowed_s);
 
     // Align
-    windowed_compute(&windowed_matrix, &windowed_pattern, text,
+    windowed_compute(&windowed_matrix, windowed_pattern, text,
                     aligner->params->hew_threshold[0],
                     QUICKED_FAST_WINDOW_SIZE, QUICKED_FAST_WINDOW_OVERLAP,
                     SCORE_ONLY, aligner->params->force_scalar);
@@ -193,114 +617,330 @@ quicked_status_t run_quicked(
     timer_stop(aligner->timer_windowed_s);
 
     int64_t score = windowed_matrix.cigar->score;
+    aligner->stats.bound_stage = QUICKED_STAGE_WINDOWED_S;
+    aligner->stats.high_error_windows[0] = windowed_matrix.high_error_window;
+    aligner->stats.cells += windowed_matrix.cells;
 
-    // Free
-    windowed_pattern_free(&windowed_pattern, mm_allocator);
-    windowed_matrix_free(&windowed_matrix, mm_allocator);
-
-    if((windowed_matrix.high_error_window * 64) >
-        (MAX(text_len, pattern_len) * aligner->params->hew_percentage[0] / 100))
+    if (aligner->params->max_score >= 0)
     {
-        timer_start(aligner->timer_windowed_l);
+        // Decision mode: the windowed score is an upper bound, so only a bound above max_score needs checking
+        const int max_score = aligner->params->max_score;
+        if (score > max_score)
+        {
+            timer_start(aligner->timer_banded);
 
-        windowed_pattern_compile(&windowed_pattern, pattern, pattern_len, mm_allocator);
-        windowed_matrix_allocate(&windowed_matrix, pattern_len, text_len, mm_allocator, aligner->params->window_size);
+            const banded_pattern_t *banded_pattern = (compiled_pattern != NULL) ? &compiled_pattern->banded : NULL;
+            banded_pattern_t banded_pattern_local;
+            if (banded_pattern == NULL)
+            {
+                banded_pattern_compile_workspace(&banded_pattern_local, pattern, pattern_len, aligner->simd, &workspace->forward, mm_allocator);
+                banded_pattern = &banded_pattern_local;
+            }
 
-        windowed_compute(&windowed_matrix, &windowed_pattern, text,
-                aligner->params->hew_threshold[1],
-                aligner->params->window_size, aligner->params->overlap_size,
-                SCORE_ONLY, aligner->params->force_scalar);
+            banded_matrix_t banded_matrix_score;
+            banded_matrix_allocate_workspace(&banded_matrix_score, pattern_len, text_len, max_score, SCORE_ONLY, ends_free,
+                                             &workspace->forward, mm_allocator);
+            banded_matrix_score.early_exit_score = max_score;
+            banded_matrix_score.num_threads = aligner->params->num_threads;
 
-        score = windowed_matrix.cigar->score;
-        uint64_t high_error_window = windowed_matrix.high_error_window;
+            banded_compute(&banded_matrix_score, banded_pattern, text, text_len, text_len, SCORE_ONLY, aligner->params->force_scalar);
+
+            timer_stop(aligner->timer_banded);
+
+            score = banded_matrix_score.cigar->score;
+            aligner->stats.bound_stage = QUICKED_STAGE_BANDED;
+            aligner->stats.final_cutoff = max_score;
+            aligner->stats.cells += banded_matrix_score.cells;
+            if (banded_matrix_score.early_exit || score > max_score || score < 0)
+            {
+                timer_stop(aligner->timer);
+                return QUICKED_ABOVE_MAX_SCORE;
+            }
+        }
+
+        if (aligner->params->only_score)
+        {
+            // Within max_score. The score is the tightest bound found, not necessarily the exact distance
+            timer_stop(aligner->timer);
+            aligner->score = score;
+            return QUICKED_WIP;
+        }
+    }
+    else if((windowed_matrix.high_error_window * 64) >
+        (aligned_len * aligner->params->hew_percentage[0] / 100))
+    {
+        timer_start(aligner->timer_windowed_l);
 
-        // TODO: This free/alloc could be avoided
-        windowed_pattern_free(&windowed_pattern, mm_allocator);
-        windowed_matrix_free(&windowed_matrix, mm_allocator);
+        windowed_matrix_allocate_workspace(&windowed_matrix, pattern_len, text_len, aligner->params->window_size, SCORE_ONLY,
+                                           &workspace->forward, mm_allocator);
+        windowed_matrix.ends_free = ends_free;
 
-        windowed_pattern_compile(&windowed_pattern, pattern_r, pattern_len, mm_allocator);
-        windowed_matrix_allocate(&windowed_matrix, pattern_len, text_len, mm_allocator, aligner->params->window_size);
+        windowed_matrix_t windowed_matrix_r;
 
-        windowed_compute(&windowed_matrix, &windowed_pattern, text_r,
-                aligner->params->hew_threshold[1],
-                aligner->params->window_size, aligner->params->overlap_size,
-                SCORE_ONLY, aligner->params->force_scalar);
+        // The forward and reverse passes are independent: with num_threads > 1 they run on two threads.
+        // Only the reverse one touches the allocator, the forward matrix is reserved above
+        const bool parallel = (aligner->params->num_threads > 1);
+        UNUSED(parallel); // Serial without OpenMP
+        #pragma omp parallel sections num_threads(2) if(parallel) default(shared)
+        {
+            #pragma omp section
+            windowed_compute(&windowed_matrix, windowed_pattern, text,
+                    aligner->params->hew_threshold[1],
+                    aligner->params->window_size, aligner->params->overlap_size,
+                    SCORE_ONLY, aligner->params->force_scalar);
 
-        score = MIN(score, windowed_matrix.cigar->score);
-        if (score >= windowed_matrix.cigar->score) high_error_window = windowed_matrix.high_error_window;
+            #pragma omp section
+            {
+                reverse_sequences(text, text_r, text_len, pattern, pattern_r_buffer, pattern_len);
+
+                const windowed_pattern_t *windowed_pattern_r = (compiled_pattern != NULL) ? &compiled_pattern->windowed_r : NULL;
+                windowed_pattern_t windowed_pattern_r_local;
+                if (windowed_pattern_r == NULL)
+                {
+                    windowed_pattern_compile_workspace(&windowed_pattern_r_local, pattern_r, pattern_len, aligner->simd, &workspace->reverse, mm_allocator);
+                    windowed_pattern_r = &windowed_pattern_r_local;
+                }
+
+                windowed_matrix_allocate_workspace(&windowed_matrix_r, pattern_len, text_len, aligner->params->window_size, SCORE_ONLY,
+                                                   &workspace->reverse, mm_allocator);
+                windowed_matrix_r.ends_free = ends_free;
+
+                windowed_compute(&windowed_matrix_r, windowed_pattern_r, text_r,
+                        aligner->params->hew_threshold[1],
+                        aligner->params->window_size, aligner->params->overlap_size,
+                        SCORE_ONLY, aligner->params->force_scalar);
+            }
+        }
+        reversed = true;
 
-        windowed_pattern_free(&windowed_pattern, mm_allocator);
-        windowed_matrix_free(&windowed_matrix, mm_allocator);
+        score = windowed_matrix.cigar->score;
+        uint64_t high_error_window = windowed_matrix.high_error_window;
+        score = MIN(score, windowed_matrix_r.cigar->score);
+        if (score >= windowed_matrix_r.cigar->score) high_error_window = windowed_matrix_r.high_error_window;
 
         timer_stop(aligner->timer_windowed_l);
 
+        aligner->stats.bound_stage = QUICKED_STAGE_WINDOWED_L;
+        aligner->stats.high_error_windows[1] = high_error_window;
+        aligner->stats.cells += windowed_matrix.cells + windowed_matrix_r.cells;
+
         if((high_error_window * 64 * (aligner->params->window_size - aligner->params->overlap_size)) >
-            (MAX(text_len, pattern_len) * aligner->params->hew_percentage[1] / 100))
+            (aligned_len * aligner->params->hew_percentage[1] / 100))
         {
             timer_start(aligner->timer_banded);
 
-            banded_pattern_t banded_pattern;
+            const banded_pattern_t *banded_pattern = (compiled_pattern != NULL) ? &compiled_pattern->banded : NULL;
+            banded_pattern_t banded_pattern_local;
+            if (banded_pattern == NULL)
+            {
+                banded_pattern_compile_workspace(&banded_pattern_local, pattern, pattern_len, aligner->simd, &workspace->forward, mm_allocator);
+                banded_pattern = &banded_pattern_local;
+            }
+
             banded_matrix_t banded_matrix_score;
-            banded_pattern_compile(&banded_pattern, pattern, pattern_len, mm_allocator);
 
-            score = MIN(MAX(text_len, pattern_len) * aligner->params->bandwidth / 100, score);
+            score = MIN(aligned_len * aligner->params->bandwidth / 100, score);
 
-            banded_matrix_allocate(&banded_matrix_score, pattern_len, text_len, score, SCORE_ONLY, mm_allocator);
+            banded_matrix_allocate_workspace(&banded_matrix_score, pattern_len, text_len, score, SCORE_ONLY, ends_free,
+                                             &workspace->forward, mm_allocator);
+            // A pass that cannot end below the acceptance threshold of the loop below is abandoned mid-sweep
+            banded_matrix_score.early_exit_score = MAX(aligned_len / 4, score * 3/2);
+            banded_matrix_score.num_threads = aligner->params->num_threads;
 
-            banded_compute(&banded_matrix_score, &banded_pattern, text, text_len, text_len, SCORE_ONLY, aligner->params->force_scalar);
+            banded_compute(&banded_matrix_score, banded_pattern, text, text_len, text_len, SCORE_ONLY, aligner->params->force_scalar);
 
             // align_input->seqs_with_15 = true; // TODO: Remove if unused
 
             int64_t new_score = banded_matrix_score.cigar->score;
 
-            banded_matrix_free(&banded_matrix_score, mm_allocator);
-
             timer_stop(aligner->timer_banded);
 
-            while((new_score > MAX(text_len, pattern_len) / 4 && score * 3/2 < new_score) || new_score < 0)
+            aligner->stats.bound_stage = QUICKED_STAGE_BANDED;
+            aligner->stats.cells += banded_matrix_score.cells;
+
+            while((new_score > aligned_len / 4 && score * 3/2 < new_score) || new_score < 0)
             {
                 score *= 2;
                 timer_start(aligner->timer_banded);
 
-                banded_matrix_allocate(&banded_matrix_score, pattern_len, text_len, score, SCORE_ONLY, mm_allocator);
+                banded_matrix_allocate_workspace(&banded_matrix_score, pattern_len, text_len, score, SCORE_ONLY, ends_free,
+                                                 &workspace->forward, mm_allocator);
+                banded_matrix_score.early_exit_score = MAX(aligned_len / 4, score * 3/2);
+                banded_matrix_score.num_threads = aligner->params->num_threads;
 
-                banded_compute(&banded_matrix_score, &banded_pattern, text, text_len, text_len, SCORE_ONLY, aligner->params->force_scalar);
+                banded_compute(&banded_matrix_score, banded_pattern, text, text_len, text_len, SCORE_ONLY, aligner->params->force_scalar);
 
                 // align_input->seqs_with_30 = true; // TODO: Remove if unused
 
                 new_score = banded_matrix_score.cigar->score;
 
-                banded_matrix_free(&banded_matrix_score, mm_allocator);
-
                 timer_stop(aligner->timer_banded);
+
+                aligner->stats.band_doublings++;
+                aligner->stats.cells += banded_matrix_score.cells;
             }
 
             score = new_score;
-            banded_pattern_free(&banded_pattern, mm_allocator);
         }
     }
 
     timer_start(aligner->timer_align);
 
+    if (!reversed) reverse_sequences(text, text_r, text_len, pattern, pattern_r_buffer, pattern_len);
+
+    // Ends-free: the alignment is global within the span of the text it covers
+    int text_begin = 0, text_end = text_len;
+    if (ends_free)
+    {
+        score = locate_ends_free(aligner, compiled_pattern, pattern, pattern_r, pattern_len,
+                                 text, text_r, text_len, score, &text_begin, &text_end);
+        aligner->text_begin = text_begin;
+        aligner->text_end = text_end;
+        if (aligner->params->only_score)
+        {
+            timer_stop(aligner->timer_align);
+            timer_stop(aligner->timer);
+            cigar_t cigar_score = {.score = score};
+            extract_results(aligner, &cigar_score);
+            return QUICKED_WIP;
+        }
+    }
+
+    hirschberg_stream_t stream_local;
+    hirschberg_stream_t *const stream = hirschberg_stream_init(aligner, &stream_local);
     cigar_t cigar_out;
-    cigar_out.operations = (char *)  mm_allocator_malloc(aligner->mm_allocator, (pattern_len + text_len) * sizeof(char));
-    cigar_out.begin_offset = pattern_len + text_len;
-    cigar_out.end_offset = pattern_len + text_len;
+    hirschberg_reserve_cigar(aligner, &cigar_out, pattern_len + text_end - text_begin, stream);
 
-    bpm_compute_matrix_hirschberg(text, text_r, text_len, pattern, pattern_r, pattern_len,
-                                  score, &cigar_out, aligner->params->force_scalar, mm_allocator);
+    run_hirschberg_traceback(aligner, compiled_pattern, text + text_begin, text_r + (text_len - text_end),
+                             text_end - text_begin, pattern, pattern_r, pattern_len, score, &cigar_out, stream);
 
     timer_stop(aligner->timer_align);
     timer_stop(aligner->timer);
 
+    hirschberg_finish_cigar(aligner, &cigar_out, stream);
+
     // benchmark_print_output(align_input, false, &cigar_out);
     // align_input->diff_scores = (float)(score - cigar_out.score) / (float)(MAX(align_input->text_length, align_input->pattern_length));
 
     extract_results(aligner, &cigar_out);
 
-    mm_allocator_free(mm_allocator, cigar_out.operations);
-    mm_allocator_free(mm_allocator,text_r);
-    mm_allocator_free(mm_allocator,pattern_r);
+    return QUICKED_WIP;
+}
+
+// X-drop extension: finds how far the alignment extends (cigar->end_v, cigar->end_h) and its distance
+static void run_xdrop(
+    quicked_aligner_t *aligner,
+    const quicked_pattern_t *compiled_pattern,
+    const char* pattern, const int pattern_len,
+    const char* text, const int text_len,
+    cigar_t *const cigar)
+{
+    mm_allocator_t *const mm_allocator = aligner->mm_allocator;
+    quicked_workspace_t *const workspace = aligner->workspace;
+
+    const banded_pattern_t *banded_pattern = (compiled_pattern != NULL) ? &compiled_pattern->banded : NULL;
+    banded_pattern_t banded_pattern_local;
+    if (banded_pattern == NULL)
+    {
+        banded_pattern_compile_workspace(&banded_pattern_local, pattern, pattern_len, aligner->simd, &workspace->forward, mm_allocator);
+        banded_pattern = &banded_pattern_local;
+    }
+
+    timer_start(aligner->timer);
+    bpm_compute_xdrop(banded_pattern, text, text_len, aligner->params->xdrop, cigar,
+                      &workspace->forward, mm_allocator, &aligner->stats.cells);
+    timer_stop(aligner->timer);
+}
+
+// One of the sequences is empty (e.g. contained in the trimmed prefix and suffix): the other one is all gaps
+static quicked_status_t run_gaps(
+    quicked_aligner_t *aligner,
+    const int pattern_len,
+    const int text_len)
+{
+    cigar_t cigar_out = {.score = pattern_len + text_len};
+    if (!aligner->params->only_score)
+    {
+        cigar_out.operations = (char *)workspace_buffer_reserve(&aligner->workspace->operations, pattern_len + text_len + 1,
+                                                                false, aligner->mm_allocator);
+        memset(cigar_out.operations, 'D', pattern_len);
+        memset(cigar_out.operations + pattern_len, 'I', text_len);
+        cigar_out.end_offset = pattern_len + text_len;
+        hirschberg_finish_cigar(aligner, &cigar_out, NULL);
+    }
+    extract_results(aligner, &cigar_out);
+
+    return QUICKED_WIP;
+}
+
+/*
+ * Equal lengths: the Hamming alignment, if no alignment with indels is cheaper.
+ * With only_score in decision mode, a Hamming distance within max_score is
+ * already the answer. Returns false (nothing done) with too many mismatches,
+ * which the QuickEd stages bound faster, or if indels are cheaper.
+ */
+static bool run_hamming(
+    quicked_aligner_t *aligner,
+    const char* pattern,
+    const char* text,
+    const int length)
+{
+    const int max_score = aligner->params->max_score;
+    const int64_t mismatches = (int64_t) quicked_hamming_distance((const uint8_t *)pattern, (const uint8_t *)text,
+                                                                  length, aligner->simd);
+    if (mismatches > QUICKED_HAMMING_MAX_DISTANCE)
+    {
+        return false;
+    }
+    const bool bound_only = aligner->params->only_score && max_score >= 0 && mismatches <= max_score;
+    if (!bound_only && quicked_hamming_indels_cheaper((const uint8_t *)pattern, (const uint8_t *)text, length, mismatches))
+    {
+        return false;
+    }
+
+    cigar_t cigar_out = {.score = (int) mismatches};
+    if (!aligner->params->only_score)
+    {
+        cigar_out.operations = (char *)workspace_buffer_reserve(&aligner->workspace->operations, length + 1,
+                                                                false, aligner->mm_allocator);
+        quicked_hamming_operations((const uint8_t *)pattern, (const uint8_t *)text, length, cigar_out.operations);
+        cigar_out.end_offset = length;
+        hirschberg_finish_cigar(aligner, &cigar_out, NULL);
+    }
+    extract_results(aligner, &cigar_out);
+
+    return true;
+}
+
+// Anchored alignment: the segments between the anchors are aligned independently and stitched together
+static quicked_status_t run_anchored(
+    quicked_aligner_t *aligner,
+    const char* pattern, const int pattern_len,
+    const char* text, const int text_len,
+    const quicked_anchor_t *anchors, const int num_anchors)
+{
+    cigar_t cigar_out = {0};
+    if (!aligner->params->only_score)
+    {
+        cigar_out.operations = (char *)workspace_buffer_reserve(&aligner->workspace->operations, pattern_len + text_len,
+                                                                false, aligner->mm_allocator);
+    }
+
+    timer_start(aligner->timer);
+    quicked_status_t status = quicked_anchor_align(aligner->params, aligner->mm_allocator, pattern, pattern_len, text, text_len,
+                                                   anchors, num_anchors, &cigar_out, &aligner->stats);
+    timer_stop(aligner->timer);
+    aligner->stats.anchors = num_anchors;
+    if (quicked_check_error(status))
+    {
+        return status;
+    }
+
+    if (!aligner->params->only_score)
+    {
+        hirschberg_finish_cigar(aligner, &cigar_out, NULL);
+    }
+    extract_results(aligner, &cigar_out);
 
     return QUICKED_WIP;
 }
@@ -310,14 +950,24 @@ quicked_params_t quicked_default_params(void)
     return (quicked_params_t){
         .algo = QUICKED,
         .only_score = false,
+        .ends_free = false,
+        .cigar_format = QUICKED_CIGAR_STRING,
+        .cigar_callback = NULL,
+        .cigar_callback_data = NULL,
+        .max_score = -1,
+        .xdrop = -1,
+        .anchor_length = 0,
         .bandwidth = 15,
         .window_size = 9,
         .hew_threshold = {40, 40},
         .hew_percentage = {15, 15},
         .overlap_size = 1,
         .force_scalar = false,
+        .num_threads = 1,
+        .memory_budget = 0,
         .external_timer = false,
         .external_allocator = NULL,
+        .allocator_pool = NULL,
     };
 }
 
@@ -327,12 +977,25 @@ quicked_status_t quicked_new(
 {
     aligner->params = params;
     aligner->score = -1;
+    aligner->text_begin = 0;
+    aligner->text_end = 0;
+    aligner->pattern_end = 0;
+    aligner->trimmed_prefix = 0;
+    aligner->trimmed_suffix = 0;
     aligner->cigar = NULL;
+    aligner->cigar_packed = NULL;
+    aligner->cigar_packed_length = 0;
     if(params->external_allocator == NULL){
-        aligner->mm_allocator = mm_allocator_new(BUFFER_SIZE_128M);
+        aligner->mm_allocator = (params->allocator_pool != NULL) ?
+                                mm_allocator_new_pooled(params->allocator_pool) :
+                                mm_allocator_new(quicked_workspace_segment_size(params->memory_budget, BUFFER_SIZE_128M));
     }else {
         aligner->mm_allocator = params->external_allocator;
     }
+    aligner->workspace = quicked_workspace_new(aligner->mm_allocator);
+    aligner->workspace_pool = NULL; // Created on first parallel use
+    aligner->simd = (params->force_scalar) ? QUICKED_SIMD_SCALAR : quicked_cpu_simd();
+    quicked_stats_aggregate_reset(&aligner->stats_total);
 
     if(!params->external_timer){
         aligner->timer = mm_allocator_malloc(aligner->mm_allocator, sizeof(profiler_timer_t));
@@ -355,12 +1018,6 @@ quicked_status_t quicked_new(
 quicked_status_t quicked_free(
     quicked_aligner_t *aligner)
 {
-    if (aligner->cigar != NULL)
-    {
-        mm_allocator_free(aligner->mm_allocator, aligner->cigar);
-        aligner->cigar = NULL;
-    }
-
     if(!aligner->params->external_timer){
         mm_allocator_free(aligner->mm_allocator, aligner->timer);
         mm_allocator_free(aligner->mm_allocator, aligner->timer_windowed_s);
@@ -369,6 +1026,18 @@ quicked_status_t quicked_free(
         mm_allocator_free(aligner->mm_allocator, aligner->timer_align);
     }
 
+    // The CIGAR string lives in the workspace
+    quicked_workspace_delete(aligner->workspace);
+    aligner->workspace = NULL;
+    if (aligner->workspace_pool != NULL)
+    {
+        quicked_workspace_pool_delete(aligner->workspace_pool);
+        aligner->workspace_pool = NULL;
+    }
+    aligner->cigar = NULL;
+    aligner->cigar_packed = NULL;
+    aligner->cigar_packed_length = 0;
+
     if ((aligner->mm_allocator != NULL) && (aligner->params->external_allocator == NULL))
     {
         mm_allocator_delete(aligner->mm_allocator);
@@ -395,6 +1064,8 @@ const char* quicked_status_msg(
             return "ERROR: Unknown algorithm selection\n";
         case QUICKED_EMPTY_SEQUENCE:
             return "ERROR: Tried to align an empty sequence\n";
+        case QUICKED_ABOVE_MAX_SCORE:
+            return "QuickEd finished: the edit distance is above max_score.\n";
         case QUICKED_OK:
         case QUICKED_WIP:
         default:
@@ -403,10 +1074,11 @@ const char* quicked_status_msg(
 
 }
 
-quicked_status_t quicked_align(
+static quicked_status_t quicked_align_dispatch(
     quicked_aligner_t *aligner,
-    const char* pattern, const int pattern_len,
-    const char* text, const int text_len)
+    const quicked_pattern_t *compiled_pattern,
+    const char* pattern, int pattern_len,
+    const char* text, int text_len)
 {
 
     if (pattern_len == 0 || text_len == 0)
@@ -414,25 +1086,216 @@ quicked_status_t quicked_align(
         return QUICKED_EMPTY_SEQUENCE;
     }
 
+    aligner->stats = (quicked_stats_t){
+        .bound_stage = QUICKED_STAGE_NONE,
+        .final_cutoff = -1,
+    };
+
+    aligner->text_begin = 0;
+    aligner->text_end = text_len;
+    aligner->pattern_end = pattern_len;
+    aligner->trimmed_prefix = 0;
+    aligner->trimmed_suffix = 0;
+    aligner->workspace->pending_prefix = 0;
+
     quicked_status_t status = QUICKED_ERROR;
 
-    switch (aligner->params->algo)
+    // X-drop extension: only the extended prefixes are aligned (globally)
+    bool extended = false;
+    if (aligner->params->xdrop >= 0)
+    {
+        if (aligner->params->ends_free)
+        {
+            return QUICKED_UNIMPLEMENTED;
+        }
+        cigar_t cigar_xdrop = {0};
+        run_xdrop(aligner, compiled_pattern, pattern, pattern_len, text, text_len, &cigar_xdrop);
+        aligner->pattern_end = cigar_xdrop.end_v;
+        aligner->text_end = cigar_xdrop.end_h;
+        if (aligner->params->only_score || cigar_xdrop.end_v == 0)
+        { // Nothing to align (the extension is empty), or only its distance is needed
+            extract_results(aligner, &cigar_xdrop);
+            extended = true;
+        }
+        else
+        {
+            compiled_pattern = (cigar_xdrop.end_v == pattern_len) ? compiled_pattern : NULL;
+            pattern_len = cigar_xdrop.end_v;
+            text_len = cigar_xdrop.end_h;
+        }
+    }
+
+    // Common prefix and suffix: matching them is optimal for the edit distance, so only the core in between is aligned
+    if (!extended && !aligner->params->ends_free)
+    {
+        const int prefix = (int) quicked_common_prefix((const uint8_t *)pattern, (const uint8_t *)text,
+                                                       MIN(pattern_len, text_len), aligner->simd);
+        const int suffix = (int) quicked_common_suffix((const uint8_t *)pattern + pattern_len, (const uint8_t *)text + text_len,
+                                                       MIN(pattern_len, text_len) - prefix, aligner->simd);
+        if (prefix + suffix > 0)
+        {
+            compiled_pattern = NULL;
+            pattern += prefix;
+            text += prefix;
+            pattern_len -= prefix + suffix;
+            text_len -= prefix + suffix;
+            aligner->trimmed_prefix = prefix;
+            aligner->trimmed_suffix = suffix;
+        }
+        if (aligner->params->cigar_callback != NULL && !aligner->params->only_score)
+        {
+            aligner->workspace->pending_prefix = prefix;
+        }
+    }
+
+    // Decision mode: the length difference alone is a lower bound of the distance
+    // (ends-free: only the pattern bases that cannot fit in the text)
+    const int max_score = aligner->params->max_score;
+    const int length_bound = aligner->params->ends_free ? MAX(pattern_len - text_len, 0) : ABS(pattern_len - text_len);
+
+    // Anchors split global alignments only. Their result may be an upper bound, so decision mode does without them
+    const bool anchored = aligner->params->anchor_length > 0 && !aligner->params->ends_free && max_score < 0;
+    quicked_anchor_t *anchors = NULL;
+    int num_anchors = 0;
+
+    if (extended)
+    {
+        status = QUICKED_WIP;
+    }
+    else if (max_score >= 0 && length_bound > max_score)
+    {
+        status = QUICKED_ABOVE_MAX_SCORE;
+    }
+    else if (pattern_len == 0 || text_len == 0)
+    {
+        status = run_gaps(aligner, pattern_len, text_len);
+    }
+    else if (pattern_len == text_len && !aligner->params->ends_free && run_hamming(aligner, pattern, text, pattern_len))
+    {
+        status = QUICKED_WIP;
+    }
+    else if (anchored &&
+             (num_anchors = quicked_anchor_find(pattern, pattern_len, text, text_len, aligner->params->anchor_length,
+                                                aligner->mm_allocator, &anchors)) > 0)
+    {
+        status = run_anchored(aligner, pattern, pattern_len, text, text_len, anchors, num_anchors);
+    }
+    else
     {
-    case QUICKED:
-        status = run_quicked(aligner, pattern, pattern_len, text, text_len);
-        break;
-    case BANDED:
-        status = run_banded(aligner, pattern, pattern_len, text, text_len);
-        break;
-    case WINDOWED:
-        status = run_windowed(aligner, pattern, pattern_len, text, text_len);
-        break;
-    case HIRSCHBERG:
-        status = run_hirschberg(aligner, pattern, pattern_len, text, text_len);
-        break;
-    default:
-        return QUICKED_UNKNOWN_ALGO;
+        switch (aligner->params->algo)
+        {
+        case QUICKED:
+            status = run_quicked(aligner, compiled_pattern, pattern, pattern_len, text, text_len);
+            break;
+        case BANDED:
+            if (banded_over_budget(aligner, pattern_len, text_len))
+            {
+                status = run_hirschberg(aligner, compiled_pattern, pattern, pattern_len, text, text_len);
+            }
+            else
+            {
+                status = run_banded(aligner, compiled_pattern, pattern, pattern_len, text, text_len);
+            }
+            break;
+        case WINDOWED:
+            status = run_windowed(aligner, compiled_pattern, pattern, pattern_len, text, text_len);
+            break;
+        case HIRSCHBERG:
+            status = run_hirschberg(aligner, compiled_pattern, pattern, pattern_len, text, text_len);
+            break;
+        default:
+            return QUICKED_UNKNOWN_ALGO;
+        }
     }
+    if (anchors != NULL) mm_allocator_free(aligner->mm_allocator, anchors);
+
+    if (max_score >= 0 && !quicked_check_error(status) && aligner->score > max_score)
+    {
+        status = QUICKED_ABOVE_MAX_SCORE;
+    }
+    if (aligner->params->cigar_callback != NULL && !aligner->params->only_score &&
+        !quicked_check_error(status) && status != QUICKED_ABOVE_MAX_SCORE)
+    {
+        // Identical sequences leave no core operations to stream the prefix ahead of
+        if (aligner->workspace->pending_prefix > 0) emit_matches(aligner, aligner->workspace->pending_prefix);
+        if (aligner->trimmed_suffix > 0) emit_matches(aligner, aligner->trimmed_suffix);
+    }
+    aligner->workspace->pending_prefix = 0;
+    if (status == QUICKED_ABOVE_MAX_SCORE)
+    {
+        aligner->score = -1;
+        aligner->cigar = NULL;
+        aligner->cigar_packed = NULL;
+        aligner->cigar_packed_length = 0;
+    }
+
+    quicked_stats_aggregate_add(&aligner->stats_total, &aligner->stats);
 
     return status;
-}
\ No newline at end of file
+}
+
+quicked_status_t quicked_align(
+    quicked_aligner_t *aligner,
+    const char* pattern, const int pattern_len,
+    const char* text, const int text_len)
+{
+    if (pattern_len <= 0 || text_len <= 0)
+    {
+        return QUICKED_EMPTY_SEQUENCE;
+    }
+
+    // The kernels work on encoded sequences, so they are encoded once per call
+    quicked_workspace_t *const workspace = aligner->workspace;
+    uint8_t *const pattern_enc = (uint8_t *)workspace_buffer_reserve(&workspace->pattern_enc, pattern_len, false, aligner->mm_allocator);
+    uint8_t *const text_enc = (uint8_t *)workspace_buffer_reserve(&workspace->text_enc, text_len, false, aligner->mm_allocator);
+    quicked_encode_ascii(pattern, pattern_len, pattern_enc, aligner->simd);
+    quicked_encode_ascii(text, text_len, text_enc, aligner->simd);
+
+    return quicked_align_dispatch(aligner, NULL, (const char *)pattern_enc, pattern_len, (const char *)text_enc, text_len);
+}
+
+quicked_status_t quicked_align_encoded(
+    quicked_aligner_t *aligner,
+    const uint8_t* pattern, const int pattern_len,
+    const uint8_t* text, const int text_len)
+{
+    return quicked_align_dispatch(aligner, NULL, (const char *)pattern, pattern_len, (const char *)text, text_len);
+}
+
+quicked_status_t quicked_align_packed(
+    quicked_aligner_t *aligner,
+    const uint64_t* pattern, const uint64_t* pattern_n_mask, const int pattern_len,
+    const uint64_t* text, const uint64_t* text_n_mask, const int text_len)
+{
+    if (pattern_len <= 0 || text_len <= 0)
+    {
+        return QUICKED_EMPTY_SEQUENCE;
+    }
+
+    quicked_workspace_t *const workspace = aligner->workspace;
+    uint8_t *const pattern_enc = (uint8_t *)workspace_buffer_reserve(&workspace->pattern_enc, pattern_len, false, aligner->mm_allocator);
+    uint8_t *const text_enc = (uint8_t *)workspace_buffer_reserve(&workspace->text_enc, text_len, false, aligner->mm_allocator);
+    quicked_encode_packed(pattern, pattern_n_mask, pattern_len, pattern_enc);
+    quicked_encode_packed(text, text_n_mask, text_len, text_enc);
+
+    return quicked_align_dispatch(aligner, NULL, (const char *)pattern_enc, pattern_len, (const char *)text_enc, text_len);
+}
+
+quicked_status_t quicked_align_compiled(
+    quicked_aligner_t *aligner,
+    const quicked_pattern_t *compiled_pattern,
+    const char* text, const int text_len)
+{
+    if (compiled_pattern == NULL || text_len <= 0)
+    {
+        return QUICKED_EMPTY_SEQUENCE;
+    }
+
+    // The compiled pattern is already encoded
+    uint8_t *const text_enc = (uint8_t *)workspace_buffer_reserve(&aligner->workspace->text_enc, text_len, false, aligner->mm_allocator);
+    quicked_encode_ascii(text, text_len, text_enc, aligner->simd);
+
+    return quicked_align_dispatch(aligner, compiled_pattern,
+                                  compiled_pattern->pattern, compiled_pattern->pattern_length,
+                                  (const char *)text_enc, text_len);
+}
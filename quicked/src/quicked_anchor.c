@@ -0,0 +1,433 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "quicked_anchor.h"
+#include "quicked_workspace.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Idle segments the anchor allocator pool keeps for each thread
+#define QUICKED_ANCHOR_IDLE_SEGMENTS_PER_THREAD 2
+
+#define QUICKED_ANCHOR_EMPTY    -1 // Unused entry of the k-mer index
+#define QUICKED_ANCHOR_REPEATED -2 // K-mer seen more than once
+
+/*
+ * K-mer index of the text (open addressing). Each entry records where the
+ * k-mer occurs in the text and in the pattern, or that it is repeated.
+ */
+typedef struct {
+    uint64_t kmer;
+    int32_t text_pos;
+    int32_t pattern_pos;
+} quicked_anchor_entry_t;
+
+typedef struct {
+    quicked_anchor_entry_t *entries;
+    uint64_t mask;
+    int bits;
+} quicked_anchor_index_t;
+
+static inline quicked_anchor_entry_t* quicked_anchor_index_lookup(
+    const quicked_anchor_index_t *const index,
+    const uint64_t kmer)
+{
+    uint64_t slot = (kmer * 0x9E3779B97F4A7C15ull) >> (64 - index->bits);
+    while (index->entries[slot].text_pos != QUICKED_ANCHOR_EMPTY && index->entries[slot].kmer != kmer)
+    {
+        slot = (slot + 1) & index->mask;
+    }
+    return &index->entries[slot];
+}
+
+// Rolls in bases up to the next k-mer without N: returns its position, or -1 at the end
+static inline int quicked_anchor_next_kmer(
+    const char* sequence,
+    const int length,
+    const int k,
+    const uint64_t kmer_mask,
+    int *const pos,
+    int *const valid,
+    uint64_t *const kmer)
+{
+    while (*pos < length)
+    {
+        const uint8_t enc_char = (uint8_t)sequence[(*pos)++];
+        if (enc_char > 3)
+        {
+            *valid = 0;
+            continue;
+        }
+        *kmer = ((*kmer << 2) | enc_char) & kmer_mask;
+        if (++(*valid) >= k) return *pos - k;
+    }
+    return -1;
+}
+
+int quicked_anchor_find(
+    const char* pattern,
+    const int pattern_length,
+    const char* text,
+    const int text_length,
+    const int anchor_length,
+    mm_allocator_t *const mm_allocator,
+    quicked_anchor_t **anchors)
+{
+    *anchors = NULL;
+    const int k = MIN(anchor_length, QUICKED_ANCHOR_MAX_KMER);
+    if (k <= 0 || pattern_length < 2 * QUICKED_ANCHOR_MIN_SPACING || text_length < 2 * QUICKED_ANCHOR_MIN_SPACING)
+    {
+        return 0;
+    }
+    const uint64_t kmer_mask = (k == QUICKED_ANCHOR_MAX_KMER) ? UINT64_MAX : (1ull << (2 * k)) - 1;
+
+    // Index the text k-mers (at most half of the entries in use)
+    quicked_anchor_index_t index = {.bits = 1};
+    while ((1ull << index.bits) < 2ull * text_length) index.bits++;
+    index.mask = (1ull << index.bits) - 1;
+    index.entries = (quicked_anchor_entry_t*) mm_allocator_malloc(mm_allocator, (index.mask + 1) * sizeof(quicked_anchor_entry_t));
+    memset(index.entries, 0xFF, (index.mask + 1) * sizeof(quicked_anchor_entry_t)); // QUICKED_ANCHOR_EMPTY
+
+    int pos = 0, valid = 0, kmer_pos;
+    uint64_t kmer = 0;
+    while ((kmer_pos = quicked_anchor_next_kmer(text, text_length, k, kmer_mask, &pos, &valid, &kmer)) >= 0)
+    {
+        quicked_anchor_entry_t *const entry = quicked_anchor_index_lookup(&index, kmer);
+        if (entry->text_pos == QUICKED_ANCHOR_EMPTY)
+        {
+            entry->kmer = kmer;
+            entry->text_pos = kmer_pos;
+        }
+        else
+        {
+            entry->text_pos = QUICKED_ANCHOR_REPEATED;
+        }
+    }
+
+    // Pattern occurrences of the text k-mers. Each k-mer unique in both sequences seeds a match at most
+    int num_unique = 0;
+    pos = 0; valid = 0; kmer = 0;
+    while ((kmer_pos = quicked_anchor_next_kmer(pattern, pattern_length, k, kmer_mask, &pos, &valid, &kmer)) >= 0)
+    {
+        quicked_anchor_entry_t *const entry = quicked_anchor_index_lookup(&index, kmer);
+        if (entry->text_pos == QUICKED_ANCHOR_EMPTY) continue;
+        if (entry->pattern_pos == QUICKED_ANCHOR_EMPTY)
+        {
+            entry->pattern_pos = kmer_pos;
+            if (entry->text_pos >= 0) num_unique++;
+        }
+        else if (entry->pattern_pos >= 0)
+        {
+            entry->pattern_pos = QUICKED_ANCHOR_REPEATED;
+            if (entry->text_pos >= 0) num_unique--;
+        }
+    }
+    if (num_unique == 0)
+    {
+        mm_allocator_free(mm_allocator, index.entries);
+        return 0;
+    }
+
+    // Matches of the unique k-mers, extended to the right while the bases match (in pattern order)
+    quicked_anchor_t *const matches = (quicked_anchor_t*) mm_allocator_malloc(mm_allocator, num_unique * sizeof(quicked_anchor_t));
+    int num_matches = 0;
+    int skip_until = 0;
+    pos = 0; valid = 0; kmer = 0;
+    while ((kmer_pos = quicked_anchor_next_kmer(pattern, pattern_length, k, kmer_mask, &pos, &valid, &kmer)) >= 0)
+    {
+        if (kmer_pos < skip_until) continue;
+        const quicked_anchor_entry_t *const entry = quicked_anchor_index_lookup(&index, kmer);
+        if (entry->text_pos < 0 || entry->pattern_pos != kmer_pos) continue;
+
+        const int text_pos = entry->text_pos;
+        int length = k;
+        while (kmer_pos + length < pattern_length && text_pos + length < text_length &&
+               pattern[kmer_pos + length] == text[text_pos + length] && (uint8_t)pattern[kmer_pos + length] <= 3)
+        {
+            length++;
+        }
+        skip_until = kmer_pos + length - k + 1; // Later k-mers of the same match
+        if (length < anchor_length) continue;
+        matches[num_matches++] = (quicked_anchor_t){.pattern_pos = kmer_pos, .text_pos = text_pos, .length = length};
+    }
+    if (num_matches == 0)
+    {
+        mm_allocator_free(mm_allocator, matches);
+        mm_allocator_free(mm_allocator, index.entries);
+        return 0;
+    }
+
+    // Longest chain of matches with increasing text positions (patience sorting)
+    int *const tails = (int*) mm_allocator_malloc(mm_allocator, 2 * num_matches * sizeof(int));
+    int *const predecessors = tails + num_matches;
+    int chain_length = 0;
+    for (int i = 0; i < num_matches; ++i)
+    {
+        int lo = 0, hi = chain_length;
+        while (lo < hi)
+        {
+            const int mid = (lo + hi) / 2;
+            if (matches[tails[mid]].text_pos < matches[i].text_pos) lo = mid + 1;
+            else hi = mid;
+        }
+        predecessors[i] = (lo > 0) ? tails[lo - 1] : -1;
+        tails[lo] = i;
+        if (lo == chain_length) chain_length++;
+    }
+    // Walk the chain back, reusing tails to hold it in order
+    for (int i = tails[chain_length - 1], j = chain_length - 1; i >= 0; i = predecessors[i], --j)
+    {
+        tails[j] = i;
+    }
+
+    // Keep the anchors that do not overlap, are spaced enough and stay near the diagonal of the previous one
+    int num_anchors = 0;
+    int pattern_end = -QUICKED_ANCHOR_MIN_SPACING, text_end = 0;
+    for (int j = 0; j < chain_length; ++j)
+    {
+        const quicked_anchor_t match = matches[tails[j]];
+        const int pattern_gap = match.pattern_pos - pattern_end;
+        const int text_gap = match.text_pos - text_end;
+        if (pattern_gap < QUICKED_ANCHOR_MIN_SPACING || text_gap < 0) continue;
+        if (num_anchors > 0 && ABS(text_gap - pattern_gap) > MAX(text_gap, pattern_gap) / 2) continue;
+        matches[num_anchors++] = match; // In place: num_anchors <= tails[j]
+        pattern_end = match.pattern_pos + match.length;
+        text_end = match.text_pos + match.length;
+    }
+    mm_allocator_free(mm_allocator, tails);
+    mm_allocator_free(mm_allocator, index.entries);
+
+    *anchors = matches; // The chain keeps its first match at least
+    return num_anchors;
+}
+
+/*
+ * Segment between two anchors (or a sequence end), followed by the match of
+ * the next anchor. Its operations go to the range of the output buffer that
+ * starts at pattern_begin + text_begin, which no other segment can reach.
+ */
+typedef struct {
+    int pattern_begin;
+    int pattern_length;
+    int text_begin;
+    int text_length;
+    int anchor_length;          // Exact match after the segment (0 for the last one)
+    char *operations;
+    int num_operations;
+    int score;
+    quicked_stats_t stats;
+} quicked_anchor_segment_t;
+
+typedef struct {
+    const quicked_params_t *params;
+    mm_allocator_pool_t *allocator_pool;    // Shared by the threads
+    const char *pattern;
+    const char *text;
+    quicked_anchor_segment_t *segments;
+    int num_segments;
+    atomic_int next_segment;    // Next segment to be picked by a thread
+    atomic_int status;          // First error found (QUICKED_OK otherwise)
+} quicked_anchor_split_t;
+
+static void quicked_anchor_collect(
+    const char* operations,
+    int num_operations,
+    void* user_data)
+{
+    quicked_anchor_segment_t *const segment = (quicked_anchor_segment_t*) user_data;
+    memcpy(segment->operations + segment->num_operations, operations, num_operations);
+    segment->num_operations += num_operations;
+}
+
+static void quicked_anchor_align_segment(
+    quicked_anchor_split_t *const split,
+    quicked_aligner_t *const aligner,
+    quicked_anchor_segment_t *const segment)
+{
+    const bool only_score = split->params->only_score;
+    segment->num_operations = 0;
+    segment->stats = (quicked_stats_t){.bound_stage = QUICKED_STAGE_NONE, .final_cutoff = -1};
+
+    // A segment empty on one side is all gaps
+    if (segment->pattern_length == 0 || segment->text_length == 0)
+    {
+        segment->score = segment->pattern_length + segment->text_length;
+        if (!only_score)
+        {
+            memset(segment->operations, 'D', segment->pattern_length);
+            memset(segment->operations + segment->pattern_length, 'I', segment->text_length);
+            segment->num_operations = segment->score;
+        }
+        return;
+    }
+
+    aligner->params->cigar_callback_data = segment;
+    quicked_status_t status = quicked_align_encoded(aligner,
+        (const uint8_t *)split->pattern + segment->pattern_begin, segment->pattern_length,
+        (const uint8_t *)split->text + segment->text_begin, segment->text_length);
+    if (quicked_check_error(status))
+    {
+        int expected = QUICKED_OK;
+        atomic_compare_exchange_strong(&split->status, &expected, status);
+        return;
+    }
+    segment->score = aligner->score;
+    segment->stats = aligner->stats;
+}
+
+static void* quicked_anchor_worker(
+    void *arg)
+{
+    quicked_anchor_split_t *const split = (quicked_anchor_split_t*) arg;
+
+    // Plain global alignment of each segment, streamed into its range of the output
+    quicked_params_t params = *split->params;
+    params.anchor_length = 0;
+    params.num_threads = 1;
+    params.max_score = -1;
+    params.xdrop = -1;
+    params.ends_free = false;
+    params.cigar_callback = (params.only_score) ? NULL : quicked_anchor_collect;
+    params.external_timer = false;
+    params.external_allocator = NULL;
+    params.allocator_pool = split->allocator_pool;
+
+    quicked_aligner_t aligner;
+    const quicked_status_t status = quicked_new(&aligner, &params);
+    if (quicked_check_error(status))
+    {
+        int expected = QUICKED_OK;
+        atomic_compare_exchange_strong(&split->status, &expected, status);
+        return NULL;
+    }
+
+    int idx;
+    while ((idx = atomic_fetch_add(&split->next_segment, 1)) < split->num_segments)
+    {
+        quicked_anchor_align_segment(split, &aligner, &split->segments[idx]);
+    }
+
+    quicked_free(&aligner);
+    return NULL;
+}
+
+quicked_status_t quicked_anchor_align(
+    const quicked_params_t *params,
+    mm_allocator_t *const mm_allocator,
+    const char* pattern,
+    const int pattern_length,
+    const char* text,
+    const int text_length,
+    const quicked_anchor_t *anchors,
+    const int num_anchors,
+    cigar_t *const cigar,
+    quicked_stats_t *const stats)
+{
+    const int num_segments = num_anchors + 1;
+    quicked_anchor_segment_t *const segments = (quicked_anchor_segment_t*) mm_allocator_malloc(mm_allocator, num_segments * sizeof(quicked_anchor_segment_t));
+    int pattern_pos = 0, text_pos = 0;
+    for (int i = 0; i < num_segments; ++i)
+    {
+        const int pattern_next = (i < num_anchors) ? anchors[i].pattern_pos : pattern_length;
+        const int text_next = (i < num_anchors) ? anchors[i].text_pos : text_length;
+        segments[i] = (quicked_anchor_segment_t){
+            .pattern_begin = pattern_pos,
+            .pattern_length = pattern_next - pattern_pos,
+            .text_begin = text_pos,
+            .text_length = text_next - text_pos,
+            .anchor_length = (i < num_anchors) ? anchors[i].length : 0,
+            .operations = (cigar->operations != NULL) ? cigar->operations + pattern_pos + text_pos : NULL,
+        };
+        pattern_pos = pattern_next + segments[i].anchor_length;
+        text_pos = text_next + segments[i].anchor_length;
+    }
+
+    int num_threads = MAX((int) params->num_threads, 1);
+    if (num_threads > num_segments) num_threads = num_segments;
+
+    // Segments freed by a thread are reused by the others
+    mm_allocator_pool_t *const allocator_pool = (params->allocator_pool != NULL) ? params->allocator_pool :
+        mm_allocator_pool_new(quicked_workspace_segment_size(params->memory_budget, BUFFER_SIZE_16M),
+                              QUICKED_ANCHOR_IDLE_SEGMENTS_PER_THREAD * num_threads);
+
+    quicked_anchor_split_t split = {
+        .params = params,
+        .allocator_pool = allocator_pool,
+        .pattern = pattern,
+        .text = text,
+        .segments = segments,
+        .num_segments = num_segments,
+    };
+    atomic_init(&split.next_segment, 0);
+    atomic_init(&split.status, QUICKED_OK);
+
+    // The calling thread aligns segments too
+    pthread_t *const threads = (pthread_t*) mm_allocator_malloc(mm_allocator, (num_threads - 1) * sizeof(pthread_t) + 1);
+    int num_spawned = 0;
+    for (; num_spawned < num_threads - 1; num_spawned++)
+    {
+        if (pthread_create(&threads[num_spawned], NULL, quicked_anchor_worker, &split) != 0) break;
+    }
+    quicked_anchor_worker(&split);
+    for (int i = 0; i < num_spawned; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    mm_allocator_free(mm_allocator, threads);
+    if (allocator_pool != params->allocator_pool) mm_allocator_pool_delete(allocator_pool);
+
+    // Stitch the segments and the anchor matches together (each range starts at or after the output so far)
+    const quicked_status_t status = (quicked_status_t) atomic_load(&split.status);
+    int num_operations = 0, score = 0;
+    for (int i = 0; i < num_segments && !quicked_check_error(status); ++i)
+    {
+        const quicked_anchor_segment_t *const segment = &segments[i];
+        if (cigar->operations != NULL)
+        {
+            memmove(cigar->operations + num_operations, segment->operations, segment->num_operations);
+            num_operations += segment->num_operations;
+            memset(cigar->operations + num_operations, 'M', segment->anchor_length);
+            num_operations += segment->anchor_length;
+        }
+        score += segment->score;
+
+        stats->cells += segment->stats.cells;
+        stats->band_doublings += segment->stats.band_doublings;
+        for (int w = 0; w < QUICKED_WINDOW_STAGES; ++w)
+        {
+            stats->high_error_windows[w] += segment->stats.high_error_windows[w];
+        }
+        stats->final_cutoff = MAX(stats->final_cutoff, segment->stats.final_cutoff);
+        stats->hirschberg_depth = MAX(stats->hirschberg_depth, segment->stats.hirschberg_depth);
+    }
+    mm_allocator_free(mm_allocator, segments);
+
+    cigar->begin_offset = 0;
+    cigar->end_offset = num_operations;
+    cigar->score = score;
+    return status;
+}
@@ -0,0 +1,243 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "quicked.h"
+#include "bpm_batch.h"
+#include "quicked_workspace.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Idle segments the batch allocator pool keeps for each worker
+#define QUICKED_BATCH_IDLE_SEGMENTS_PER_THREAD 2
+
+typedef struct quicked_batch_t {
+    const quicked_params_t *params;
+    mm_allocator_pool_t *allocator_pool;    // Shared by the workers
+    const char **patterns;
+    const int *pattern_lens;
+    const char **texts;
+    const int *text_lens;
+    int num_alignments;
+    int *scores;
+    char **cigars;
+    atomic_int next_alignment;  // Next alignment to be picked by a worker
+    atomic_int status;          // First error found (QUICKED_OK otherwise)
+    quicked_stats_aggregate_t *stats;
+    pthread_mutex_t stats_mutex;
+} quicked_batch_t;
+
+static char* quicked_batch_copy_cigar(
+    const char *cigar)
+{
+    if (cigar == NULL) return NULL;
+    const size_t cigar_len = strlen(cigar) + 1;
+    char *const copy = (char*) malloc(cigar_len);
+    if (copy != NULL) memcpy(copy, cigar, cigar_len);
+    return copy;
+}
+
+static void quicked_batch_align_one(
+    quicked_batch_t *const batch,
+    quicked_aligner_t *const aligner,
+    const int idx)
+{
+    quicked_status_t status = quicked_align(aligner,
+                                            batch->patterns[idx], batch->pattern_lens[idx],
+                                            batch->texts[idx], batch->text_lens[idx]);
+    if (quicked_check_error(status))
+    {
+        int expected = QUICKED_OK;
+        atomic_compare_exchange_strong(&batch->status, &expected, status);
+        batch->scores[idx] = -1;
+        if (batch->cigars != NULL) batch->cigars[idx] = NULL;
+        return;
+    }
+
+    batch->scores[idx] = aligner->score;
+    if (batch->cigars != NULL)
+    {
+        batch->cigars[idx] = (aligner->params->only_score) ? NULL : quicked_batch_copy_cigar(aligner->cigar);
+    }
+}
+
+// Score-only batches of short pairs: one pair per SIMD lane, the rest go through quicked_align
+static void quicked_batch_align_lanes(
+    quicked_batch_t *const batch,
+    quicked_aligner_t *const aligner,
+    const int lanes)
+{
+    const int max_score = aligner->params->max_score;
+    const char *patterns[BPM_BATCH_MAX_LANES], *texts[BPM_BATCH_MAX_LANES];
+    int pattern_lens[BPM_BATCH_MAX_LANES], text_lens[BPM_BATCH_MAX_LANES];
+    int lane_idx[BPM_BATCH_MAX_LANES];
+    int64_t scores[BPM_BATCH_MAX_LANES];
+
+    int first;
+    while ((first = atomic_fetch_add(&batch->next_alignment, lanes)) < batch->num_alignments)
+    {
+        const int last = MIN(first + lanes, batch->num_alignments);
+        uint64_t num_pairs = 0;
+        for (int idx = first; idx < last; idx++)
+        {
+            if (!bpm_batch_fits(batch->pattern_lens[idx], batch->text_lens[idx]))
+            {
+                quicked_batch_align_one(batch, aligner, idx);
+                continue;
+            }
+            patterns[num_pairs] = batch->patterns[idx];
+            pattern_lens[num_pairs] = batch->pattern_lens[idx];
+            texts[num_pairs] = batch->texts[idx];
+            text_lens[num_pairs] = batch->text_lens[idx];
+            lane_idx[num_pairs] = idx;
+            num_pairs++;
+        }
+        if (num_pairs == 0) continue;
+
+        bpm_batch_compute_score(patterns, pattern_lens, texts, text_lens, num_pairs, scores, aligner->simd);
+
+        for (uint64_t l = 0; l < num_pairs; l++)
+        {
+            const int idx = lane_idx[l];
+            batch->scores[idx] = (max_score >= 0 && scores[l] > max_score) ? -1 : (int) scores[l];
+            if (batch->cigars != NULL) batch->cigars[idx] = NULL;
+
+            const quicked_stats_t stats = {
+                .bound_stage = QUICKED_STAGE_NONE,
+                .final_cutoff = -1,
+                .cells = DIV_CEIL((uint64_t)pattern_lens[l], UINT64_LENGTH) * UINT64_LENGTH * text_lens[l],
+            };
+            quicked_stats_aggregate_add(&aligner->stats_total, &stats);
+        }
+    }
+}
+
+static void* quicked_batch_worker(
+    void *arg)
+{
+    quicked_batch_t *const batch = (quicked_batch_t*) arg;
+
+    // Each worker owns its aligner, so workspace and allocator are never shared (only their segments)
+    quicked_params_t params = *batch->params;
+    params.external_timer = false;
+    params.external_allocator = NULL;
+    params.allocator_pool = batch->allocator_pool;
+
+    quicked_aligner_t aligner;
+    quicked_new(&aligner, &params);
+
+    // The lane kernels only compute global distances
+    const int lanes = (params.only_score && params.algo == QUICKED && !params.ends_free && params.xdrop < 0) ? (int) bpm_batch_lanes(aligner.simd) : 0;
+    if (lanes > 0)
+    {
+        quicked_batch_align_lanes(batch, &aligner, lanes);
+    }
+    else
+    {
+        // Alignments are picked one at a time, which balances pairs of very different lengths
+        int idx;
+        while ((idx = atomic_fetch_add(&batch->next_alignment, 1)) < batch->num_alignments)
+        {
+            quicked_batch_align_one(batch, &aligner, idx);
+        }
+    }
+
+    if (batch->stats != NULL)
+    {
+        pthread_mutex_lock(&batch->stats_mutex);
+        quicked_stats_aggregate_merge(batch->stats, &aligner.stats_total);
+        pthread_mutex_unlock(&batch->stats_mutex);
+    }
+
+    quicked_free(&aligner);
+    return NULL;
+}
+
+quicked_status_t quicked_align_batch(
+    quicked_params_t *params,
+    int num_threads,
+    const char **patterns, const int *pattern_lens,
+    const char **texts, const int *text_lens,
+    const int num_alignments,
+    int *scores,
+    char **cigars,
+    quicked_stats_aggregate_t *stats)
+{
+    if (num_alignments <= 0) return QUICKED_OK;
+
+    if (num_threads <= 0)
+    {
+        const long online_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = (online_cpus > 0) ? (int) online_cpus : 1;
+    }
+    if (num_threads > num_alignments) num_threads = num_alignments;
+
+    // Segments freed by a worker done with a long pair are reused by the others
+    mm_allocator_pool_t *const allocator_pool = (params->allocator_pool != NULL) ? params->allocator_pool :
+        mm_allocator_pool_new(quicked_workspace_segment_size(params->memory_budget, BUFFER_SIZE_16M),
+                              QUICKED_BATCH_IDLE_SEGMENTS_PER_THREAD * num_threads);
+
+    quicked_batch_t batch = {
+        .params = params,
+        .allocator_pool = allocator_pool,
+        .patterns = patterns,
+        .pattern_lens = pattern_lens,
+        .texts = texts,
+        .text_lens = text_lens,
+        .num_alignments = num_alignments,
+        .scores = scores,
+        .cigars = cigars,
+        .stats = stats,
+    };
+    atomic_init(&batch.next_alignment, 0);
+    atomic_init(&batch.status, QUICKED_OK);
+    pthread_mutex_init(&batch.stats_mutex, NULL);
+
+    // The calling thread acts as worker 0
+    pthread_t *const workers = (pthread_t*) malloc((num_threads - 1) * sizeof(pthread_t) + 1);
+    if (workers == NULL)
+    {
+        pthread_mutex_destroy(&batch.stats_mutex);
+        if (allocator_pool != params->allocator_pool) mm_allocator_pool_delete(allocator_pool);
+        return QUICKED_ERROR;
+    }
+
+    int num_spawned = 0;
+    for (; num_spawned < num_threads - 1; num_spawned++)
+    {
+        if (pthread_create(&workers[num_spawned], NULL, quicked_batch_worker, &batch) != 0) break;
+    }
+    quicked_batch_worker(&batch);
+    for (int i = 0; i < num_spawned; i++)
+    {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+    pthread_mutex_destroy(&batch.stats_mutex);
+    if (allocator_pool != params->allocator_pool) mm_allocator_pool_delete(allocator_pool);
+
+    return (quicked_status_t) atomic_load(&batch.status);
+}
@@ -0,0 +1,79 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "quicked_cpu.h"
+#include <pthread.h>
+#include <unistd.h>
+
+static pthread_once_t quicked_cpu_once = PTHREAD_ONCE_INIT;
+static quicked_simd_t quicked_cpu_level = QUICKED_SIMD_SCALAR;
+static uint64_t quicked_cpu_l2_size = 0;
+static uint64_t quicked_cpu_l3_size = 0;
+
+// Not every libc reports the cache sizes (nor every virtual machine): they stay 0 then
+#if defined(_SC_LEVEL2_CACHE_SIZE) || defined(_SC_LEVEL3_CACHE_SIZE)
+static uint64_t quicked_cpu_sysconf(const int name)
+{
+    const long value = sysconf(name);
+    return (value > 0) ? (uint64_t)value : 0;
+}
+#endif
+
+static void quicked_cpu_detect(void)
+{
+#ifdef QUICKED_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+    {
+        quicked_cpu_level = QUICKED_SIMD_AVX512;
+    }
+    else if (__builtin_cpu_supports("avx2"))
+    {
+        quicked_cpu_level = QUICKED_SIMD_AVX2;
+    }
+    else if (__builtin_cpu_supports("sse4.1"))
+    {
+        quicked_cpu_level = QUICKED_SIMD_SSE41;
+    }
+#endif
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    quicked_cpu_l2_size = quicked_cpu_sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    quicked_cpu_l3_size = quicked_cpu_sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+}
+
+quicked_simd_t quicked_cpu_simd(void)
+{
+    pthread_once(&quicked_cpu_once, quicked_cpu_detect);
+    return quicked_cpu_level;
+}
+
+uint64_t quicked_cpu_cache_size(
+    const int level)
+{
+    pthread_once(&quicked_cpu_once, quicked_cpu_detect);
+    return (level == 2) ? quicked_cpu_l2_size : (level == 3) ? quicked_cpu_l3_size : 0;
+}
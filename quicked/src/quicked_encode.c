@@ -0,0 +1,231 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "quicked_utils/include/commons.h"
+#include "quicked_utils/include/dna_text.h"
+#include "quicked_encode.h"
+#include "quicked_cpu.h"
+
+#ifdef QUICKED_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#ifdef QUICKED_SIMD_X86
+/*
+ * Both cases of a base fold to the upper one (c & 0xDF), whose low nibble
+ * selects the code (pshufb). Bytes that do not fold to the base of their
+ * nibble become N
+ */
+QUICKED_TARGET("avx2")
+static uint64_t quicked_encode_ascii_avx2(
+    const char *sequence,
+    const uint64_t length,
+    uint8_t *const encoded)
+{
+    const __m256i codes = _mm256_setr_epi8(
+        4, 0, 4, 1, 3, 4, 4, 2, 4, 4, 4, 4, 4, 4, 4, 4,
+        4, 0, 4, 1, 3, 4, 4, 2, 4, 4, 4, 4, 4, 4, 4, 4);
+    const __m256i bases = _mm256_setr_epi8(
+        -1, 'A', -1, 'C', 'T', -1, -1, 'G', -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, 'A', -1, 'C', 'T', -1, -1, 'G', -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m256i upper_case = _mm256_set1_epi8((char)0xDF);
+    const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+    const __m256i enc_n = _mm256_set1_epi8(ENC_DNA_CHAR_N);
+
+    uint64_t i;
+    for (i = 0; i + 32 <= length; i += 32)
+    {
+        const __m256i chars = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&sequence[i]), upper_case);
+        const __m256i nibble = _mm256_and_si256(chars, low_nibble);
+        const __m256i is_base = _mm256_cmpeq_epi8(chars, _mm256_shuffle_epi8(bases, nibble));
+        const __m256i enc = _mm256_blendv_epi8(enc_n, _mm256_shuffle_epi8(codes, nibble), is_base);
+        _mm256_storeu_si256((__m256i *)&encoded[i], enc);
+    }
+    return i;
+}
+#endif
+
+void quicked_encode_ascii(
+    const char *sequence,
+    const uint64_t length,
+    uint8_t *const encoded,
+    const quicked_simd_t simd)
+{
+    uint64_t i = 0;
+    #ifdef QUICKED_SIMD_X86
+    if (simd >= QUICKED_SIMD_AVX2)
+    {
+        i = quicked_encode_ascii_avx2(sequence, length, encoded);
+    }
+    #endif
+    UNUSED(simd);
+    for (; i < length; ++i)
+    {
+        encoded[i] = dna_encode((uint8_t)sequence[i]);
+    }
+}
+
+void quicked_encode_packed(
+    const uint64_t *packed,
+    const uint64_t *n_mask,
+    const uint64_t length,
+    uint8_t *const encoded)
+{
+    for (uint64_t i = 0; i < length; i += 32)
+    {
+        uint64_t word = packed[i / 32];
+        const uint64_t bases = MIN(length - i, 32);
+        for (uint64_t j = 0; j < bases; ++j)
+        {
+            encoded[i + j] = word & 3;
+            word >>= 2;
+        }
+    }
+
+    if (n_mask == NULL) return;
+    for (uint64_t i = 0; i < length; i += 64)
+    {
+        uint64_t word = n_mask[i / 64];
+        if (length - i < 64) word &= (1ull << (length - i)) - 1;
+        while (word != 0)
+        {
+            encoded[i + __builtin_ctzll(word)] = ENC_DNA_CHAR_N;
+            word &= word - 1;
+        }
+    }
+}
+
+#ifdef QUICKED_SIMD_X86
+/*
+ * Common prefix/suffix: 64 or 32 bytes are compared at once, and the first
+ * mismatch is found in the equality mask. They return as soon as a block
+ * mismatches, otherwise where the full blocks end (the caller compares the rest)
+ */
+QUICKED_TARGET("avx512f,avx512bw")
+static uint64_t quicked_common_prefix_avx512(
+    const uint8_t *const a,
+    const uint8_t *const b,
+    const uint64_t length)
+{
+    uint64_t i;
+    for (i = 0; i + 64 <= length; i += 64)
+    {
+        const __mmask64 equal = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(&a[i]), _mm512_loadu_si512(&b[i]));
+        if (equal != UINT64_MAX) return i + __builtin_ctzll(~equal);
+    }
+    return i;
+}
+
+QUICKED_TARGET("avx2")
+static uint64_t quicked_common_prefix_avx2(
+    const uint8_t *const a,
+    const uint8_t *const b,
+    const uint64_t length)
+{
+    uint64_t i;
+    for (i = 0; i + 32 <= length; i += 32)
+    {
+        const __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)&a[i]), _mm256_loadu_si256((const __m256i *)&b[i]));
+        const uint32_t equal = (uint32_t)_mm256_movemask_epi8(eq);
+        if (equal != UINT32_MAX) return i + __builtin_ctz(~equal);
+    }
+    return i;
+}
+
+QUICKED_TARGET("avx512f,avx512bw")
+static uint64_t quicked_common_suffix_avx512(
+    const uint8_t *const a_end,
+    const uint8_t *const b_end,
+    const uint64_t length)
+{
+    uint64_t i;
+    for (i = 0; i + 64 <= length; i += 64)
+    {
+        const __mmask64 equal = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(a_end - i - 64), _mm512_loadu_si512(b_end - i - 64));
+        if (equal != UINT64_MAX) return i + __builtin_clzll(~equal);
+    }
+    return i;
+}
+
+QUICKED_TARGET("avx2")
+static uint64_t quicked_common_suffix_avx2(
+    const uint8_t *const a_end,
+    const uint8_t *const b_end,
+    const uint64_t length)
+{
+    uint64_t i;
+    for (i = 0; i + 32 <= length; i += 32)
+    {
+        const __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(a_end - i - 32)),
+                                             _mm256_loadu_si256((const __m256i *)(b_end - i - 32)));
+        const uint32_t equal = (uint32_t)_mm256_movemask_epi8(eq);
+        if (equal != UINT32_MAX) return i + __builtin_clz(~equal);
+    }
+    return i;
+}
+#endif
+
+uint64_t quicked_common_prefix(
+    const uint8_t *const a,
+    const uint8_t *const b,
+    const uint64_t length,
+    const quicked_simd_t simd)
+{
+    uint64_t i = 0;
+    #ifdef QUICKED_SIMD_X86
+    if (simd >= QUICKED_SIMD_AVX512)
+    {
+        i = quicked_common_prefix_avx512(a, b, length);
+    }
+    else if (simd >= QUICKED_SIMD_AVX2)
+    {
+        i = quicked_common_prefix_avx2(a, b, length);
+    }
+    #endif
+    UNUSED(simd);
+    while (i < length && a[i] == b[i]) ++i;
+    return i;
+}
+
+uint64_t quicked_common_suffix(
+    const uint8_t *const a_end,
+    const uint8_t *const b_end,
+    const uint64_t length,
+    const quicked_simd_t simd)
+{
+    uint64_t i = 0;
+    #ifdef QUICKED_SIMD_X86
+    if (simd >= QUICKED_SIMD_AVX512)
+    {
+        i = quicked_common_suffix_avx512(a_end, b_end, length);
+    }
+    else if (simd >= QUICKED_SIMD_AVX2)
+    {
+        i = quicked_common_suffix_avx2(a_end, b_end, length);
+    }
+    #endif
+    UNUSED(simd);
+    while (i < length && a_end[-1 - (int64_t)i] == b_end[-1 - (int64_t)i]) ++i;
+    return i;
+}
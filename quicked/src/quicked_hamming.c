@@ -0,0 +1,178 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "quicked_hamming.h"
+#include "quicked_cpu.h"
+
+#ifdef QUICKED_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#ifdef QUICKED_SIMD_X86
+// Mismatches of the full 64-byte (32-byte) blocks: popcount of the inequality mask
+QUICKED_TARGET("avx512f,avx512bw,popcnt")
+static uint64_t quicked_hamming_distance_avx512(
+    const uint8_t *const pattern,
+    const uint8_t *const text,
+    const uint64_t length,
+    uint64_t *const mismatches)
+{
+    uint64_t i;
+    for (i = 0; i + 64 <= length; i += 64)
+    {
+        const __mmask64 equal = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(&pattern[i]), _mm512_loadu_si512(&text[i]));
+        *mismatches += __builtin_popcountll(~equal);
+    }
+    return i;
+}
+
+QUICKED_TARGET("avx2,popcnt")
+static uint64_t quicked_hamming_distance_avx2(
+    const uint8_t *const pattern,
+    const uint8_t *const text,
+    const uint64_t length,
+    uint64_t *const mismatches)
+{
+    uint64_t i;
+    for (i = 0; i + 32 <= length; i += 32)
+    {
+        const __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)&pattern[i]),
+                                             _mm256_loadu_si256((const __m256i *)&text[i]));
+        *mismatches += __builtin_popcount(~(uint32_t)_mm256_movemask_epi8(eq));
+    }
+    return i;
+}
+#endif
+
+uint64_t quicked_hamming_distance(
+    const uint8_t *const pattern,
+    const uint8_t *const text,
+    const uint64_t length,
+    const quicked_simd_t simd)
+{
+    uint64_t mismatches = 0, i = 0;
+    #ifdef QUICKED_SIMD_X86
+    if (simd >= QUICKED_SIMD_AVX512)
+    {
+        i = quicked_hamming_distance_avx512(pattern, text, length, &mismatches);
+    }
+    else if (simd >= QUICKED_SIMD_AVX2)
+    {
+        i = quicked_hamming_distance_avx2(pattern, text, length, &mismatches);
+    }
+    #endif
+    UNUSED(simd);
+    for (; i < length; ++i)
+    {
+        mismatches += (pattern[i] != text[i]);
+    }
+    return mismatches;
+}
+
+// Pattern position where the matches from (v, h) end, 8 bases at a time
+static inline int64_t quicked_hamming_slide(
+    const uint8_t *const pattern,
+    const uint8_t *const text,
+    const int64_t length,
+    int64_t v,
+    int64_t h)
+{
+    while (v + UINT64_SIZE <= length && h + UINT64_SIZE <= length)
+    {
+        uint64_t pattern_word, text_word;
+        memcpy(&pattern_word, &pattern[v], UINT64_SIZE);
+        memcpy(&text_word, &text[h], UINT64_SIZE);
+        const uint64_t diff = pattern_word ^ text_word;
+        if (diff != 0) return v + __builtin_ctzll(diff) / 8; // Little-endian: the first base is the lowest byte
+        v += UINT64_SIZE;
+        h += UINT64_SIZE;
+    }
+    while (v < length && h < length && pattern[v] == text[h])
+    {
+        ++v;
+        ++h;
+    }
+    return v;
+}
+
+bool quicked_hamming_indels_cheaper(
+    const uint8_t *const pattern,
+    const uint8_t *const text,
+    const int64_t length,
+    const int64_t hamming_distance)
+{
+    // A cheaper alignment needs an indel pair (2 edits) and at most hamming_distance - 1 edits,
+    // so it differs from the Hamming one (<= 1 mismatch otherwise)
+    const int64_t max_distance = hamming_distance - 1;
+    if (max_distance < 2) return false;
+
+    // Furthest pattern position reached on each diagonal (h - v) with d edits, with a sentinel on each side.
+    // Sized for the largest distance checked, so it fits on the stack
+    assert(hamming_distance <= QUICKED_HAMMING_MAX_DISTANCE);
+    const int64_t unreachable = -length - 2;
+    const int64_t num_diagonals = 2 * max_distance + 3;
+    int64_t furthest[2 * (2 * QUICKED_HAMMING_MAX_DISTANCE + 1)];
+    int64_t *prev = furthest + max_distance + 1;
+    int64_t *cur = prev + num_diagonals;
+    for (int64_t k = -max_distance - 1; k <= max_distance + 1; ++k)
+    {
+        prev[k] = unreachable;
+        cur[k] = unreachable;
+    }
+    prev[0] = quicked_hamming_slide(pattern, text, length, 0, 0);
+
+    bool cheaper = false;
+    for (int64_t d = 1; d <= max_distance && !cheaper; ++d)
+    {
+        // Diagonals from which the main one can still be reached within max_distance
+        const int64_t reach = MIN(d, max_distance - d);
+        for (int64_t k = -reach - 1; k <= reach + 1; ++k) cur[k] = unreachable;
+        for (int64_t k = -reach; k <= reach; ++k)
+        {
+            // Mismatch (same diagonal), text base (k - 1 -> k) or pattern base (k + 1 -> k)
+            int64_t v = MAX(MAX(prev[k] + 1, prev[k - 1]), prev[k + 1] + 1);
+            v = MIN(v, MIN(length, length - k));
+            if (v < 0 || v + k < 0) continue;
+            cur[k] = quicked_hamming_slide(pattern, text, length, v, v + k);
+        }
+        cheaper = (cur[0] >= length);
+        int64_t *const swap = prev;
+        prev = cur;
+        cur = swap;
+    }
+    return cheaper;
+}
+
+void quicked_hamming_operations(
+    const uint8_t *const pattern,
+    const uint8_t *const text,
+    const uint64_t length,
+    char *const operations)
+{
+    for (uint64_t i = 0; i < length; ++i)
+    {
+        operations[i] = (pattern[i] == text[i]) ? 'M' : 'X';
+    }
+}
@@ -0,0 +1,87 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "quicked.h"
+#include "quicked_pattern.h"
+#include "quicked_encode.h"
+#include "quicked_cpu.h"
+#include <stdlib.h>
+#include <string.h>
+
+quicked_status_t quicked_pattern_compile(
+    const quicked_aligner_t *aligner,
+    quicked_pattern_t **compiled_pattern,
+    const char* pattern, const int pattern_len)
+{
+    *compiled_pattern = NULL;
+    if (pattern_len == 0)
+    {
+        return QUICKED_EMPTY_SEQUENCE;
+    }
+
+    // Plain malloc: the handle outlives (and is shared among) the aligners' allocators
+    const uint64_t banded_size = banded_pattern_size(pattern_len);
+    const uint64_t windowed_size = windowed_pattern_size(pattern_len);
+    const uint64_t strings_size = 2 * (uint64_t)pattern_len;
+    quicked_pattern_t *const compiled = (quicked_pattern_t *)malloc(sizeof(quicked_pattern_t));
+    void *const memory = malloc(2 * (banded_size + windowed_size) + strings_size);
+    if (compiled == NULL || memory == NULL)
+    {
+        free(compiled);
+        free(memory);
+        return QUICKED_ERROR;
+    }
+
+    // Bit vectors first (keeps them 8-byte aligned), then the pattern strings
+    compiled->memory = memory;
+    compiled->pattern_length = pattern_len;
+    compiled->pattern = (char *)memory + 2 * (banded_size + windowed_size);
+    compiled->pattern_r = compiled->pattern + pattern_len;
+    const quicked_simd_t simd = aligner->simd;
+    quicked_encode_ascii(pattern, pattern_len, (uint8_t *)compiled->pattern, simd);
+    reverse_string(compiled->pattern, compiled->pattern_r, pattern_len);
+
+    void *mem_ptr = memory;
+    banded_pattern_init(&compiled->banded, compiled->pattern, pattern_len, simd, mem_ptr);
+    mem_ptr += banded_size;
+    banded_pattern_init(&compiled->banded_r, compiled->pattern_r, pattern_len, simd, mem_ptr);
+    mem_ptr += banded_size;
+    windowed_pattern_init(&compiled->windowed, compiled->pattern, pattern_len, simd, mem_ptr);
+    mem_ptr += windowed_size;
+    windowed_pattern_init(&compiled->windowed_r, compiled->pattern_r, pattern_len, simd, mem_ptr);
+
+    *compiled_pattern = compiled;
+    return QUICKED_OK;
+}
+
+quicked_status_t quicked_pattern_free(
+    quicked_pattern_t *compiled_pattern)
+{
+    if (compiled_pattern != NULL)
+    {
+        free(compiled_pattern->memory);
+        free(compiled_pattern);
+    }
+    return QUICKED_OK;
+}
@@ -0,0 +1,75 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "quicked.h"
+#include "quicked_utils/include/commons.h"
+#include <string.h>
+
+void quicked_stats_aggregate_reset(
+    quicked_stats_aggregate_t *aggregate)
+{
+    memset(aggregate, 0, sizeof(quicked_stats_aggregate_t));
+    aggregate->max_final_cutoff = -1;
+}
+
+void quicked_stats_aggregate_add(
+    quicked_stats_aggregate_t *aggregate,
+    const quicked_stats_t *stats)
+{
+    aggregate->alignments++;
+    aggregate->bound_stage[stats->bound_stage]++;
+    for (int i = 0; i < QUICKED_WINDOW_STAGES; i++)
+    {
+        aggregate->high_error_windows[i] += stats->high_error_windows[i];
+    }
+    aggregate->band_doublings += stats->band_doublings;
+    aggregate->max_band_doublings = MAX(aggregate->max_band_doublings, stats->band_doublings);
+    aggregate->max_final_cutoff = MAX(aggregate->max_final_cutoff, stats->final_cutoff);
+    aggregate->max_hirschberg_depth = MAX(aggregate->max_hirschberg_depth, stats->hirschberg_depth);
+    aggregate->anchored += (stats->anchors > 0);
+    aggregate->cells += stats->cells;
+    aggregate->max_cells = MAX(aggregate->max_cells, stats->cells);
+}
+
+void quicked_stats_aggregate_merge(
+    quicked_stats_aggregate_t *aggregate,
+    const quicked_stats_aggregate_t *other)
+{
+    aggregate->alignments += other->alignments;
+    for (int i = 0; i < QUICKED_STAGE_COUNT; i++)
+    {
+        aggregate->bound_stage[i] += other->bound_stage[i];
+    }
+    for (int i = 0; i < QUICKED_WINDOW_STAGES; i++)
+    {
+        aggregate->high_error_windows[i] += other->high_error_windows[i];
+    }
+    aggregate->band_doublings += other->band_doublings;
+    aggregate->max_band_doublings = MAX(aggregate->max_band_doublings, other->max_band_doublings);
+    aggregate->max_final_cutoff = MAX(aggregate->max_final_cutoff, other->max_final_cutoff);
+    aggregate->max_hirschberg_depth = MAX(aggregate->max_hirschberg_depth, other->max_hirschberg_depth);
+    aggregate->anchored += other->anchored;
+    aggregate->cells += other->cells;
+    aggregate->max_cells = MAX(aggregate->max_cells, other->max_cells);
+}
@@ -0,0 +1,189 @@
+/*
+ *                             The MIT License
+ *
+ * This file is part of QuickEd library.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "quicked_utils/include/commons.h"
+#include "quicked_utils/include/mm_allocator.h"
+#include "quicked_workspace.h"
+#include <sys/mman.h>
+
+/*
+ * Setup
+ */
+void workspace_buffer_free(
+    workspace_buffer_t *const buffer,
+    mm_allocator_t *const mm_allocator)
+{
+    if (buffer->memory != NULL)
+    {
+        mm_allocator_free(mm_allocator, buffer->memory);
+        buffer->memory = NULL;
+    }
+    buffer->size = 0;
+}
+
+void workspace_pass_free(
+    workspace_pass_t *const pass,
+    mm_allocator_t *const mm_allocator)
+{
+    workspace_buffer_free(&pass->pattern, mm_allocator);
+    workspace_buffer_free(&pass->Pv, mm_allocator);
+    workspace_buffer_free(&pass->Mv, mm_allocator);
+    workspace_buffer_free(&pass->scores, mm_allocator);
+    workspace_buffer_free(&pass->PEQ_window, mm_allocator);
+    workspace_buffer_free(&pass->operations, mm_allocator);
+}
+
+quicked_workspace_t* quicked_workspace_new(
+    mm_allocator_t *const mm_allocator)
+{
+    quicked_workspace_t *const workspace = mm_allocator_alloc(mm_allocator, quicked_workspace_t);
+    memset(workspace, 0, sizeof(quicked_workspace_t));
+    workspace->mm_allocator = mm_allocator;
+    return workspace;
+}
+
+void quicked_workspace_delete(
+    quicked_workspace_t *const workspace)
+{
+    mm_allocator_t *const mm_allocator = workspace->mm_allocator;
+    // Free in reverse order, so the allocator can reclaim the segment tail
+    workspace_buffer_free(&workspace->cigar_packed, mm_allocator);
+    workspace_buffer_free(&workspace->cigar, mm_allocator);
+    workspace_buffer_free(&workspace->operations, mm_allocator);
+    workspace_buffer_free(&workspace->cell_score_r, mm_allocator);
+    workspace_buffer_free(&workspace->cell_score, mm_allocator);
+    workspace_buffer_free(&workspace->pattern_enc, mm_allocator);
+    workspace_buffer_free(&workspace->text_enc, mm_allocator);
+    workspace_buffer_free(&workspace->pattern_r, mm_allocator);
+    workspace_buffer_free(&workspace->text_r, mm_allocator);
+    workspace_pass_free(&workspace->reverse, mm_allocator);
+    workspace_pass_free(&workspace->forward, mm_allocator);
+    mm_allocator_free(mm_allocator, workspace);
+}
+
+quicked_workspace_pool_t* quicked_workspace_pool_new(
+    const uint64_t segment_size,
+    mm_allocator_pool_t *const allocator_pool)
+{
+    quicked_workspace_pool_t *const pool = malloc(sizeof(quicked_workspace_pool_t));
+    pool->owns_allocator_pool = (allocator_pool == NULL);
+    pool->allocator_pool = (allocator_pool != NULL) ? allocator_pool :
+                           mm_allocator_pool_new(segment_size, QUICKED_WORKSPACE_POOL_IDLE_SEGMENTS);
+    pool->idle = NULL;
+    pool->num_idle = 0;
+    pool->max_idle = 0;
+    pthread_mutex_init(&pool->mutex, NULL);
+    return pool;
+}
+
+void quicked_workspace_pool_delete(
+    quicked_workspace_pool_t *const pool)
+{
+    // All workspaces must have been released
+    for (int i = 0; i < pool->num_idle; i++)
+    {
+        mm_allocator_t *const mm_allocator = pool->idle[i]->mm_allocator;
+        quicked_workspace_delete(pool->idle[i]);
+        mm_allocator_delete(mm_allocator);
+    }
+    free(pool->idle);
+    if (pool->owns_allocator_pool) mm_allocator_pool_delete(pool->allocator_pool);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool);
+}
+
+/*
+ * Accessors
+ */
+// Allocator segments: the default unless the memory budget (0: none) is smaller
+uint64_t quicked_workspace_segment_size(
+    const uint64_t memory_budget,
+    const uint64_t default_size)
+{
+    return (memory_budget > 0) ? MIN(default_size, MAX(memory_budget, BUFFER_SIZE_1M)) : default_size;
+}
+
+void* workspace_buffer_reserve(
+    workspace_buffer_t *const buffer,
+    const uint64_t size,
+    const bool huge_pages,
+    mm_allocator_t *const mm_allocator)
+{
+    if (size <= buffer->size)
+    {
+        return buffer->memory;
+    }
+
+    // Grow geometrically, so a slowly increasing length does not reallocate on every call
+    const uint64_t new_size = MAX(size, buffer->size + buffer->size / 2);
+    workspace_buffer_free(buffer, mm_allocator);
+
+    if (huge_pages && new_size > BUFFER_SIZE_256K)
+    {
+        buffer->memory = mm_allocator_allocate(mm_allocator, new_size, false, BUFFER_SIZE_2M);
+        #ifdef __linux__
+            // Huge pages are only a hint: without them (e.g. disabled in the kernel), regular pages are used
+            madvise(buffer->memory, new_size, MADV_HUGEPAGE);
+        #endif
+    }
+    else
+    {
+        buffer->memory = mm_allocator_malloc(mm_allocator, new_size);
+    }
+    buffer->size = new_size;
+
+    return buffer->memory;
+}
+
+quicked_workspace_t* quicked_workspace_pool_acquire(
+    quicked_workspace_pool_t *const pool)
+{
+    quicked_workspace_t *workspace = NULL;
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->num_idle > 0)
+    {
+        workspace = pool->idle[--pool->num_idle];
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (workspace == NULL)
+    {
+        workspace = quicked_workspace_new(mm_allocator_new_pooled(pool->allocator_pool));
+    }
+    return workspace;
+}
+
+void quicked_workspace_pool_release(
+    quicked_workspace_pool_t *const pool,
+    quicked_workspace_t *const workspace)
+{
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->num_idle == pool->max_idle)
+    {
+        pool->max_idle = MAX(2 * pool->max_idle, 4);
+        pool->idle = realloc(pool->idle, pool->max_idle * sizeof(quicked_workspace_t *));
+    }
+    pool->idle[pool->num_idle++] = workspace;
+    pthread_mutex_unlock(&pool->mutex);
+}
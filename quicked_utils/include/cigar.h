@@ -27,6 +27,18 @@
 
 #include "quicked_utils/include/mm_allocator.h"
 
+/*
+ * SAM CIGAR Operations
+ */
+#define SAM_CIGAR_MATCH  0
+#define SAM_CIGAR_INS    1
+#define SAM_CIGAR_DEL    2
+#define SAM_CIGAR_N_SKIP 3
+#define SAM_CIGAR_EQ     7
+#define SAM_CIGAR_X      8
+/* ... */
+#define SAM_CIGAR_NA    15
+
 /*
  * CIGAR
  */
@@ -100,11 +112,32 @@ void cigar_to_operations(
     cigar_t* const cigar,
     const char* const cigar_str,
     const uint64_t cigar_length);
+
+/*
+ * Run-length SAM CIGAR built backwards (e.g. by a backtrace): runs are
+ * stored last to first until cigar_reverse_CIGAR puts them in order
+ */
+static inline void cigar_prepend_SAM_operation(
+    cigar_t* const cigar,
+    const uint32_t sam_op) {
+  uint32_t* const cigar_buffer = cigar->cigar_buffer;
+  const int cigar_length = cigar->cigar_length;
+  if (cigar_length > 0 && (cigar_buffer[cigar_length-1] & 0xf) == sam_op) {
+    cigar_buffer[cigar_length-1] += 1 << 4;
+  } else {
+    cigar_buffer[cigar_length] = (1 << 4) | sam_op;
+    cigar->cigar_length = cigar_length + 1;
+  }
+}
+void cigar_reverse_CIGAR(
+    cigar_t* const cigar);
 /*
  * Score
  */
 int cigar_score_edit(
     cigar_t* const cigar);
+int cigar_score_edit_CIGAR(
+    cigar_t* const cigar);
 
 /*
  * Utils
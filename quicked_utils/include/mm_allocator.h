@@ -28,6 +28,7 @@
 #include <stdio.h>
 #include "vector.h"
 #include <sys/mman.h>
+#include <pthread.h>
 
 /*
  * Configuration
@@ -35,6 +36,22 @@
 //#define MM_ALLOCATOR_LOG
 #define MM_ALLOCATOR_ALIGNMENT 8 // 64bits
 
+#define MM_ALLOCATOR_MAGAZINE_SEGMENTS 1 // Free segments a pooled allocator keeps for itself
+
+/*
+ * MM-Allocator Pool (thread-safe)
+ *   Segments shared by the allocators of several threads. Pooled allocators take
+ *   their segments from the pool and, beyond a small magazine of their own, give
+ *   back the ones they free. The pool frees what exceeds its idle limit.
+ */
+typedef struct {
+  uint64_t segment_size;          // Memory segment size (bytes)
+  void** idle_segments;           // Segments not used by any allocator (memory)
+  uint64_t num_idle_segments;
+  uint64_t max_idle_segments;     // Segments given back beyond it are freed
+  pthread_mutex_t mutex;
+} mm_allocator_pool_t;
+
 /*
  * MM-Allocator
  */
@@ -46,6 +63,9 @@ typedef struct {
   vector_t* segments;             // Memory segments (mm_allocator_segment_t*)
   vector_t* segments_free;        // Completely free segments (mm_allocator_segment_t*)
   uint64_t current_segment_idx;   // Current segment being used (serving memory)
+  // Pool
+  mm_allocator_pool_t* pool;      // Source of the segments (NULL if they are malloc'ed)
+  uint64_t magazine_segments;     // Free segments still holding memory (pooled)
   // Malloc memory
   vector_t* malloc_requests;      // Malloc requests (mm_malloc_request_t)
   uint64_t malloc_requests_freed; // Total malloc request freed and still in vector
@@ -56,11 +76,24 @@ typedef struct {
  */
 mm_allocator_t* mm_allocator_new(
     const uint64_t segment_size);
+mm_allocator_t* mm_allocator_new_pooled(
+    mm_allocator_pool_t* const pool);
 void mm_allocator_clear(
     mm_allocator_t* const mm_allocator);
 void mm_allocator_delete(
     mm_allocator_t* const mm_allocator);
 
+/*
+ * Pool Setup
+ */
+mm_allocator_pool_t* mm_allocator_pool_new(
+    const uint64_t segment_size,
+    const uint64_t max_idle_segments);
+void mm_allocator_pool_trim(
+    mm_allocator_pool_t* const pool);
+void mm_allocator_pool_delete(
+    mm_allocator_pool_t* const pool);
+
 /*
  * Allocator
  */
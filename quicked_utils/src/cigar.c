@@ -29,15 +29,6 @@
 /*
  * SAM CIGAR Operations
  */
-#define SAM_CIGAR_MATCH  0
-#define SAM_CIGAR_INS    1
-#define SAM_CIGAR_DEL    2
-#define SAM_CIGAR_N_SKIP 3
-#define SAM_CIGAR_EQ     7
-#define SAM_CIGAR_X      8
-/* ... */
-#define SAM_CIGAR_NA    15
-
 const uint8_t sam_cigar_lut[256] =
 {
   [0 ... 255] = SAM_CIGAR_NA,
@@ -268,6 +259,16 @@ void cigar_to_operations(
     }
   }
 }
+void cigar_reverse_CIGAR(
+    cigar_t* const cigar) {
+  uint32_t* const cigar_buffer = cigar->cigar_buffer;
+  int i, j;
+  for (i=0,j=cigar->cigar_length-1;i<j;++i,--j) {
+    const uint32_t run = cigar_buffer[i];
+    cigar_buffer[i] = cigar_buffer[j];
+    cigar_buffer[j] = run;
+  }
+}
 /*
  * Score
  */
@@ -287,6 +288,22 @@ int cigar_score_edit(
   }
   return score;
 }
+int cigar_score_edit_CIGAR(
+    cigar_t* const cigar) {
+  int score = 0, i;
+  for (i=0;i<cigar->cigar_length;++i) {
+    switch (cigar->cigar_buffer[i] & 0xf) {
+      case SAM_CIGAR_EQ: break;
+      case SAM_CIGAR_X:
+      case SAM_CIGAR_DEL:
+      case SAM_CIGAR_INS: score += cigar->cigar_buffer[i] >> 4; break;
+      default:
+        fprintf(stderr,"[CIGAR] Computing CIGAR score: Unknown SAM operation (%u)\n",cigar->cigar_buffer[i] & 0xf);
+        exit(1);
+    }
+  }
+  return score;
+}
 /*
  * Utils
  */
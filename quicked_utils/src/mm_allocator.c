@@ -94,9 +94,81 @@ typedef struct {
   vector_t* requests;           // Memory requests (mm_allocator_request_t)
 } mm_allocator_segment_t;
 
+/*
+ * Pool
+ */
+mm_allocator_pool_t* mm_allocator_pool_new(
+    const uint64_t segment_size,
+    const uint64_t max_idle_segments) {
+  // Allocate handler
+  mm_allocator_pool_t* const pool = (mm_allocator_pool_t*) malloc(sizeof(mm_allocator_pool_t));
+  pool->segment_size = segment_size;
+  // Idle segments
+  pool->idle_segments = (void**) malloc(MAX(max_idle_segments,1)*sizeof(void*));
+  pool->num_idle_segments = 0;
+  pool->max_idle_segments = max_idle_segments;
+  pthread_mutex_init(&pool->mutex,NULL);
+  // Return
+  return pool;
+}
+void mm_allocator_pool_trim(
+    mm_allocator_pool_t* const pool) {
+  pthread_mutex_lock(&pool->mutex);
+  uint64_t i;
+  for (i=0;i<pool->num_idle_segments;++i) {
+    free(pool->idle_segments[i]);
+  }
+  pool->num_idle_segments = 0;
+  pthread_mutex_unlock(&pool->mutex);
+}
+void mm_allocator_pool_delete(
+    mm_allocator_pool_t* const pool) {
+  mm_allocator_pool_trim(pool);
+  pthread_mutex_destroy(&pool->mutex);
+  free(pool->idle_segments);
+  free(pool);
+}
+void* mm_allocator_pool_take(
+    mm_allocator_pool_t* const pool) {
+  void* memory = NULL;
+  pthread_mutex_lock(&pool->mutex);
+  if (pool->num_idle_segments > 0) {
+    memory = pool->idle_segments[--(pool->num_idle_segments)];
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  // Nothing idle, allocate outside the lock
+  return (memory != NULL) ? memory : malloc(pool->segment_size);
+}
+void mm_allocator_pool_give(
+    mm_allocator_pool_t* const pool,
+    void* const memory) {
+  bool kept = false;
+  pthread_mutex_lock(&pool->mutex);
+  if (pool->num_idle_segments < pool->max_idle_segments) {
+    pool->idle_segments[(pool->num_idle_segments)++] = memory;
+    kept = true;
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  if (!kept) free(memory);
+}
 /*
  * Segments
  */
+void* mm_allocator_segment_memory_acquire(
+    mm_allocator_t* const mm_allocator) {
+  return (mm_allocator->pool != NULL) ?
+      mm_allocator_pool_take(mm_allocator->pool) :
+      malloc(mm_allocator->segment_size);
+}
+void mm_allocator_segment_memory_release(
+    mm_allocator_t* const mm_allocator,
+    void* const memory) {
+  if (mm_allocator->pool != NULL) {
+    mm_allocator_pool_give(mm_allocator->pool,memory);
+  } else {
+    free(memory);
+  }
+}
 mm_allocator_segment_t* mm_allocator_segment_new(
     mm_allocator_t* const mm_allocator) {
   // Allocate handler
@@ -106,7 +178,7 @@ mm_allocator_segment_t* mm_allocator_segment_new(
   segment->idx = segment_idx;
   // Memory
   segment->size = mm_allocator->segment_size;
-  segment->memory = malloc(mm_allocator->segment_size);
+  segment->memory = mm_allocator_segment_memory_acquire(mm_allocator);
   segment->used = 0;
   // Requests
   segment->requests = vector_new(MM_ALLOCATOR_SEGMENT_INITIAL_REQUESTS,mm_allocator_request_t);
@@ -121,11 +193,26 @@ void mm_allocator_segment_clear(
   vector_clear(segment->requests);
 }
 void mm_allocator_segment_delete(
+    mm_allocator_t* const mm_allocator,
     mm_allocator_segment_t* const segment) {
   vector_delete(segment->requests);
-  free(segment->memory);
+  if (segment->memory != NULL) {
+    mm_allocator_segment_memory_release(mm_allocator,segment->memory);
+  }
   free(segment);
 }
+void mm_allocator_segment_stash(
+    mm_allocator_t* const mm_allocator,
+    mm_allocator_segment_t* const segment) {
+  // Pooled allocators only keep a magazine of free segments, the rest go back to the pool
+  if (mm_allocator->pool == NULL || segment->memory == NULL) return;
+  if (mm_allocator->magazine_segments < MM_ALLOCATOR_MAGAZINE_SEGMENTS) {
+    ++(mm_allocator->magazine_segments);
+  } else {
+    mm_allocator_segment_memory_release(mm_allocator,segment->memory);
+    segment->memory = NULL; // Refilled when fetched again
+  }
+}
 mm_allocator_request_t* mm_allocator_segment_get_request(
     mm_allocator_segment_t* const segment,
     const uint64_t request_idx) {
@@ -138,11 +225,15 @@ uint64_t mm_allocator_segment_get_num_requests(
 /*
  * Setup
  */
-mm_allocator_t* mm_allocator_new(
-    const uint64_t segment_size) {
+mm_allocator_t* mm_allocator_new_with_pool(
+    const uint64_t segment_size,
+    mm_allocator_pool_t* const pool) {
   // Allocate handler
   mm_allocator_t* const mm_allocator = (mm_allocator_t*) malloc(sizeof(mm_allocator_t));
   mm_allocator->request_ticker = 0;
+  // Pool
+  mm_allocator->pool = pool;
+  mm_allocator->magazine_segments = 0;
   // Segments
   mm_allocator->segment_size = segment_size;
   mm_allocator->segments = vector_new(MM_ALLOCATOR_INITIAL_SEGMENTS,mm_allocator_segment_t*);
@@ -160,13 +251,28 @@ mm_allocator_t* mm_allocator_new(
   // Return
   return mm_allocator;
 }
+mm_allocator_t* mm_allocator_new(
+    const uint64_t segment_size) {
+  return mm_allocator_new_with_pool(segment_size,NULL);
+}
+mm_allocator_t* mm_allocator_new_pooled(
+    mm_allocator_pool_t* const pool) {
+  return mm_allocator_new_with_pool(pool->segment_size,pool);
+}
 void mm_allocator_clear(
     mm_allocator_t* const mm_allocator) {
   // Clear segments
   vector_clear(mm_allocator->segments_free);
+  mm_allocator->magazine_segments = 0;
   VECTOR_ITERATE(mm_allocator->segments,segment_ptr,p,mm_allocator_segment_t*) {
-    mm_allocator_segment_clear(*segment_ptr); // Clear segment
-    vector_insert(mm_allocator->segments_free,*segment_ptr,mm_allocator_segment_t*); // Add to free segments
+    mm_allocator_segment_t* const segment = *segment_ptr;
+    mm_allocator_segment_clear(segment); // Clear segment
+    if (segment->idx == 0) { // First segment becomes the current one
+      if (segment->memory == NULL) segment->memory = mm_allocator_segment_memory_acquire(mm_allocator);
+    } else {
+      vector_insert(mm_allocator->segments_free,segment,mm_allocator_segment_t*); // Add to free segments
+      mm_allocator_segment_stash(mm_allocator,segment);
+    }
   }
   mm_allocator->current_segment_idx = 0;
   // Clear malloc memory
@@ -180,7 +286,7 @@ void mm_allocator_delete(
     mm_allocator_t* const mm_allocator) {
   // Free segments
   VECTOR_ITERATE(mm_allocator->segments,segment_ptr,p,mm_allocator_segment_t*) {
-    mm_allocator_segment_delete(*segment_ptr);
+    mm_allocator_segment_delete(mm_allocator,*segment_ptr);
   }
   vector_delete(mm_allocator->segments);
   vector_delete(mm_allocator->segments_free);
@@ -240,6 +346,11 @@ mm_allocator_segment_t* mm_allocator_fetch_segment(
     mm_allocator_segment_t* const segment =
         mm_allocator_get_segment_free(mm_allocator,free_segments-1);
     vector_dec_used(mm_allocator->segments_free);
+    if (segment->memory == NULL) {
+      segment->memory = mm_allocator_segment_memory_acquire(mm_allocator); // Refill from the pool
+    } else if (mm_allocator->pool != NULL) {
+      --(mm_allocator->magazine_segments);
+    }
     mm_allocator->current_segment_idx = segment->idx;
     return segment;
   }
@@ -402,6 +513,7 @@ void mm_allocator_free_allocator_request(
       // Add to free segments (if it is not the current segment)
       if (segment->idx != mm_allocator->current_segment_idx) {
         vector_insert(mm_allocator->segments_free,segment,mm_allocator_segment_t*);
+        mm_allocator_segment_stash(mm_allocator,segment);
       }
     }
   }
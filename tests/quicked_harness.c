@@ -23,15 +23,760 @@
  */
 
 #include <quicked.h>
+#include <ctype.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <unistd.h>
 
-int main(int argc, char *argv[]) { // Usage: ./quicked_harness <text> <pattern> <expected score>
+/*
+ * Usage: ./quicked_harness [options] <pattern> <text> [expected score]
+ *        ./quicked_harness [options] -i <dataset>
+ *
+ *   -a <algo>     quicked (default), windowed, banded or hirschberg
+ *   -b <percent>  Bandwidth
+ *   -s            Only score
+ *   -S            Scalar kernels (force_scalar), checked against a reference with the SIMD ones (dataset only)
+ *   -t <threads>  Threads per alignment (num_threads)
+ *   -k <length>   Anchored alignment (anchor_length), checked against the unanchored one. Alignments split at
+ *                 anchors (stats.anchors) may score up to 1% above it, the others must match it
+ *   -M <bytes>    Memory budget (memory_budget), checked against the alignment without one
+ *   -c <output>   packed (QUICKED_CIGAR_PACKED) or stream (cigar_callback) operations, decoded and
+ *                 compared with the CIGAR string of the reference (dataset only)
+ *   -m <offset>   Decision mode, with max_score at the reference score plus offset (dataset only)
+ *   -e            Ends-free. Checked against a semi-global dynamic programming (dataset only)
+ *   -H <mismatch> Equal-length pairs: each text is replaced by its pattern with about that many substitutions
+ *                 (spread by up to 4 either side), and every other pair also has a segment shifted by one
+ *                 base. Checked against the dynamic programming (dataset only)
+ *   -w <length>   Wraps each pair between shared random flanks of that length, trimmed off as a common prefix
+ *                 and suffix. Checked against the reference on the bare pair, whose operations must be the
+ *                 same between the flank matches (dataset only, global alignments)
+ *   -E <entry>    Aligns through encoded (quicked_align_encoded), packed (quicked_align_packed, with an N mask
+ *                 only if there are N bases) or compiled (quicked_pattern_compile and quicked_align_compiled)
+ *                 sequences, checked against quicked_align. Each compiled pattern is also aligned against
+ *                 the text of the previous pair, unless -w (dataset only)
+ *   -N <count>    Puts that many N bases at random positions of each pattern and text (dataset only)
+ *   -B <threads>  Aligns the whole dataset with quicked_align_batch on that many workers, and checks each
+ *                 score and CIGAR, and the merged statistics, against quicked_align on each pair. Every other
+ *                 pair is cut down to at most 512 bases, for the lane kernels of score-only batches (dataset only)
+ *   -P <bytes>    Aligners (and batch workers) on a shared pool (allocator_pool) of segments of that size, checked
+ *                 against a reference without it. A batch runs twice, the second one on the segments left by
+ *                 the first (dataset only)
+ *   -x <xdrop>    X-drop extension. Checked against an X-drop over the full dynamic programming. The second
+ *                 half of each text is reversed, so that the extension drops there (dataset only)
+ *   -i <dataset>  Aligns each pair of the dataset (pattern and text lines, optionally starting
+ *                 with '>' and '<') and checks it against a reference run with one thread.
+ *                 Mismatches are reported as "INACCURATE SCORE"
+ */
+
+static void check_status(quicked_status_t status) {
+    if (quicked_check_error(status)) {
+        fprintf(stderr, "%s", quicked_status_msg(status));
+        exit(EXIT_FAILURE);
+    }
+}
+
+static quicked_algo_t parse_algo(const char *name) {
+    if (strcmp(name, "quicked") == 0) return QUICKED;
+    if (strcmp(name, "windowed") == 0) return WINDOWED;
+    if (strcmp(name, "banded") == 0) return BANDED;
+    if (strcmp(name, "hirschberg") == 0) return HIRSCHBERG;
+    fprintf(stderr, "Unknown algorithm '%s'\n", name);
+    exit(EXIT_FAILURE);
+}
+
+// Replays the operations over both sequences: they must consume them exactly, and their edits must add up to score
+static bool check_operations(const char *operations,
+                             const char *pattern, int pattern_len,
+                             const char *text, int text_len,
+                             int score) {
+    int v = 0, h = 0, edits = 0;
+    for (; *operations != '\0'; operations++) {
+        switch (*operations) {
+        case 'M':
+        case 'X':
+            if (v >= pattern_len || h >= text_len) return false;
+            if ((toupper(pattern[v]) == toupper(text[h])) != (*operations == 'M')) return false;
+            edits += (*operations == 'X');
+            v++;
+            h++;
+            break;
+        case 'I':
+            if (h >= text_len) return false;
+            edits++;
+            h++;
+            break;
+        case 'D':
+            if (v >= pattern_len) return false;
+            edits++;
+            v++;
+            break;
+        default:
+            return false;
+        }
+    }
+    return v == pattern_len && h == text_len && edits == score;
+}
+
+// Operations of an alignment, one character each. Streamed ones are appended by the callback
+typedef struct {
+    char *operations;
+    int length;
+    int capacity;
+} harness_operations_t;
+
+static void operations_append(harness_operations_t *ops, char op, int count) {
+    if (ops->length + count + 1 > ops->capacity) {
+        ops->capacity = 2 * (ops->length + count + 1);
+        ops->operations = realloc(ops->operations, ops->capacity);
+    }
+    memset(ops->operations + ops->length, op, count);
+    ops->length += count;
+    ops->operations[ops->length] = '\0';
+}
+
+static void operations_stream(const char *operations, int num_operations, void *user_data) {
+    for (int i = 0; i < num_operations; i++) {
+        operations_append((harness_operations_t *)user_data, operations[i], 1);
+    }
+}
+
+// Expands the CIGAR output of the last alignment (string, packed or streamed) into ops.
+// Returns false if there is none (only_score)
+static bool output_operations(const quicked_aligner_t *aligner, harness_operations_t *ops) {
+    if (aligner->params->only_score) return false;
+    if (aligner->params->cigar_callback != NULL) { // Already appended
+        operations_append(ops, 'M', 0);
+        return true;
+    }
+    ops->length = 0;
+    operations_append(ops, 'M', 0);
+    if (aligner->params->cigar_format == QUICKED_CIGAR_PACKED) {
+        static const char sam_operations[16] = {[1] = 'I', [2] = 'D', [7] = 'M', [8] = 'X'};
+        for (int i = 0; i < aligner->cigar_packed_length; i++) {
+            const char op = sam_operations[aligner->cigar_packed[i] & 0xf];
+            operations_append(ops, (op != 0) ? op : '?', aligner->cigar_packed[i] >> 4);
+        }
+        return true;
+    }
+    for (const char *cigar = aligner->cigar; cigar != NULL && *cigar != '\0';) {
+        char *op;
+        const long length = strtol(cigar, &op, 10);
+        operations_append(ops, *op, (int)length);
+        cigar = op + 1;
+    }
+    return true;
+}
+
+// Edit distance, or the semi-global one (free text gaps at both ends), by dynamic programming one text column at a time
+static int dp_distance(const char *pattern, int pattern_len,
+                       const char *text, int text_len,
+                       bool semiglobal) {
+    int *column = malloc((pattern_len + 1) * sizeof(int));
+    for (int v = 0; v <= pattern_len; v++) column[v] = v;
+    int best = column[pattern_len];
+    for (int h = 0; h < text_len; h++) {
+        int diagonal = column[0];
+        column[0] = semiglobal ? 0 : h + 1;
+        for (int v = 1; v <= pattern_len; v++) {
+            const int up = column[v];
+            int distance = diagonal + (toupper(pattern[v - 1]) != toupper(text[h]));
+            if (up + 1 < distance) distance = up + 1;
+            if (column[v - 1] + 1 < distance) distance = column[v - 1] + 1;
+            column[v] = distance;
+            diagonal = up;
+        }
+        if (column[pattern_len] < best) best = column[pattern_len];
+    }
+    if (!semiglobal) best = column[pattern_len];
+    free(column);
+    return best;
+}
+
+/*
+ * X-drop extension over the full dynamic programming matrix, scored as the library does:
+ * cell (v,h) scores v + h - 5 * D(v,h), the first best cell (by text column, then pattern row)
+ * is kept, and the extension stops after the first column with every cell more than xdrop below it
+ */
+static void xdrop_extension(const char *pattern, int pattern_len,
+                            const char *text, int text_len,
+                            int xdrop,
+                            int *pattern_end, int *text_end, int *distance) {
+    int *column = malloc((pattern_len + 1) * sizeof(int));
+    for (int v = 0; v <= pattern_len; v++) column[v] = v;
+    int best = 0;
+    *pattern_end = 0;
+    *text_end = 0;
+    *distance = 0;
+    for (int h = 1; h <= text_len; h++) {
+        int diagonal = column[0];
+        column[0] = h;
+        int column_best = h - 5 * h;
+        for (int v = 1; v <= pattern_len; v++) {
+            const int up = column[v];
+            int cell = diagonal + (toupper(pattern[v - 1]) != toupper(text[h - 1]));
+            if (up + 1 < cell) cell = up + 1;
+            if (column[v - 1] + 1 < cell) cell = column[v - 1] + 1;
+            column[v] = cell;
+            diagonal = up;
+            const int score = v + h - 5 * cell;
+            if (score > column_best) column_best = score;
+            if (score > best) {
+                best = score;
+                *pattern_end = v;
+                *text_end = h;
+                *distance = cell;
+            }
+        }
+        if (column_best < best - xdrop) break;
+    }
+    free(column);
+}
+
+// Next sequence of the dataset, without its '>'/'<' mark and line break. NULL at the end
+static char *read_sequence(FILE *file, char **line, size_t *size, int *length) {
+    ssize_t read = getline(line, size, file);
+    if (read <= 0) return NULL;
+    while (read > 0 && ((*line)[read - 1] == '\n' || (*line)[read - 1] == '\r')) read--;
+    (*line)[read] = '\0';
+    const int mark = (read > 0 && ((*line)[0] == '>' || (*line)[0] == '<'));
+    *length = (int)read - mark;
+    return *line + mark;
+}
+
+// Equal-length text (-H): the pattern with substitutions at random positions and, if shift, one base
+// deleted and another one inserted up to 100 bases further, which shifts the segment in between
+static void equal_length_text(const char *pattern, int pattern_len,
+                              int substitutions, bool shift,
+                              char *text) {
+    static const char bases[] = "ACGT";
+    memcpy(text, pattern, pattern_len);
+    for (int i = 0; i < substitutions; i++) {
+        const int position = rand() % pattern_len;
+        const char *base = strchr(bases, toupper(text[position]));
+        text[position] = bases[((base != NULL ? base - bases : 0) + 1 + rand() % 3) % 4];
+    }
+    if (shift && pattern_len > 1) {
+        const int begin = rand() % (pattern_len - 1);
+        const int max_shift = (pattern_len - 1 - begin < 100) ? pattern_len - 1 - begin : 100;
+        const int end = begin + 1 + rand() % max_shift;
+        memmove(text + begin, text + begin + 1, end - begin);
+        text[end] = bases[rand() % 4];
+    }
+}
+
+// Entry points of the library, all checked against quicked_align (the reference)
+typedef enum {
+    ENTRY_ASCII,    // quicked_align
+    ENTRY_ENCODED,  // quicked_align_encoded
+    ENTRY_PACKED,   // quicked_align_packed
+    ENTRY_COMPILED, // quicked_align_compiled
+} harness_entry_t;
+
+static harness_entry_t parse_entry(const char *name) {
+    if (strcmp(name, "encoded") == 0) return ENTRY_ENCODED;
+    if (strcmp(name, "packed") == 0) return ENTRY_PACKED;
+    if (strcmp(name, "compiled") == 0) return ENTRY_COMPILED;
+    fprintf(stderr, "Unknown entry point '%s'\n", name);
+    exit(EXIT_FAILURE);
+}
+
+static uint8_t encode_base(char base) {
+    switch (toupper(base)) {
+    case 'A': return 0;
+    case 'C': return 1;
+    case 'G': return 2;
+    case 'T': return 3;
+    default: return 4;
+    }
+}
+
+// 2-bit packed sequence and its N mask (see quicked_align_packed). Returns whether there are N bases
+static bool pack_sequence(const char *sequence, int length, uint64_t *packed, uint64_t *n_mask) {
+    memset(packed, 0, ((length + 31) / 32) * sizeof(uint64_t));
+    memset(n_mask, 0, ((length + 63) / 64) * sizeof(uint64_t));
+    bool n_bases = false;
+    for (int i = 0; i < length; i++) {
+        const uint64_t base = encode_base(sequence[i]);
+        if (base == 4) {
+            n_mask[i / 64] |= 1ULL << (i % 64);
+            n_bases = true;
+        } else {
+            packed[i / 32] |= base << (2 * (i % 32));
+        }
+    }
+    return n_bases;
+}
+
+// Aligns the pair through the entry point, compiled_pattern being pattern compiled (ENTRY_COMPILED)
+static quicked_status_t align_entry(quicked_aligner_t *aligner, harness_entry_t entry,
+                                    const quicked_pattern_t *compiled_pattern,
+                                    const char *pattern, int pattern_len,
+                                    const char *text, int text_len) {
+    quicked_status_t status = QUICKED_OK;
+    switch (entry) {
+    case ENTRY_ASCII:
+        return quicked_align(aligner, pattern, pattern_len, text, text_len);
+    case ENTRY_COMPILED:
+        return quicked_align_compiled(aligner, compiled_pattern, text, text_len);
+    case ENTRY_ENCODED: {
+        uint8_t *pattern_enc = malloc(pattern_len), *text_enc = malloc(text_len);
+        for (int i = 0; i < pattern_len; i++) pattern_enc[i] = encode_base(pattern[i]);
+        for (int i = 0; i < text_len; i++) text_enc[i] = encode_base(text[i]);
+        status = quicked_align_encoded(aligner, pattern_enc, pattern_len, text_enc, text_len);
+        free(pattern_enc);
+        free(text_enc);
+        break;
+    }
+    case ENTRY_PACKED: {
+        uint64_t *pattern_packed = malloc(((pattern_len + 31) / 32) * sizeof(uint64_t));
+        uint64_t *pattern_n_mask = malloc(((pattern_len + 63) / 64) * sizeof(uint64_t));
+        uint64_t *text_packed = malloc(((text_len + 31) / 32) * sizeof(uint64_t));
+        uint64_t *text_n_mask = malloc(((text_len + 63) / 64) * sizeof(uint64_t));
+        const bool pattern_n = pack_sequence(pattern, pattern_len, pattern_packed, pattern_n_mask);
+        const bool text_n = pack_sequence(text, text_len, text_packed, text_n_mask);
+        status = quicked_align_packed(aligner, pattern_packed, pattern_n ? pattern_n_mask : NULL, pattern_len,
+                                      text_packed, text_n ? text_n_mask : NULL, text_len);
+        free(pattern_packed);
+        free(pattern_n_mask);
+        free(text_packed);
+        free(text_n_mask);
+        break;
+    }
+    }
+    return status;
+}
+
+// Checks on top of the reference comparison
+typedef struct {
+    bool decision;          // max_score set from the reference score (-m)
+    int max_score_offset;
+    bool equal_length;      // Texts replaced by equal-length ones, checked against the dynamic programming (-H)
+    int substitutions;
+    bool compare_output;    // Operations compared with the CIGAR string of the reference (-c, -w, -E)
+    int flank;              // Pairs between shared flanks of this length, the reference aligns them bare (-w)
+    harness_entry_t entry;  // Entry point of the aligner (-E)
+    int n_bases;            // N bases put in each sequence (-N)
+} harness_checks_t;
+
+// Pattern and text between the same random flanks (-w), into flanked_pattern and flanked_text
+static void flank_pair(const char *pattern, int pattern_len,
+                       const char *text, int text_len,
+                       int flank,
+                       char *flanked_pattern, char *flanked_text) {
+    static const char bases[] = "ACGT";
+    for (int i = 0; i < flank; i++) {
+        flanked_pattern[i] = flanked_text[i] = bases[rand() % 4];
+        flanked_pattern[flank + pattern_len + i] = flanked_text[flank + text_len + i] = bases[rand() % 4];
+    }
+    memcpy(flanked_pattern + flank, pattern, pattern_len);
+    memcpy(flanked_text + flank, text, text_len);
+}
+
+// Whether ops are the expected ones between flank matches on either side
+static bool flanked_operations_equal(const harness_operations_t *ops, const harness_operations_t *expected, int flank) {
+    if (ops->length != expected->length + 2 * flank) return false;
+    for (int i = 0; i < flank; i++) {
+        if (ops->operations[i] != 'M' || ops->operations[ops->length - 1 - i] != 'M') return false;
+    }
+    return memcmp(ops->operations + flank, expected->operations, expected->length) == 0;
+}
+
+// Aligns the pair with aligner and reference, and reports whether aligner got the reference result
+static bool check_pair(quicked_aligner_t *aligner, quicked_aligner_t *reference,
+                       const harness_checks_t *checks, const quicked_pattern_t *compiled_pattern,
+                       harness_operations_t *output, harness_operations_t *expected,
+                       const char *pattern, int pattern_len,
+                       const char *text, int text_len,
+                       int pair) {
+    output->length = 0; // Streamed operations of this pair
+    if (aligner->params->xdrop >= 0) {
+        // The extended prefixes, aligned with their distance
+        check_status(align_entry(aligner, checks->entry, compiled_pattern, pattern, pattern_len, text, text_len));
+        int pattern_end, text_end, distance;
+        xdrop_extension(pattern, pattern_len, text, text_len, aligner->params->xdrop, &pattern_end, &text_end, &distance);
+        // Only its distance is an upper bound (from the band of the extension)
+        const bool inaccurate = aligner->params->only_score ? aligner->score < distance : aligner->score != distance;
+        if (aligner->pattern_end != pattern_end || aligner->text_end != text_end || inaccurate) {
+            printf("INACCURATE SCORE (pair %d): extended to (%d,%d) with score %d, expected (%d,%d) with %d\n", pair,
+                   aligner->pattern_end, aligner->text_end, aligner->score, pattern_end, text_end, distance);
+            return false;
+        }
+        if (output_operations(aligner, output) &&
+            !check_operations(output->operations, pattern, pattern_end, text, text_end, aligner->score)) {
+            printf("INACCURATE SCORE (pair %d): the CIGAR does not align the extension with score %d\n", pair, aligner->score);
+            return false;
+        }
+        return true;
+    }
+    if (aligner->params->ends_free) {
+        // The semi-global distance, over a text span that it is the (global) distance to
+        check_status(align_entry(aligner, checks->entry, compiled_pattern, pattern, pattern_len, text, text_len));
+        const int expected = dp_distance(pattern, pattern_len, text, text_len, true);
+        if (aligner->score != expected) {
+            printf("INACCURATE SCORE (pair %d): got %d, expected %d\n", pair, aligner->score, expected);
+            return false;
+        }
+        if (aligner->params->algo == BANDED && aligner->params->only_score) return true; // The span is not located
+        const int begin = aligner->text_begin, end = aligner->text_end;
+        if (begin < 0 || begin > end || end > text_len) {
+            printf("INACCURATE SCORE (pair %d): text span [%d,%d) out of the text\n", pair, begin, end);
+            return false;
+        }
+        int span_distance = pattern_len;
+        if (end > begin) {
+            check_status(quicked_align(reference, pattern, pattern_len, text + begin, end - begin));
+            span_distance = reference->score;
+        }
+        if (span_distance != expected) {
+            printf("INACCURATE SCORE (pair %d): text span [%d,%d) at distance %d, expected %d\n", pair, begin, end, span_distance, expected);
+            return false;
+        }
+        if (output_operations(aligner, output) &&
+            !check_operations(output->operations, pattern, pattern_len, text + begin, end - begin, aligner->score)) {
+            printf("INACCURATE SCORE (pair %d): the CIGAR does not align the text span with score %d\n", pair, aligner->score);
+            return false;
+        }
+        return true;
+    }
+
+    const int flank = checks->flank; // The reference aligns the pair without its flanks
+    check_status(quicked_align(reference, pattern + flank, pattern_len - 2 * flank, text + flank, text_len - 2 * flank));
+    if (checks->decision) {
+        // Above max_score iff the distance is; within it, the score lies between the distance and max_score
+        const int max_score = reference->score + checks->max_score_offset;
+        if (max_score < 0) return true;
+        aligner->params->max_score = max_score;
+        const quicked_status_t status = align_entry(aligner, checks->entry, compiled_pattern, pattern, pattern_len, text, text_len);
+        check_status(status);
+        const bool above = reference->score > max_score;
+        if ((status == QUICKED_ABOVE_MAX_SCORE) != above) {
+            printf("INACCURATE SCORE (pair %d): distance %d, max_score %d, %s\n", pair, reference->score, max_score,
+                   above ? "not reported above" : "reported above");
+            return false;
+        }
+        if (above) return true;
+        if (aligner->score < reference->score || aligner->score > max_score ||
+            (!aligner->params->only_score && aligner->score != reference->score)) {
+            printf("INACCURATE SCORE (pair %d): got %d, distance %d, max_score %d\n", pair, aligner->score, reference->score, max_score);
+            return false;
+        }
+    } else {
+        check_status(align_entry(aligner, checks->entry, compiled_pattern, pattern, pattern_len, text, text_len));
+        // Equal lengths: the reference may take the same Hamming shortcut
+        const int expected = checks->equal_length ? dp_distance(pattern, pattern_len, text, text_len, false) : reference->score;
+        // Split at anchors: an upper bound, a few edits above the distance at most (see anchor_length)
+        const bool anchored = aligner->stats.anchors > 0;
+        if (anchored ? (aligner->score < expected || aligner->score > expected + expected / 100) : aligner->score != expected) {
+            printf("INACCURATE SCORE (pair %d): got %d, expected %d\n", pair, aligner->score, expected);
+            return false;
+        }
+    }
+    // Global alignments span both sequences, trimmed or not
+    if (aligner->pattern_end != pattern_len || aligner->text_begin != 0 || aligner->text_end != text_len) {
+        printf("INACCURATE SCORE (pair %d): aligned up to pattern %d and text [%d,%d), expected %d and [0,%d)\n", pair,
+               aligner->pattern_end, aligner->text_begin, aligner->text_end, pattern_len, text_len);
+        return false;
+    }
+    if (!output_operations(aligner, output)) return true;
+    if (!check_operations(output->operations, pattern, pattern_len, text, text_len, aligner->score)) {
+        printf("INACCURATE SCORE (pair %d): the CIGAR does not align the sequences with score %d\n", pair, aligner->score);
+        return false;
+    }
+    if (checks->compare_output && !checks->decision && output_operations(reference, expected) &&
+        !flanked_operations_equal(output, expected, flank)) {
+        printf("INACCURATE SCORE (pair %d): the operations differ from the CIGAR string of the reference\n", pair);
+        return false;
+    }
+    return true;
+}
+
+static int run_dataset(quicked_params_t *params, const harness_checks_t *checks, const char *dataset) {
+    FILE *file = fopen(dataset, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Could not open '%s'\n", dataset);
+        exit(EXIT_FAILURE);
+    }
+
+    // The reference runs the same alignment on one thread, without anchors nor memory budget, and computes the exact distance
+    quicked_params_t reference_params = *params;
+    reference_params.num_threads = 1;
+    reference_params.anchor_length = 0;
+    reference_params.memory_budget = checks->compare_output ? params->memory_budget : 0; // Same leaves, same operations
+    reference_params.force_scalar = false;
+    reference_params.allocator_pool = NULL;
+    reference_params.cigar_format = QUICKED_CIGAR_STRING;
+    reference_params.cigar_callback = NULL;
+    reference_params.max_score = -1;
+    if (params->ends_free) { // Global distances of the text spans
+        reference_params.algo = QUICKED;
+        reference_params.ends_free = false;
+        reference_params.only_score = true;
+    }
+
+    harness_operations_t output = {0}, expected = {0};
+    params->cigar_callback_data = &output;
+
+    quicked_aligner_t aligner, reference;
+    check_status(quicked_new(&aligner, params));
+    check_status(quicked_new(&reference, &reference_params));
+
+    char *pattern_line = NULL, *text_line = NULL, *equal_text = NULL, *flanked_pattern = NULL, *flanked_text = NULL;
+    size_t pattern_size = 0, text_size = 0;
+    char *previous_text = NULL;
+    int pattern_len, text_len, previous_text_len = 0;
+    int pairs = 0, failures = 0;
+    char *pattern, *text;
+    while ((pattern = read_sequence(file, &pattern_line, &pattern_size, &pattern_len)) != NULL &&
+           (text = read_sequence(file, &text_line, &text_size, &text_len)) != NULL) {
+        if (params->xdrop >= 0) {
+            for (int i = text_len / 2, j = text_len - 1; i < j; i++, j--) {
+                const char base = text[i];
+                text[i] = text[j];
+                text[j] = base;
+            }
+        }
+        if (checks->equal_length) {
+            const int substitutions = checks->substitutions + pairs % 9 - 4;
+            equal_text = realloc(equal_text, pattern_len + 1);
+            equal_length_text(pattern, pattern_len, (substitutions > 0) ? substitutions : 0, pairs % 2 == 1, equal_text);
+            text = equal_text;
+            text_len = pattern_len;
+        }
+        for (int i = 0; i < checks->n_bases; i++) {
+            pattern[rand() % pattern_len] = 'N';
+            text[rand() % text_len] = 'N';
+        }
+        if (checks->flank > 0) {
+            flanked_pattern = realloc(flanked_pattern, pattern_len + 2 * checks->flank);
+            flanked_text = realloc(flanked_text, text_len + 2 * checks->flank);
+            flank_pair(pattern, pattern_len, text, text_len, checks->flank, flanked_pattern, flanked_text);
+            pattern = flanked_pattern;
+            text = flanked_text;
+            pattern_len += 2 * checks->flank;
+            text_len += 2 * checks->flank;
+        }
+        quicked_pattern_t *compiled_pattern = NULL;
+        if (checks->entry == ENTRY_COMPILED) {
+            check_status(quicked_pattern_compile(&aligner, &compiled_pattern, pattern, pattern_len));
+        }
+        failures += !check_pair(&aligner, &reference, checks, compiled_pattern, &output, &expected,
+                                pattern, pattern_len, text, text_len, pairs);
+        if (compiled_pattern != NULL && checks->flank == 0) {
+            // The same compiled pattern against another text
+            if (pairs > 0) {
+                failures += !check_pair(&aligner, &reference, checks, compiled_pattern, &output, &expected,
+                                        pattern, pattern_len, previous_text, previous_text_len, pairs);
+            }
+            previous_text = realloc(previous_text, text_len);
+            memcpy(previous_text, text, text_len);
+            previous_text_len = text_len;
+        }
+        check_status(quicked_pattern_free(compiled_pattern));
+        pairs++;
+    }
+    printf("Checked %d pairs, %d failed\n", pairs, failures);
+
+    free(pattern_line);
+    free(text_line);
+    free(equal_text);
+    free(flanked_pattern);
+    free(flanked_text);
+    free(previous_text);
+    free(output.operations);
+    free(expected.operations);
+    fclose(file);
+    check_status(quicked_free(&aligner));
+    check_status(quicked_free(&reference));
+
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Pairs that score-only QUICKED batches align on the lane kernels (up to 512 bases), which only count their cells
+#define BATCH_LANE_MAX_LENGTH 512
+
+static bool batch_lane_pair(const quicked_aligner_t *reference, int pattern_len, int text_len) {
+    const quicked_params_t *params = reference->params;
+    return params->only_score && params->algo == QUICKED && !params->ends_free && params->xdrop < 0 &&
+           reference->simd >= QUICKED_SIMD_AVX2 &&
+           pattern_len <= BATCH_LANE_MAX_LENGTH && text_len <= BATCH_LANE_MAX_LENGTH;
+}
+
+static int run_batch(quicked_params_t *params, int threads, const char *dataset) {
+    FILE *file = fopen(dataset, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Could not open '%s'\n", dataset);
+        exit(EXIT_FAILURE);
+    }
+
+    // The whole dataset, every other pair cut down to the lane kernels
+    char *pattern_line = NULL, *text_line = NULL;
+    size_t pattern_size = 0, text_size = 0;
+    char **patterns = NULL, **texts = NULL;
+    int *pattern_lens = NULL, *text_lens = NULL;
+    int pattern_len, text_len;
+    int pairs = 0, capacity = 0;
+    char *pattern, *text;
+    while ((pattern = read_sequence(file, &pattern_line, &pattern_size, &pattern_len)) != NULL &&
+           (text = read_sequence(file, &text_line, &text_size, &text_len)) != NULL) {
+        if (pairs == capacity) {
+            capacity = 2 * capacity + 16;
+            patterns = realloc(patterns, capacity * sizeof(char *));
+            texts = realloc(texts, capacity * sizeof(char *));
+            pattern_lens = realloc(pattern_lens, capacity * sizeof(int));
+            text_lens = realloc(text_lens, capacity * sizeof(int));
+        }
+        if (pairs % 2 == 1) {
+            const int pattern_max = 1 + rand() % BATCH_LANE_MAX_LENGTH, text_max = 1 + rand() % BATCH_LANE_MAX_LENGTH;
+            pattern_len = (pattern_len < pattern_max) ? pattern_len : pattern_max;
+            text_len = (text_len < text_max) ? text_len : text_max;
+        }
+        patterns[pairs] = strndup(pattern, pattern_len);
+        texts[pairs] = strndup(text, text_len);
+        pattern_lens[pairs] = pattern_len;
+        text_lens[pairs] = text_len;
+        pairs++;
+    }
+    free(pattern_line);
+    free(text_line);
+    fclose(file);
+
+    // The reference aligns the pairs one by one (without the pool of -P), and adds up the statistics the batch
+    // should merge
+    quicked_params_t reference_params = *params;
+    reference_params.allocator_pool = NULL;
+    quicked_aligner_t reference;
+    check_status(quicked_new(&reference, &reference_params));
+    int *expected_scores = malloc(pairs * sizeof(int));
+    char **expected_cigars = malloc(pairs * sizeof(char *));
+    quicked_stats_aggregate_t expected_stats;
+    quicked_stats_aggregate_reset(&expected_stats);
+    for (int i = 0; i < pairs; i++) {
+        check_status(quicked_align(&reference, patterns[i], pattern_lens[i], texts[i], text_lens[i]));
+        expected_scores[i] = reference.score;
+        const bool cigar = !params->only_score && params->cigar_format != QUICKED_CIGAR_PACKED;
+        expected_cigars[i] = cigar ? strdup(reference.cigar) : NULL;
+        if (batch_lane_pair(&reference, pattern_lens[i], text_lens[i])) {
+            const quicked_stats_t lane_stats = {
+                .bound_stage = QUICKED_STAGE_NONE,
+                .final_cutoff = -1,
+                .cells = (uint64_t)((pattern_lens[i] + 63) / 64) * 64 * text_lens[i],
+            };
+            quicked_stats_aggregate_add(&expected_stats, &lane_stats);
+        } else {
+            quicked_stats_aggregate_add(&expected_stats, &reference.stats);
+        }
+    }
+    check_status(quicked_free(&reference));
+
+    // On a pool of the caller, a second batch runs on the segments left by the first one
+    int *scores = malloc(pairs * sizeof(int));
+    char **cigars = malloc(pairs * sizeof(char *));
+    const int batches = (params->allocator_pool != NULL) ? 2 : 1;
+    int failures = 0;
+    for (int batch = 0; batch < batches; batch++) {
+        quicked_stats_aggregate_t stats;
+        quicked_stats_aggregate_reset(&stats);
+        check_status(quicked_align_batch(params, threads, (const char **)patterns, pattern_lens,
+                                         (const char **)texts, text_lens, pairs, scores, cigars, &stats));
+        for (int i = 0; i < pairs; i++) {
+            if (scores[i] != expected_scores[i]) {
+                printf("INACCURATE SCORE (pair %d): got %d in the batch, expected %d\n", i, scores[i], expected_scores[i]);
+                failures++;
+            } else if ((cigars[i] == NULL) != (expected_cigars[i] == NULL) ||
+                       (cigars[i] != NULL && strcmp(cigars[i], expected_cigars[i]) != 0)) {
+                printf("INACCURATE SCORE (pair %d): the CIGAR of the batch differs from quicked_align\n", i);
+                failures++;
+            }
+            free(cigars[i]);
+        }
+        if (memcmp(&stats, &expected_stats, sizeof(stats)) != 0) {
+            printf("INACCURATE SCORE: the merged statistics of the batch (%llu alignments, %llu cells) differ from "
+                   "those of quicked_align (%llu alignments, %llu cells)\n",
+                   (unsigned long long)stats.alignments, (unsigned long long)stats.cells,
+                   (unsigned long long)expected_stats.alignments, (unsigned long long)expected_stats.cells);
+            failures++;
+        }
+    }
+    printf("Checked %d pairs in %d batches, %d failed\n", pairs, batches, failures);
+
+    for (int i = 0; i < pairs; i++) {
+        free(patterns[i]);
+        free(texts[i]);
+        free(expected_cigars[i]);
+    }
+    free(patterns);
+    free(texts);
+    free(pattern_lens);
+    free(text_lens);
+    free(expected_scores);
+    free(expected_cigars);
+    free(scores);
+    free(cigars);
+
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[]) {
 
     quicked_aligner_t aligner;
     quicked_status_t status;
     quicked_params_t params = quicked_default_params();
+    const char *dataset = NULL;
+    harness_checks_t checks = {0};
+    int batch_threads = 0;
+    mm_allocator_pool_t *allocator_pool = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "a:b:sSt:k:M:c:m:eH:w:E:N:B:P:x:i:")) != -1) {
+        switch (opt) {
+        case 'a': params.algo = parse_algo(optarg); break;
+        case 'b': params.bandwidth = atoi(optarg); break;
+        case 's': params.only_score = true; break;
+        case 't': params.num_threads = atoi(optarg); break;
+        case 'k': params.anchor_length = atoi(optarg); break;
+        case 'M': params.memory_budget = strtoull(optarg, NULL, 10); break;
+        case 'c':
+            if (strcmp(optarg, "packed") == 0) {
+                params.cigar_format = QUICKED_CIGAR_PACKED;
+            } else if (strcmp(optarg, "stream") == 0) {
+                params.cigar_callback = operations_stream;
+            } else {
+                fprintf(stderr, "Unknown output '%s'\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            checks.compare_output = true;
+            break;
+        case 'm': checks.decision = true; checks.max_score_offset = atoi(optarg); break;
+        case 'e': params.ends_free = true; break;
+        case 'H': checks.equal_length = true; checks.substitutions = atoi(optarg); break;
+        case 'S': params.force_scalar = true; break;
+        case 'w': checks.flank = atoi(optarg); checks.compare_output = true; break;
+        case 'E': checks.entry = parse_entry(optarg); checks.compare_output = true; break;
+        case 'N': checks.n_bases = atoi(optarg); break;
+        case 'B': batch_threads = atoi(optarg); break;
+        case 'P':
+            allocator_pool = mm_allocator_pool_new(strtoull(optarg, NULL, 10), 8);
+            params.allocator_pool = allocator_pool;
+            break;
+        case 'x': params.xdrop = atoi(optarg); break;
+        case 'i': dataset = optarg; break;
+        default: exit(EXIT_FAILURE);
+        }
+    }
+
+    if (dataset != NULL) {
+        const int result = (batch_threads > 0) ? run_batch(&params, batch_threads, dataset) : run_dataset(&params, &checks, dataset);
+        if (allocator_pool != NULL) mm_allocator_pool_delete(allocator_pool);
+        return result;
+    }
+    if (argc - optind < 2) {
+        fprintf(stderr, "Usage: %s [options] <pattern> <text> [expected score] | [options] -i <dataset>\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    const char *pattern = argv[optind];
+    const char *text = argv[optind + 1];
 
     status = quicked_new(&aligner, &params);
     if (quicked_check_error(status)) {
@@ -39,7 +784,7 @@ int main(int argc, char *argv[]) { // Usage: ./quicked_harness <text> <pattern>
         exit(EXIT_FAILURE);
     }
 
-    status = quicked_align(&aligner, argv[1], strlen(argv[1]), argv[2], strlen(argv[2]));
+    status = quicked_align(&aligner, pattern, strlen(pattern), text, strlen(text));
     if (quicked_check_error(status)) {
         fprintf(stderr, "%s", quicked_status_msg(status));
         exit(EXIT_FAILURE);
@@ -54,13 +799,13 @@ int main(int argc, char *argv[]) { // Usage: ./quicked_harness <text> <pattern>
         exit(EXIT_FAILURE);
     }
 
-    if (argc == 4) { // If expected score is provided, check if it matches
-        printf("Expected score: %d", atoi(argv[3]));
-        if (score != atoi(argv[3])) {
+    if (argc - optind == 3) { // If expected score is provided, check if it matches
+        printf("Expected score: %d", atoi(argv[optind + 2]));
+        if (score != atoi(argv[optind + 2])) {
             printf("<FAIL>\n");
             exit(EXIT_FAILURE);
         }
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -2,7 +2,9 @@
 
 # This test generate N random sequence pairs of length L and an average error E using generate_dataset tool,
 #   and pass them to quicked_harness or to align_benchmark.
-# quicked_harness does not check for correctness, only for crashes.
+# quicked_harness does not check for correctness, only for crashes, unless it is given options (after tool):
+#   then it aligns the whole dataset with them and checks each pair against a reference run.
+# DATASET_OPTIONS (environment) are passed to generate_dataset (e.g. "--length-diff 1.5").
 
 # --- Cleanup ---
 
@@ -19,6 +21,7 @@ L=$1
 N=$2
 E=$3
 tool=$4
+shift $(( $# < 4 ? $# : 4 ))
 
 if [ -z "$N" ]; then
     N=10
@@ -36,13 +39,17 @@ fi
 
 echo "Generating $N random sequence pairs of length $L"
 echo "$BIN_DIR"
-"$BIN_DIR"/generate_dataset -l "$L" -n "$N" -e "$E" > "$tempdir/random_dataset.seq"
+# shellcheck disable=SC2086 # DATASET_OPTIONS holds several arguments
+"$BIN_DIR"/generate_dataset -l "$L" -n "$N" -e "$E" $DATASET_OPTIONS > "$tempdir/random_dataset.seq"
 
 echo "Trimming sequences"
 # Remove the first character of each line in random_dataset.seq
 sed -i 's/^.//' "$tempdir/random_dataset.seq"
 
-if [ "$tool" = "quicked_harness" ]; then
+if [ "$tool" = "quicked_harness" ] && [ $# -gt 0 ]; then
+    echo "Running quicked_harness $*"
+    "$BIN_DIR"/quicked_harness "$@" -i "$tempdir/random_dataset.seq"
+elif [ "$tool" = "quicked_harness" ]; then
     # For each sequence pair in random_dataset.seq, run ./quicked_harness seq1 seq2
     # If quicked_harness crashes, abort the test with a non-zero exit code
     echo "Running quicked_harness"